@@ -0,0 +1,1779 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file awa_standin.c
+ * @brief Stand-in for libawa, linked into the benchmark build of the gateway. Sessions talk to
+ *        the stand-in daemons of the benchmark driver with the protocol in standin_protocol.h,
+ *        over a request socket and a notify socket, both UDP like the real Awa IPC. Each session
+ *        is only used from one thread at a time, as with the real library.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <errno.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "awa/client.h"
+#include "awa/server.h"
+#include "standin_protocol.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define MAX_OBJECTS				(16)
+#define MAX_RESOURCES			(8)
+#define MAX_PATHS				(64)
+#define MAX_OBSERVATIONS		(4096)
+#define MAX_PENDING				(256)
+#define NOTIFICATION_SIZE		(160)
+#define CONNECT_TIMEOUT			(1000)
+#define NOTIFY_BUFFER_SIZE		(4 * 1024 * 1024)
+#define MS_PER_SECOND			(1000)
+#define NS_PER_MS				(1000000)
+#define WORD_SEPARATORS			" \n"
+//! @endcond
+
+/***************************************************************************************************
+ * Typedef
+ **************************************************************************************************/
+
+struct _AwaResourceDefinition
+{
+	/*@{*/
+	AwaResourceID id; /**< resource ID */
+	AwaResourceType type; /**< resource type */
+	/*@}*/
+};
+
+struct _AwaObjectDefinition
+{
+	/*@{*/
+	AwaObjectID id; /**< object ID */
+	int maximumInstances; /**< most instances the object can have */
+	unsigned int numResources; /**< number of resources */
+	AwaResourceDefinition resources[MAX_RESOURCES]; /**< resource definitions */
+	/*@}*/
+};
+
+struct _AwaPathResult
+{
+	/*@{*/
+	AwaError error; /**< result of the operation on one path */
+	/*@}*/
+};
+
+struct _AwaChangeSet
+{
+	/*@{*/
+	const char *clientID; /**< client the change comes from */
+	const char *path; /**< changed resource */
+	AwaInteger value; /**< new value */
+	/*@}*/
+};
+
+struct _AwaPathIterator
+{
+	/*@{*/
+	const char *path; /**< the one path of a change set */
+	bool started; /**< true once Next was called */
+	/*@}*/
+};
+
+struct _AwaClientIterator
+{
+	/*@{*/
+	char (*clients)[STANDIN_NAME_SIZE]; /**< client names, owned by the iterator */
+	unsigned int count; /**< number of clients */
+	unsigned int next; /**< index of the next client */
+	/*@}*/
+};
+
+/**
+ * A structure to contain the sockets and cached definitions of one session.
+ */
+typedef struct
+{
+	/*@{*/
+	struct sockaddr_in address; /**< daemon address */
+	bool hasAddress; /**< true once SetIPCAsUDP was called */
+	int requestFd; /**< connected to the daemon, -1 while disconnected */
+	int notifyFd; /**< receives notifications, -1 while disconnected */
+	unsigned int nextID; /**< request ID */
+	AwaObjectDefinition objects[MAX_OBJECTS]; /**< objects defined on the daemon */
+	unsigned int numObjects; /**< number of objects */
+	char buffer[STANDIN_DATAGRAM_SIZE]; /**< request and reply */
+	/*@}*/
+}Connection;
+
+/**
+ * A structure to contain the objects added to a define operation.
+ */
+typedef struct
+{
+	/*@{*/
+	Connection *connection; /**< session connection */
+	AwaObjectDefinition objects[MAX_OBJECTS]; /**< objects to define */
+	unsigned int numObjects; /**< number of objects */
+	/*@}*/
+}DefineOperation;
+
+struct _AwaServerSession
+{
+	/*@{*/
+	Connection connection; /**< sockets */
+	AwaServerObservation *observations[MAX_OBSERVATIONS]; /**< observations in place */
+	unsigned int numObservations; /**< number of observations */
+	char pending[MAX_PENDING][NOTIFICATION_SIZE]; /**< received notifications */
+	unsigned int numPending; /**< number of pending notifications */
+	AwaServerClientRegisterEventCallback registerCallback; /**< called on REGISTER */
+	void *registerContext; /**< passed to registerCallback */
+	AwaServerClientUpdateEventCallback updateCallback; /**< called on UPDATE */
+	void *updateContext; /**< passed to updateCallback */
+	AwaServerClientDeregisterEventCallback deregisterCallback; /**< called on DEREGISTER */
+	void *deregisterContext; /**< passed to deregisterCallback */
+	/*@}*/
+};
+
+struct _AwaServerClientRegisterEvent
+{
+	/*@{*/
+	const char *clientID; /**< registered client */
+	/*@}*/
+};
+
+struct _AwaServerClientUpdateEvent
+{
+	/*@{*/
+	const char *clientID; /**< updated client */
+	/*@}*/
+};
+
+struct _AwaServerClientDeregisterEvent
+{
+	/*@{*/
+	const char *clientID; /**< deregistered client */
+	/*@}*/
+};
+
+struct _AwaServerDefineOperation
+{
+	/*@{*/
+	DefineOperation define; /**< objects to define */
+	/*@}*/
+};
+
+struct _AwaServerListClientsOperation
+{
+	/*@{*/
+	AwaServerSession *session; /**< session */
+	char (*clients)[STANDIN_NAME_SIZE]; /**< listed clients */
+	unsigned int count; /**< number of clients */
+	/*@}*/
+};
+
+struct _AwaServerWriteResponse
+{
+	/*@{*/
+	const AwaServerWriteOperation *operation; /**< operation the response belongs to */
+	char clientID[STANDIN_NAME_SIZE]; /**< client written by the last Perform */
+	/*@}*/
+};
+
+struct _AwaServerWriteOperation
+{
+	/*@{*/
+	AwaServerSession *session; /**< session */
+	char paths[MAX_PATHS][STANDIN_PATH_SIZE]; /**< resources to write */
+	AwaBoolean values[MAX_PATHS]; /**< value to write to each resource */
+	AwaPathResult results[MAX_PATHS]; /**< result of each resource of the last Perform */
+	AwaServerWriteResponse response; /**< response of the last Perform */
+	unsigned int count; /**< number of values added */
+	/*@}*/
+};
+
+struct _AwaServerObservation
+{
+	/*@{*/
+	char clientID[STANDIN_NAME_SIZE]; /**< observed client */
+	char path[STANDIN_PATH_SIZE]; /**< observed resource */
+	AwaServerObservationCallback callback; /**< called on NOTIFY */
+	void *context; /**< passed to callback */
+	AwaServerSession *session; /**< session the observation is in place on, or NULL */
+	/*@}*/
+};
+
+struct _AwaServerObserveResponse
+{
+	/*@{*/
+	const AwaServerObserveOperation *operation; /**< operation the response belongs to */
+	const char *clientID; /**< client of the response */
+	/*@}*/
+};
+
+struct _AwaServerObserveOperation
+{
+	/*@{*/
+	AwaServerSession *session; /**< session */
+	AwaServerObservation *observations[MAX_PATHS]; /**< observations added */
+	AwaPathResult results[MAX_PATHS]; /**< result of each observation */
+	AwaServerObserveResponse responses[MAX_PATHS]; /**< response of each observation's client */
+	unsigned int count; /**< number of observations */
+	/*@}*/
+};
+
+struct _AwaClientSession
+{
+	/*@{*/
+	Connection connection; /**< sockets */
+	/*@}*/
+};
+
+struct _AwaClientDefineOperation
+{
+	/*@{*/
+	DefineOperation define; /**< objects to define */
+	/*@}*/
+};
+
+struct _AwaClientGetResponse
+{
+	/*@{*/
+	const AwaClientGetOperation *operation; /**< operation the response belongs to */
+	/*@}*/
+};
+
+struct _AwaClientGetOperation
+{
+	/*@{*/
+	AwaClientSession *session; /**< session */
+	char paths[MAX_PATHS][STANDIN_PATH_SIZE]; /**< paths to get */
+	bool present[MAX_PATHS]; /**< whether each path exists */
+	unsigned int count; /**< number of paths */
+	AwaClientGetResponse response; /**< response, valid after perform */
+	/*@}*/
+};
+
+struct _AwaClientSetResponse
+{
+	/*@{*/
+	const AwaClientSetOperation *operation; /**< operation the response belongs to */
+	/*@}*/
+};
+
+struct _AwaClientSetOperation
+{
+	/*@{*/
+	AwaClientSession *session; /**< session */
+	char createPath[STANDIN_PATH_SIZE]; /**< instance to create, empty if none */
+	char path[STANDIN_PATH_SIZE]; /**< resource to set */
+	AwaBoolean value; /**< value to set */
+	bool hasValue; /**< true once a value was added */
+	AwaPathResult result; /**< result for path */
+	AwaClientSetResponse response; /**< response, valid after perform */
+	/*@}*/
+};
+
+struct _AwaClientChangeSubscription
+{
+	/*@{*/
+	char path[STANDIN_PATH_SIZE]; /**< subscribed path */
+	AwaClientSubscriptionCallback callback; /**< never called, the stand-in daemon has no changes */
+	void *context; /**< passed to callback */
+	/*@}*/
+};
+
+struct _AwaClientSubscribeOperation
+{
+	/*@{*/
+	AwaClientSession *session; /**< session */
+	AwaClientChangeSubscription *subscriptions[MAX_PATHS]; /**< subscriptions added */
+	unsigned int count; /**< number of subscriptions */
+	/*@}*/
+};
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+const char *AwaError_ToString(AwaError error)
+{
+	static const char *strings[] =
+	{
+		"AwaError_Success", "AwaError_Unspecified", "AwaError_IPCError", "AwaError_Timeout",
+		"AwaError_Response", "AwaError_PathNotFound", "AwaError_PathInvalid",
+		"AwaError_SessionNotConnected", "AwaError_SessionInvalid", "AwaError_OperationInvalid",
+		"AwaError_ClientNotFound", "AwaError_DefinitionInvalid"
+	};
+
+	if ((unsigned int)error < sizeof(strings) / sizeof(strings[0]))
+	{
+		return strings[error];
+	}
+	return "AwaError_Unknown";
+}
+
+AwaError AwaAPI_MakeObjectPath(char *path, size_t pathSize, AwaObjectID objectID)
+{
+	return snprintf(path, pathSize, "/%d", objectID) < (int)pathSize ? AwaError_Success :
+			AwaError_PathInvalid;
+}
+
+AwaError AwaAPI_MakeObjectInstancePath(char *path, size_t pathSize, AwaObjectID objectID,
+		AwaObjectInstanceID objectInstanceID)
+{
+	return snprintf(path, pathSize, "/%d/%d", objectID, objectInstanceID) < (int)pathSize ?
+			AwaError_Success : AwaError_PathInvalid;
+}
+
+AwaObjectDefinition *AwaObjectDefinition_New(AwaObjectID objectID, const char *objectName,
+		int minimumInstances, int maximumInstances)
+{
+	AwaObjectDefinition *definition = calloc(1, sizeof(*definition));
+
+	if (definition != NULL)
+	{
+		definition->id = objectID;
+		definition->maximumInstances = maximumInstances;
+	}
+	return definition;
+}
+
+void AwaObjectDefinition_Free(AwaObjectDefinition **objectDefinition)
+{
+	free(*objectDefinition);
+	*objectDefinition = NULL;
+}
+
+/**
+ * @brief Add a resource to an object definition.
+ * @param *definition object definition.
+ * @param id resource ID.
+ * @param type resource type.
+ * @return AwaError_Success, or AwaError_DefinitionInvalid if the object is full.
+ */
+static AwaError AddResource(AwaObjectDefinition *definition, AwaResourceID id,
+		AwaResourceType type)
+{
+	if (definition == NULL || definition->numResources == MAX_RESOURCES)
+	{
+		return AwaError_DefinitionInvalid;
+	}
+	definition->resources[definition->numResources].id = id;
+	definition->resources[definition->numResources].type = type;
+	definition->numResources++;
+	return AwaError_Success;
+}
+
+AwaError AwaObjectDefinition_AddResourceDefinitionAsInteger(AwaObjectDefinition *objectDefinition,
+		AwaResourceID resourceID, const char *resourceName, bool isMandatory,
+		AwaResourceOperations operations, AwaInteger defaultValue)
+{
+	return AddResource(objectDefinition, resourceID, AwaResourceType_Integer);
+}
+
+AwaError AwaObjectDefinition_AddResourceDefinitionAsBoolean(AwaObjectDefinition *objectDefinition,
+		AwaResourceID resourceID, const char *resourceName, bool isMandatory,
+		AwaResourceOperations operations, AwaBoolean *defaultValue)
+{
+	return AddResource(objectDefinition, resourceID, AwaResourceType_Boolean);
+}
+
+const AwaResourceDefinition *AwaObjectDefinition_GetResourceDefinition(
+		const AwaObjectDefinition *objectDefinition, AwaResourceID resourceID)
+{
+	unsigned int i;
+
+	for (i = 0; objectDefinition != NULL && i < objectDefinition->numResources; i++)
+	{
+		if (objectDefinition->resources[i].id == resourceID)
+		{
+			return &objectDefinition->resources[i];
+		}
+	}
+	return NULL;
+}
+
+AwaError AwaPathResult_GetError(const AwaPathResult *result)
+{
+	return result != NULL ? result->error : AwaError_PathNotFound;
+}
+
+const char *AwaChangeSet_GetClientID(const AwaChangeSet *changeSet)
+{
+	return changeSet->clientID;
+}
+
+AwaPathIterator *AwaChangeSet_NewPathIterator(const AwaChangeSet *changeSet)
+{
+	AwaPathIterator *iterator = calloc(1, sizeof(*iterator));
+
+	if (iterator != NULL)
+	{
+		iterator->path = changeSet->path;
+	}
+	return iterator;
+}
+
+AwaError AwaChangeSet_GetValueAsIntegerPointer(const AwaChangeSet *changeSet, const char *path,
+		const AwaInteger **value)
+{
+	if (strcmp(path, changeSet->path) != 0)
+	{
+		return AwaError_PathNotFound;
+	}
+	*value = &changeSet->value;
+	return AwaError_Success;
+}
+
+bool AwaPathIterator_Next(AwaPathIterator *iterator)
+{
+	bool first = !iterator->started;
+
+	iterator->started = true;
+	return first;
+}
+
+const char *AwaPathIterator_Get(const AwaPathIterator *iterator)
+{
+	return iterator->path;
+}
+
+void AwaPathIterator_Free(AwaPathIterator **iterator)
+{
+	free(*iterator);
+	*iterator = NULL;
+}
+
+/**
+ * @brief Create a client iterator over a copy of client names.
+ * @param clients names to copy.
+ * @param count number of names.
+ * @return iterator, or NULL if out of memory.
+ */
+static AwaClientIterator *NewClientIterator(const char (*clients)[STANDIN_NAME_SIZE],
+		unsigned int count)
+{
+	AwaClientIterator *iterator = calloc(1, sizeof(*iterator));
+
+	if (iterator == NULL)
+	{
+		return NULL;
+	}
+
+	iterator->clients = calloc(count ? count : 1, STANDIN_NAME_SIZE);
+	if (iterator->clients == NULL)
+	{
+		free(iterator);
+		return NULL;
+	}
+	memcpy(iterator->clients, clients, count * STANDIN_NAME_SIZE);
+	iterator->count = count;
+	return iterator;
+}
+
+/**
+ * @brief Create a client iterator over one client.
+ * @param *clientID client name.
+ * @return iterator, or NULL if out of memory.
+ */
+static AwaClientIterator *NewSingleClientIterator(const char *clientID)
+{
+	char client[1][STANDIN_NAME_SIZE];
+
+	strncpy(client[0], clientID, STANDIN_NAME_SIZE - 1);
+	client[0][STANDIN_NAME_SIZE - 1] = '\0';
+	return NewClientIterator((const char (*)[STANDIN_NAME_SIZE])client, 1);
+}
+
+bool AwaClientIterator_Next(AwaClientIterator *iterator)
+{
+	if (iterator->next >= iterator->count)
+	{
+		return false;
+	}
+	iterator->next++;
+	return true;
+}
+
+const char *AwaClientIterator_GetClientID(const AwaClientIterator *iterator)
+{
+	return iterator->next > 0 ? iterator->clients[iterator->next - 1] : NULL;
+}
+
+void AwaClientIterator_Free(AwaClientIterator **iterator)
+{
+	if (*iterator != NULL)
+	{
+		free((*iterator)->clients);
+		free(*iterator);
+		*iterator = NULL;
+	}
+}
+
+/**
+ * @brief Get milliseconds on the monotonic clock.
+ * @return milliseconds.
+ */
+static long long NowMs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long)now.tv_sec * MS_PER_SECOND + now.tv_nsec / NS_PER_MS;
+}
+
+/**
+ * @brief Reset a connection to disconnected.
+ * @param *connection connection to initialize.
+ */
+static void Connection_Init(Connection *connection)
+{
+	memset(connection, 0, sizeof(*connection));
+	connection->requestFd = -1;
+	connection->notifyFd = -1;
+}
+
+/**
+ * @brief Set daemon address of a connection.
+ * @param *connection connection.
+ * @param *address daemon IPv4 address.
+ * @param port daemon port.
+ * @return AwaError_Success, or AwaError_OperationInvalid if the address is invalid.
+ */
+static AwaError Connection_SetAddress(Connection *connection, const char *address,
+		unsigned short port)
+{
+	connection->address.sin_family = AF_INET;
+	connection->address.sin_port = htons(port);
+	if (inet_pton(AF_INET, address, &connection->address.sin_addr) != 1)
+	{
+		return AwaError_OperationInvalid;
+	}
+	connection->hasAddress = true;
+	return AwaError_Success;
+}
+
+/**
+ * @brief Send a request and wait for its reply.
+ * @param *connection connected session.
+ * @param timeout maximum wait in milliseconds.
+ * @param **results set to the words following the status of the reply, may be NULL.
+ * @param *format printf style format of the verb and its arguments.
+ * @return AwaError_Success if the daemon answered OK, else the error the reply maps to.
+ */
+static AwaError Connection_Request(Connection *connection, AwaTimeout timeout, char **results,
+		const char *format, ...)
+{
+	unsigned int id = ++connection->nextID;
+	long long deadline = NowMs() + timeout;
+	struct pollfd poller = {connection->requestFd, POLLIN, 0};
+	va_list args;
+	int length;
+
+	if (connection->requestFd < 0)
+	{
+		return AwaError_SessionNotConnected;
+	}
+
+	length = snprintf(connection->buffer, STANDIN_DATAGRAM_SIZE, "%u ", id);
+	va_start(args, format);
+	length += vsnprintf(connection->buffer + length, STANDIN_DATAGRAM_SIZE - length, format, args);
+	va_end(args);
+	if (length >= STANDIN_DATAGRAM_SIZE)
+	{
+		return AwaError_OperationInvalid;
+	}
+
+	if (send(connection->requestFd, connection->buffer, length, 0) != length)
+	{
+		return AwaError_IPCError;
+	}
+
+	for (;;)
+	{
+		long long remaining = deadline - NowMs();
+		ssize_t received;
+		char *save = NULL;
+		char *word;
+
+		if (remaining <= 0 || poll(&poller, 1, remaining) == 0)
+		{
+			return AwaError_Timeout;
+		}
+
+		received = recv(connection->requestFd, connection->buffer, STANDIN_DATAGRAM_SIZE - 1, 0);
+		if (received < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return AwaError_IPCError;
+		}
+		connection->buffer[received] = '\0';
+
+		/* Replies to requests that timed out earlier are dropped */
+		word = strtok_r(connection->buffer, WORD_SEPARATORS, &save);
+		if (word == NULL || strtoul(word, NULL, 10) != id)
+		{
+			continue;
+		}
+
+		word = strtok_r(NULL, WORD_SEPARATORS, &save);
+		if (results != NULL)
+		{
+			*results = save != NULL ? save : "";
+		}
+
+		if (word == NULL)
+		{
+			return AwaError_Response;
+		}
+		else if (strcmp(word, STANDIN_STATUS_OK) == 0)
+		{
+			return AwaError_Success;
+		}
+		else if (strcmp(word, STANDIN_STATUS_NOTFOUND) == 0)
+		{
+			return AwaError_PathNotFound;
+		}
+		else if (strcmp(word, STANDIN_STATUS_NOCLIENT) == 0)
+		{
+			return AwaError_ClientNotFound;
+		}
+		return AwaError_Response;
+	}
+}
+
+/**
+ * @brief Parse object definitions of the form <object>/<maximum instances>:<resource>,<resource>
+ *        into a cache.
+ * @param *connection connection whose cache to add to.
+ * @param *definitions space separated definitions, modified.
+ */
+static void Connection_AddDefinitions(Connection *connection, char *definitions)
+{
+	char *save = NULL;
+	char *word;
+
+	for (word = strtok_r(definitions, WORD_SEPARATORS, &save); word != NULL;
+		word = strtok_r(NULL, WORD_SEPARATORS, &save))
+	{
+		AwaObjectDefinition *object;
+		char *resource = strchr(word, ':');
+		char *maximum = strchr(word, '/');
+		unsigned int i;
+
+		if (resource == NULL)
+		{
+			continue;
+		}
+
+		object = NULL;
+		for (i = 0; i < connection->numObjects; i++)
+		{
+			if (connection->objects[i].id == atoi(word))
+			{
+				object = &connection->objects[i];
+			}
+		}
+
+		if (object == NULL)
+		{
+			if (connection->numObjects == MAX_OBJECTS)
+			{
+				continue;
+			}
+			object = &connection->objects[connection->numObjects++];
+		}
+
+		memset(object, 0, sizeof(*object));
+		object->id = atoi(word);
+		object->maximumInstances = maximum != NULL ? atoi(maximum + 1) : 0;
+		while (resource != NULL && object->numResources < MAX_RESOURCES)
+		{
+			/* Only the id matters to the gateway, booleans are all it writes */
+			AddResource(object, atoi(resource + 1), AwaResourceType_Boolean);
+			resource = strchr(resource + 1, ',');
+		}
+	}
+}
+
+/**
+ * @brief Open the request and notify sockets and announce the session to the daemon. The
+ *        daemon answers with the objects defined on it.
+ * @param *connection connection to open.
+ * @return AwaError_Success, or AwaError_IPCError if the daemon doesn't answer.
+ */
+static AwaError Connection_Open(Connection *connection)
+{
+	struct sockaddr_in local;
+	socklen_t length = sizeof(local);
+	int bufferSize = NOTIFY_BUFFER_SIZE;
+	char *definitions;
+	AwaError error;
+
+	if (!connection->hasAddress)
+	{
+		return AwaError_OperationInvalid;
+	}
+
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	connection->requestFd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	connection->notifyFd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+	/* A fleet registering at once must not overflow the socket, best effort */
+	setsockopt(connection->notifyFd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+	if (connection->requestFd < 0 || connection->notifyFd < 0 ||
+		connect(connection->requestFd, (struct sockaddr *)&connection->address,
+				sizeof(connection->address)) != 0 ||
+		bind(connection->notifyFd, (struct sockaddr *)&local, sizeof(local)) != 0 ||
+		getsockname(connection->notifyFd, (struct sockaddr *)&local, &length) != 0)
+	{
+		error = AwaError_IPCError;
+	}
+	else
+	{
+		error = Connection_Request(connection, CONNECT_TIMEOUT, &definitions, "CONNECT %u",
+				ntohs(local.sin_port));
+	}
+
+	if (error != AwaError_Success)
+	{
+		close(connection->requestFd);
+		close(connection->notifyFd);
+		connection->requestFd = -1;
+		connection->notifyFd = -1;
+		return error == AwaError_Timeout ? AwaError_IPCError : error;
+	}
+	Connection_AddDefinitions(connection, definitions);
+	return AwaError_Success;
+}
+
+/**
+ * @brief Tell the daemon the session is gone and close the sockets.
+ * @param *connection connection to close.
+ */
+static void Connection_Close(Connection *connection)
+{
+	if (connection->requestFd >= 0)
+	{
+		/* Not answered, the daemon just forgets the session */
+		send(connection->requestFd, "0 DISCONNECT", strlen("0 DISCONNECT"), MSG_DONTWAIT);
+		close(connection->requestFd);
+		close(connection->notifyFd);
+	}
+	connection->requestFd = -1;
+	connection->notifyFd = -1;
+}
+
+/**
+ * @brief Wait for and read one notification.
+ * @param *connection connected session.
+ * @param timeout maximum wait in milliseconds.
+ * @param *notification filled with the notification.
+ * @return true if a notification was read, else false.
+ */
+static bool Connection_Receive(Connection *connection, AwaTimeout timeout, char *notification)
+{
+	struct pollfd poller = {connection->notifyFd, POLLIN, 0};
+	char discard[NOTIFICATION_SIZE];
+	ssize_t received;
+
+	/* Late replies to requests that timed out would keep the loop awake */
+	while (recv(connection->requestFd, discard, sizeof(discard), MSG_DONTWAIT) > 0)
+	{
+	}
+
+	if (timeout > 0 && poll(&poller, 1, timeout) <= 0)
+	{
+		return false;
+	}
+
+	received = recv(connection->notifyFd, notification, NOTIFICATION_SIZE - 1, MSG_DONTWAIT);
+	if (received < 0)
+	{
+		return false;
+	}
+	notification[received] = '\0';
+	return true;
+}
+
+/**
+ * @brief Find an object in a connection's definition cache.
+ * @param *connection connection.
+ * @param objectID object ID.
+ * @return object definition, or NULL if not defined.
+ */
+static const AwaObjectDefinition *Connection_FindObject(const Connection *connection,
+		AwaObjectID objectID)
+{
+	unsigned int i;
+
+	for (i = 0; i < connection->numObjects; i++)
+	{
+		if (connection->objects[i].id == objectID)
+		{
+			return &connection->objects[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Add an object definition to a define operation.
+ * @param *define define operation.
+ * @param *objectDefinition object to add.
+ * @return AwaError_Success, or AwaError_DefinitionInvalid if the operation is full.
+ */
+static AwaError Define_Add(DefineOperation *define, const AwaObjectDefinition *objectDefinition)
+{
+	if (objectDefinition == NULL || define->numObjects == MAX_OBJECTS)
+	{
+		return AwaError_DefinitionInvalid;
+	}
+	define->objects[define->numObjects++] = *objectDefinition;
+	return AwaError_Success;
+}
+
+/**
+ * @brief Define the objects of a define operation on the daemon, and cache them on success.
+ * @param *define define operation.
+ * @param timeout maximum wait in milliseconds.
+ * @return result of the request.
+ */
+static AwaError Define_Perform(DefineOperation *define, AwaTimeout timeout)
+{
+	char definitions[STANDIN_DATAGRAM_SIZE / 2];
+	size_t length = 0;
+	unsigned int i, j;
+	AwaError error;
+
+	definitions[0] = '\0';
+	for (i = 0; i < define->numObjects; i++)
+	{
+		const AwaObjectDefinition *object = &define->objects[i];
+
+		length += snprintf(definitions + length, sizeof(definitions) - length, " %d/%d:",
+				object->id, object->maximumInstances);
+		for (j = 0; j < object->numResources && length < sizeof(definitions); j++)
+		{
+			length += snprintf(definitions + length, sizeof(definitions) - length, "%s%d",
+					j ? "," : "", object->resources[j].id);
+		}
+	}
+
+	error = Connection_Request(define->connection, timeout, NULL, "DEFINE%s", definitions);
+	if (error == AwaError_Success)
+	{
+		Connection_AddDefinitions(define->connection, definitions);
+	}
+	return error;
+}
+
+AwaServerSession *AwaServerSession_New(void)
+{
+	AwaServerSession *session = calloc(1, sizeof(*session));
+
+	if (session != NULL)
+	{
+		Connection_Init(&session->connection);
+	}
+	return session;
+}
+
+AwaError AwaServerSession_SetIPCAsUDP(AwaServerSession *session, const char *address,
+		unsigned short port)
+{
+	return Connection_SetAddress(&session->connection, address, port);
+}
+
+AwaError AwaServerSession_Connect(AwaServerSession *session)
+{
+	return Connection_Open(&session->connection);
+}
+
+AwaError AwaServerSession_Disconnect(AwaServerSession *session)
+{
+	Connection_Close(&session->connection);
+	return AwaError_Success;
+}
+
+AwaError AwaServerSession_Free(AwaServerSession **session)
+{
+	unsigned int i;
+
+	if (*session == NULL)
+	{
+		return AwaError_SessionInvalid;
+	}
+
+	for (i = 0; i < (*session)->numObservations; i++)
+	{
+		(*session)->observations[i]->session = NULL;
+	}
+	Connection_Close(&(*session)->connection);
+	free(*session);
+	*session = NULL;
+	return AwaError_Success;
+}
+
+AwaError AwaServerSession_Process(AwaServerSession *session, AwaTimeout timeout)
+{
+	if (session->connection.notifyFd < 0)
+	{
+		return AwaError_SessionNotConnected;
+	}
+
+	while (session->numPending < MAX_PENDING &&
+		Connection_Receive(&session->connection, session->numPending ? 0 : timeout,
+				session->pending[session->numPending]))
+	{
+		session->numPending++;
+	}
+	return AwaError_Success;
+}
+
+/**
+ * @brief Run the callback of a notification received by a server session.
+ * @param *session server session.
+ * @param *notification notification, modified.
+ */
+static void DispatchNotification(AwaServerSession *session, char *notification)
+{
+	char *save = NULL;
+	char *verb = strtok_r(notification, WORD_SEPARATORS, &save);
+	char *clientID = strtok_r(NULL, WORD_SEPARATORS, &save);
+	char *path = strtok_r(NULL, WORD_SEPARATORS, &save);
+	char *value = strtok_r(NULL, WORD_SEPARATORS, &save);
+	unsigned int i;
+
+	if (verb == NULL || clientID == NULL)
+	{
+		return;
+	}
+
+	if (strcmp(verb, "NOTIFY") == 0 && value != NULL)
+	{
+		AwaChangeSet changeSet = {clientID, path, strtoll(value, NULL, 10)};
+
+		for (i = 0; i < session->numObservations; i++)
+		{
+			AwaServerObservation *observation = session->observations[i];
+
+			if (strcmp(observation->clientID, clientID) == 0 &&
+				strcmp(observation->path, path) == 0)
+			{
+				observation->callback(&changeSet, observation->context);
+			}
+		}
+	}
+	else if (strcmp(verb, "REGISTER") == 0 && session->registerCallback != NULL)
+	{
+		AwaServerClientRegisterEvent event = {clientID};
+		session->registerCallback(&event, session->registerContext);
+	}
+	else if (strcmp(verb, "UPDATE") == 0 && session->updateCallback != NULL)
+	{
+		AwaServerClientUpdateEvent event = {clientID};
+		session->updateCallback(&event, session->updateContext);
+	}
+	else if (strcmp(verb, "DEREGISTER") == 0 && session->deregisterCallback != NULL)
+	{
+		AwaServerClientDeregisterEvent event = {clientID};
+		session->deregisterCallback(&event, session->deregisterContext);
+	}
+}
+
+AwaError AwaServerSession_DispatchCallbacks(AwaServerSession *session)
+{
+	unsigned int i;
+
+	for (i = 0; i < session->numPending; i++)
+	{
+		DispatchNotification(session, session->pending[i]);
+	}
+	session->numPending = 0;
+	return AwaError_Success;
+}
+
+bool AwaServerSession_IsObjectDefined(const AwaServerSession *session, AwaObjectID objectID)
+{
+	return Connection_FindObject(&session->connection, objectID) != NULL;
+}
+
+const AwaObjectDefinition *AwaServerSession_GetObjectDefinition(const AwaServerSession *session,
+		AwaObjectID objectID)
+{
+	return Connection_FindObject(&session->connection, objectID);
+}
+
+AwaError AwaServerSession_PathToIDs(const AwaServerSession *session, const char *path,
+		AwaObjectID *objectID, AwaObjectInstanceID *objectInstanceID, AwaResourceID *resourceID)
+{
+	int object = -1, instance = -1, resource = -1;
+
+	if (sscanf(path, "/%d/%d/%d", &object, &instance, &resource) < 1)
+	{
+		return AwaError_PathInvalid;
+	}
+
+	if (objectID != NULL)
+	{
+		*objectID = object;
+	}
+	if (objectInstanceID != NULL)
+	{
+		*objectInstanceID = instance;
+	}
+	if (resourceID != NULL)
+	{
+		*resourceID = resource;
+	}
+	return AwaError_Success;
+}
+
+AwaError AwaServerSession_SetClientRegisterEventCallback(AwaServerSession *session,
+		AwaServerClientRegisterEventCallback callback, void *context)
+{
+	session->registerCallback = callback;
+	session->registerContext = context;
+	return AwaError_Success;
+}
+
+AwaError AwaServerSession_SetClientUpdateEventCallback(AwaServerSession *session,
+		AwaServerClientUpdateEventCallback callback, void *context)
+{
+	session->updateCallback = callback;
+	session->updateContext = context;
+	return AwaError_Success;
+}
+
+AwaError AwaServerSession_SetClientDeregisterEventCallback(AwaServerSession *session,
+		AwaServerClientDeregisterEventCallback callback, void *context)
+{
+	session->deregisterCallback = callback;
+	session->deregisterContext = context;
+	return AwaError_Success;
+}
+
+AwaClientIterator *AwaServerClientRegisterEvent_NewClientIterator(
+		const AwaServerClientRegisterEvent *event)
+{
+	return NewSingleClientIterator(event->clientID);
+}
+
+AwaClientIterator *AwaServerClientUpdateEvent_NewClientIterator(
+		const AwaServerClientUpdateEvent *event)
+{
+	return NewSingleClientIterator(event->clientID);
+}
+
+AwaClientIterator *AwaServerClientDeregisterEvent_NewClientIterator(
+		const AwaServerClientDeregisterEvent *event)
+{
+	return NewSingleClientIterator(event->clientID);
+}
+
+AwaServerDefineOperation *AwaServerDefineOperation_New(const AwaServerSession *session)
+{
+	AwaServerDefineOperation *operation = calloc(1, sizeof(*operation));
+
+	if (operation != NULL)
+	{
+		operation->define.connection = (Connection *)&session->connection;
+	}
+	return operation;
+}
+
+AwaError AwaServerDefineOperation_Add(AwaServerDefineOperation *operation,
+		const AwaObjectDefinition *objectDefinition)
+{
+	return Define_Add(&operation->define, objectDefinition);
+}
+
+AwaError AwaServerDefineOperation_Perform(AwaServerDefineOperation *operation,
+		AwaTimeout timeout)
+{
+	return Define_Perform(&operation->define, timeout);
+}
+
+AwaError AwaServerDefineOperation_Free(AwaServerDefineOperation **operation)
+{
+	free(*operation);
+	*operation = NULL;
+	return AwaError_Success;
+}
+
+AwaServerListClientsOperation *AwaServerListClientsOperation_New(const AwaServerSession *session)
+{
+	AwaServerListClientsOperation *operation = calloc(1, sizeof(*operation));
+
+	if (operation != NULL)
+	{
+		operation->session = (AwaServerSession *)session;
+	}
+	return operation;
+}
+
+AwaError AwaServerListClientsOperation_Perform(AwaServerListClientsOperation *operation,
+		AwaTimeout timeout)
+{
+	char *clients;
+	char *save = NULL;
+	char *word;
+	unsigned int count = 0;
+	AwaError error;
+
+	error = Connection_Request(&operation->session->connection, timeout, &clients, "LIST");
+	if (error != AwaError_Success)
+	{
+		return error;
+	}
+
+	for (word = clients; *word != '\0'; word++)
+	{
+		count += (*word == ' ');
+	}
+
+	free(operation->clients);
+	operation->count = 0;
+	operation->clients = calloc(count + 1, STANDIN_NAME_SIZE);
+	if (operation->clients == NULL)
+	{
+		return AwaError_Unspecified;
+	}
+
+	for (word = strtok_r(clients, WORD_SEPARATORS, &save);
+		word != NULL && operation->count <= count; word = strtok_r(NULL, WORD_SEPARATORS, &save))
+	{
+		strncpy(operation->clients[operation->count++], word, STANDIN_NAME_SIZE - 1);
+	}
+	return AwaError_Success;
+}
+
+AwaClientIterator *AwaServerListClientsOperation_NewClientIterator(
+		const AwaServerListClientsOperation *operation)
+{
+	return NewClientIterator((const char (*)[STANDIN_NAME_SIZE])operation->clients,
+			operation->count);
+}
+
+AwaError AwaServerListClientsOperation_Free(AwaServerListClientsOperation **operation)
+{
+	free((*operation)->clients);
+	free(*operation);
+	*operation = NULL;
+	return AwaError_Success;
+}
+
+AwaServerWriteOperation *AwaServerWriteOperation_New(const AwaServerSession *session,
+		AwaWriteMode mode)
+{
+	AwaServerWriteOperation *operation = calloc(1, sizeof(*operation));
+
+	if (operation != NULL)
+	{
+		operation->session = (AwaServerSession *)session;
+	}
+	return operation;
+}
+
+AwaError AwaServerWriteOperation_AddValueAsBoolean(AwaServerWriteOperation *operation,
+		const char *path, AwaBoolean value)
+{
+	if (operation->count == MAX_PATHS)
+	{
+		return AwaError_OperationInvalid;
+	}
+
+	strncpy(operation->paths[operation->count], path, STANDIN_PATH_SIZE - 1);
+	operation->values[operation->count++] = value;
+	return AwaError_Success;
+}
+
+AwaError AwaServerWriteOperation_Perform(AwaServerWriteOperation *operation, const char *clientID,
+		AwaTimeout timeout)
+{
+	char values[MAX_PATHS * (STANDIN_PATH_SIZE + 3)];
+	size_t length = 0;
+	char *results;
+	char *save = NULL;
+	bool rejected = false;
+	unsigned int i;
+	AwaError error;
+
+	if (operation->count == 0)
+	{
+		return AwaError_OperationInvalid;
+	}
+
+	values[0] = '\0';
+	for (i = 0; i < operation->count; i++)
+	{
+		length += snprintf(values + length, sizeof(values) - length, " %s %d",
+				operation->paths[i], operation->values[i]);
+	}
+
+	operation->response.operation = NULL;
+	error = Connection_Request(&operation->session->connection, timeout, &results, "WRITE %s%s",
+			clientID, values);
+	if (error != AwaError_Success)
+	{
+		return error;
+	}
+
+	for (i = 0; i < operation->count; i++)
+	{
+		char *status = strtok_r(i == 0 ? results : NULL, WORD_SEPARATORS, &save);
+
+		operation->results[i].error = (status != NULL && strcmp(status, STANDIN_STATUS_OK) == 0) ?
+				AwaError_Success : AwaError_PathNotFound;
+		rejected |= (operation->results[i].error != AwaError_Success);
+	}
+	operation->response.operation = operation;
+	strncpy(operation->response.clientID, clientID, STANDIN_NAME_SIZE - 1);
+	return rejected ? AwaError_Response : AwaError_Success;
+}
+
+const AwaServerWriteResponse *AwaServerWriteOperation_GetResponse(
+		const AwaServerWriteOperation *operation, const char *clientID)
+{
+	if (operation->response.operation == NULL ||
+		strcmp(operation->response.clientID, clientID) != 0)
+	{
+		return NULL;
+	}
+	return &operation->response;
+}
+
+const AwaPathResult *AwaServerWriteResponse_GetPathResult(
+		const AwaServerWriteResponse *response, const char *path)
+{
+	const AwaServerWriteOperation *operation;
+	unsigned int i;
+
+	if (response == NULL)
+	{
+		return NULL;
+	}
+
+	operation = response->operation;
+	for (i = 0; i < operation->count; i++)
+	{
+		if (strcmp(operation->paths[i], path) == 0)
+		{
+			return &operation->results[i];
+		}
+	}
+	return NULL;
+}
+
+AwaError AwaServerWriteOperation_Free(AwaServerWriteOperation **operation)
+{
+	free(*operation);
+	*operation = NULL;
+	return AwaError_Success;
+}
+
+AwaServerObservation *AwaServerObservation_New(const char *clientID, const char *path,
+		AwaServerObservationCallback callback, void *context)
+{
+	AwaServerObservation *observation = calloc(1, sizeof(*observation));
+
+	if (observation != NULL)
+	{
+		strncpy(observation->clientID, clientID, STANDIN_NAME_SIZE - 1);
+		strncpy(observation->path, path, STANDIN_PATH_SIZE - 1);
+		observation->callback = callback;
+		observation->context = context;
+	}
+	return observation;
+}
+
+AwaError AwaServerObservation_Free(AwaServerObservation **observation)
+{
+	AwaServerSession *session = (*observation)->session;
+	unsigned int i;
+
+	for (i = 0; session != NULL && i < session->numObservations; i++)
+	{
+		if (session->observations[i] == *observation)
+		{
+			session->observations[i] = session->observations[--session->numObservations];
+			break;
+		}
+	}
+	free(*observation);
+	*observation = NULL;
+	return AwaError_Success;
+}
+
+AwaServerObserveOperation *AwaServerObserveOperation_New(const AwaServerSession *session)
+{
+	AwaServerObserveOperation *operation = calloc(1, sizeof(*operation));
+
+	if (operation != NULL)
+	{
+		operation->session = (AwaServerSession *)session;
+	}
+	return operation;
+}
+
+AwaError AwaServerObserveOperation_AddObservation(AwaServerObserveOperation *operation,
+		AwaServerObservation *observation)
+{
+	if (operation->count == MAX_PATHS)
+	{
+		return AwaError_OperationInvalid;
+	}
+	operation->observations[operation->count++] = observation;
+	return AwaError_Success;
+}
+
+AwaError AwaServerObserveOperation_Perform(AwaServerObserveOperation *operation,
+		AwaTimeout timeout)
+{
+	AwaServerSession *session = operation->session;
+	char paths[STANDIN_DATAGRAM_SIZE / 2];
+	size_t length = 0;
+	char *results;
+	char *save = NULL;
+	unsigned int i;
+	AwaError error;
+
+	paths[0] = '\0';
+	for (i = 0; i < operation->count && length < sizeof(paths); i++)
+	{
+		length += snprintf(paths + length, sizeof(paths) - length, " %s %s",
+				operation->observations[i]->clientID, operation->observations[i]->path);
+	}
+
+	error = Connection_Request(&session->connection, timeout, &results, "OBSERVE%s", paths);
+	if (error != AwaError_Success)
+	{
+		return error;
+	}
+
+	for (i = 0; i < operation->count; i++)
+	{
+		AwaServerObservation *observation = operation->observations[i];
+		char *status = strtok_r(i == 0 ? results : NULL, WORD_SEPARATORS, &save);
+
+		operation->responses[i].operation = operation;
+		operation->responses[i].clientID = observation->clientID;
+		operation->results[i].error = (status != NULL && strcmp(status, STANDIN_STATUS_OK) == 0) ?
+				AwaError_Success : AwaError_PathNotFound;
+
+		if (operation->results[i].error == AwaError_Success && observation->session == NULL &&
+			session->numObservations < MAX_OBSERVATIONS)
+		{
+			observation->session = session;
+			session->observations[session->numObservations++] = observation;
+		}
+	}
+	return AwaError_Success;
+}
+
+const AwaServerObserveResponse *AwaServerObserveOperation_GetResponse(
+		const AwaServerObserveOperation *operation, const char *clientID)
+{
+	unsigned int i;
+
+	for (i = 0; i < operation->count; i++)
+	{
+		if (operation->responses[i].clientID != NULL &&
+			strcmp(operation->responses[i].clientID, clientID) == 0)
+		{
+			return &operation->responses[i];
+		}
+	}
+	return NULL;
+}
+
+const AwaPathResult *AwaServerObserveResponse_GetPathResult(
+		const AwaServerObserveResponse *response, const char *path)
+{
+	const AwaServerObserveOperation *operation;
+	unsigned int i;
+
+	if (response == NULL)
+	{
+		return NULL;
+	}
+
+	operation = response->operation;
+	for (i = 0; i < operation->count; i++)
+	{
+		if (strcmp(operation->observations[i]->clientID, response->clientID) == 0 &&
+			strcmp(operation->observations[i]->path, path) == 0)
+		{
+			return &operation->results[i];
+		}
+	}
+	return NULL;
+}
+
+AwaError AwaServerObserveOperation_Free(AwaServerObserveOperation **operation)
+{
+	free(*operation);
+	*operation = NULL;
+	return AwaError_Success;
+}
+
+AwaClientSession *AwaClientSession_New(void)
+{
+	AwaClientSession *session = calloc(1, sizeof(*session));
+
+	if (session != NULL)
+	{
+		Connection_Init(&session->connection);
+	}
+	return session;
+}
+
+AwaError AwaClientSession_SetIPCAsUDP(AwaClientSession *session, const char *address,
+		unsigned short port)
+{
+	return Connection_SetAddress(&session->connection, address, port);
+}
+
+AwaError AwaClientSession_Connect(AwaClientSession *session)
+{
+	return Connection_Open(&session->connection);
+}
+
+AwaError AwaClientSession_Disconnect(AwaClientSession *session)
+{
+	Connection_Close(&session->connection);
+	return AwaError_Success;
+}
+
+AwaError AwaClientSession_Free(AwaClientSession **session)
+{
+	if (*session == NULL)
+	{
+		return AwaError_SessionInvalid;
+	}
+	Connection_Close(&(*session)->connection);
+	free(*session);
+	*session = NULL;
+	return AwaError_Success;
+}
+
+AwaError AwaClientSession_Process(AwaClientSession *session, AwaTimeout timeout)
+{
+	char notification[NOTIFICATION_SIZE];
+
+	if (session->connection.notifyFd < 0)
+	{
+		return AwaError_SessionNotConnected;
+	}
+
+	/* The stand-in client daemon sends no change notifications */
+	while (Connection_Receive(&session->connection, timeout, notification))
+	{
+		timeout = 0;
+	}
+	return AwaError_Success;
+}
+
+AwaError AwaClientSession_DispatchCallbacks(AwaClientSession *session)
+{
+	return AwaError_Success;
+}
+
+bool AwaClientSession_IsObjectDefined(const AwaClientSession *session, AwaObjectID objectID)
+{
+	return Connection_FindObject(&session->connection, objectID) != NULL;
+}
+
+AwaClientDefineOperation *AwaClientDefineOperation_New(const AwaClientSession *session)
+{
+	AwaClientDefineOperation *operation = calloc(1, sizeof(*operation));
+
+	if (operation != NULL)
+	{
+		operation->define.connection = (Connection *)&session->connection;
+	}
+	return operation;
+}
+
+AwaError AwaClientDefineOperation_Add(AwaClientDefineOperation *operation,
+		const AwaObjectDefinition *objectDefinition)
+{
+	return Define_Add(&operation->define, objectDefinition);
+}
+
+AwaError AwaClientDefineOperation_Perform(AwaClientDefineOperation *operation,
+		AwaTimeout timeout)
+{
+	return Define_Perform(&operation->define, timeout);
+}
+
+AwaError AwaClientDefineOperation_Free(AwaClientDefineOperation **operation)
+{
+	free(*operation);
+	*operation = NULL;
+	return AwaError_Success;
+}
+
+AwaClientGetOperation *AwaClientGetOperation_New(const AwaClientSession *session)
+{
+	AwaClientGetOperation *operation = calloc(1, sizeof(*operation));
+
+	if (operation != NULL)
+	{
+		operation->session = (AwaClientSession *)session;
+		operation->response.operation = operation;
+	}
+	return operation;
+}
+
+AwaError AwaClientGetOperation_AddPath(AwaClientGetOperation *operation, const char *path)
+{
+	if (operation->count == MAX_PATHS)
+	{
+		return AwaError_OperationInvalid;
+	}
+	strncpy(operation->paths[operation->count++], path, STANDIN_PATH_SIZE - 1);
+	return AwaError_Success;
+}
+
+AwaError AwaClientGetOperation_Perform(AwaClientGetOperation *operation, AwaTimeout timeout)
+{
+	char paths[MAX_PATHS * (STANDIN_PATH_SIZE + 1) + 1];
+	size_t length = 0;
+	char *present;
+	char *save = NULL;
+	char *word;
+	unsigned int i;
+	AwaError error;
+
+	paths[0] = '\0';
+	for (i = 0; i < operation->count; i++)
+	{
+		length += snprintf(paths + length, sizeof(paths) - length, " %s", operation->paths[i]);
+	}
+
+	error = Connection_Request(&operation->session->connection, timeout, &present, "GET%s", paths);
+	if (error != AwaError_Success)
+	{
+		return error;
+	}
+
+	for (word = strtok_r(present, WORD_SEPARATORS, &save); word != NULL;
+		word = strtok_r(NULL, WORD_SEPARATORS, &save))
+	{
+		for (i = 0; i < operation->count; i++)
+		{
+			if (strcmp(operation->paths[i], word) == 0)
+			{
+				operation->present[i] = true;
+			}
+		}
+	}
+	return AwaError_Success;
+}
+
+const AwaClientGetResponse *AwaClientGetOperation_GetResponse(
+		const AwaClientGetOperation *operation)
+{
+	return &operation->response;
+}
+
+bool AwaClientGetResponse_ContainsPath(const AwaClientGetResponse *response, const char *path)
+{
+	unsigned int i;
+
+	for (i = 0; i < response->operation->count; i++)
+	{
+		if (response->operation->present[i] && strcmp(response->operation->paths[i], path) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+AwaError AwaClientGetOperation_Free(AwaClientGetOperation **operation)
+{
+	free(*operation);
+	*operation = NULL;
+	return AwaError_Success;
+}
+
+AwaClientSetOperation *AwaClientSetOperation_New(const AwaClientSession *session)
+{
+	AwaClientSetOperation *operation = calloc(1, sizeof(*operation));
+
+	if (operation != NULL)
+	{
+		operation->session = (AwaClientSession *)session;
+		operation->response.operation = operation;
+	}
+	return operation;
+}
+
+AwaError AwaClientSetOperation_CreateObjectInstance(AwaClientSetOperation *operation,
+		const char *path)
+{
+	strncpy(operation->createPath, path, STANDIN_PATH_SIZE - 1);
+	return AwaError_Success;
+}
+
+AwaError AwaClientSetOperation_AddValueAsBoolean(AwaClientSetOperation *operation,
+		const char *path, AwaBoolean value)
+{
+	strncpy(operation->path, path, STANDIN_PATH_SIZE - 1);
+	operation->value = value;
+	operation->hasValue = true;
+	return AwaError_Success;
+}
+
+AwaError AwaClientSetOperation_Perform(AwaClientSetOperation *operation, AwaTimeout timeout)
+{
+	AwaError error;
+
+	if (!operation->hasValue)
+	{
+		return AwaError_OperationInvalid;
+	}
+
+	error = Connection_Request(&operation->session->connection, timeout, NULL, "SET %s %s %d",
+			operation->createPath[0] != '\0' ? operation->createPath : "-", operation->path,
+			operation->value);
+	operation->result.error = error;
+	return error == AwaError_PathNotFound ? AwaError_Response : error;
+}
+
+const AwaClientSetResponse *AwaClientSetOperation_GetResponse(
+		const AwaClientSetOperation *operation)
+{
+	return &operation->response;
+}
+
+const AwaPathResult *AwaClientSetResponse_GetPathResult(const AwaClientSetResponse *response,
+		const char *path)
+{
+	if (strcmp(response->operation->path, path) != 0)
+	{
+		return NULL;
+	}
+	return &response->operation->result;
+}
+
+AwaError AwaClientSetOperation_Free(AwaClientSetOperation **operation)
+{
+	free(*operation);
+	*operation = NULL;
+	return AwaError_Success;
+}
+
+AwaClientChangeSubscription *AwaClientChangeSubscription_New(const char *path,
+		AwaClientSubscriptionCallback callback, void *context)
+{
+	AwaClientChangeSubscription *subscription = calloc(1, sizeof(*subscription));
+
+	if (subscription != NULL)
+	{
+		strncpy(subscription->path, path, STANDIN_PATH_SIZE - 1);
+		subscription->callback = callback;
+		subscription->context = context;
+	}
+	return subscription;
+}
+
+AwaError AwaClientChangeSubscription_Free(AwaClientChangeSubscription **subscription)
+{
+	free(*subscription);
+	*subscription = NULL;
+	return AwaError_Success;
+}
+
+AwaClientSubscribeOperation *AwaClientSubscribeOperation_New(const AwaClientSession *session)
+{
+	AwaClientSubscribeOperation *operation = calloc(1, sizeof(*operation));
+
+	if (operation != NULL)
+	{
+		operation->session = (AwaClientSession *)session;
+	}
+	return operation;
+}
+
+AwaError AwaClientSubscribeOperation_AddChangeSubscription(AwaClientSubscribeOperation *operation,
+		AwaClientChangeSubscription *subscription)
+{
+	if (operation->count == MAX_PATHS)
+	{
+		return AwaError_OperationInvalid;
+	}
+	operation->subscriptions[operation->count++] = subscription;
+	return AwaError_Success;
+}
+
+AwaError AwaClientSubscribeOperation_Perform(AwaClientSubscribeOperation *operation,
+		AwaTimeout timeout)
+{
+	unsigned int i;
+	AwaError error = AwaError_Success;
+
+	for (i = 0; i < operation->count && error == AwaError_Success; i++)
+	{
+		error = Connection_Request(&operation->session->connection, timeout, NULL,
+				"SUBSCRIBE %s", operation->subscriptions[i]->path);
+	}
+	return error;
+}
+
+AwaError AwaClientSubscribeOperation_Free(AwaClientSubscribeOperation **operation)
+{
+	free(*operation);
+	*operation = NULL;
+	return AwaError_Success;
+}
@@ -0,0 +1,447 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file bench.c
+ * @brief Benchmark driver. Runs stand-in Awa server and client daemons for a fleet of simulated
+ *        devices, starts the benchmark build of the gateway against them, drives button presses
+ *        with the load generator and reports how long the fleet took to be observed, and how
+ *        many presses reached their leds and how fast.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "load.h"
+#include "standin_daemon.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define DEFAULT_DEVICES			(16)
+#define DEFAULT_RATE			(100)
+#define DEFAULT_DURATION		(10)
+#define DEFAULT_BURST			(50)
+#define DEFAULT_OUTAGE			(1000)
+#define DEFAULT_WINDOW			(1000)
+#define DEFAULT_GATEWAY			"./button_gateway_bench_appd"
+#define DEFAULT_WORKDIR			"/tmp/button_gateway_bench"
+#define BINDINGS_FILE			"bindings.cfg"
+#define FLOW_CONFIG_FILE		"flow_access.cfg"
+#define LOG_FILE				"gateway.log"
+#define STARTUP_FILE			"startup.txt"
+#define OBSERVE_TIMEOUT			(30000)
+#define SETTLE_TIME				(1000)
+#define DRAIN_TIMEOUT			(30000)
+#define POLL_INTERVAL			(10)
+#define REPORT_DELAY			(1500)
+#define MS_PER_SECOND			(1000)
+#define NS_PER_MS				(1000000)
+//! @endcond
+
+/***************************************************************************************************
+ * Typedef
+ **************************************************************************************************/
+
+/**
+ * A structure to contain the benchmark settings.
+ */
+typedef struct
+{
+	/*@{*/
+	unsigned int devices; /**< simulated devices */
+	LoadConfig load; /**< load generator settings */
+	const char *gateway; /**< gateway binary built against the stand-ins */
+	const char *workdir; /**< directory for the gateway's files */
+	/*@}*/
+}BenchConfig;
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Print usage of the driver.
+ * @param *program name of the program.
+ */
+static void PrintUsage(const char *program)
+{
+	printf("Usage: %s [options]\n\n"
+			" -n : Number of simulated devices, default is %d, at most %d.\n"
+			" -p : Press pattern, steady, bursty or herd, default is steady.\n"
+			" -r : Button presses per second over all devices, default is %d.\n"
+			" -d : Seconds to press buttons for, default is %d.\n"
+			" -b : Presses per burst of the bursty pattern, default is %d.\n"
+			" -o : Milliseconds the fleet is powered off in the herd pattern, default is %d.\n"
+			" -W : Milliseconds the fleet re-registers over in the herd pattern, default is %d.\n"
+			" -S : Seed of the pressed device choice, default is 1.\n"
+			" -g : Gateway binary built against the stand-ins, default is %s.\n"
+			" -w : Working directory of the gateway, default is %s.\n"
+			" -h : Show this help.\n\n"
+			"A Flow round trip is simulated by setting BENCH_FLOW_LATENCY_US.\n",
+			program, DEFAULT_DEVICES, STANDIN_MAX_DEVICES, DEFAULT_RATE, DEFAULT_DURATION,
+			DEFAULT_BURST, DEFAULT_OUTAGE, DEFAULT_WINDOW, DEFAULT_GATEWAY, DEFAULT_WORKDIR);
+}
+
+/**
+ * @brief Parse command line arguments.
+ * @param argc number of arguments.
+ * @param *argv[] arguments.
+ * @param *config filled with the settings.
+ * @return 1 to run, 0 if help was shown, -1 on invalid arguments.
+ */
+static int ParseCommandArgs(int argc, char *argv[], BenchConfig *config)
+{
+	int c;
+
+	config->devices = DEFAULT_DEVICES;
+	config->load.pattern = LoadPattern_Steady;
+	config->load.rate = DEFAULT_RATE;
+	config->load.duration = DEFAULT_DURATION;
+	config->load.burst = DEFAULT_BURST;
+	config->load.outage = DEFAULT_OUTAGE;
+	config->load.window = DEFAULT_WINDOW;
+	config->load.seed = 1;
+	config->gateway = DEFAULT_GATEWAY;
+	config->workdir = DEFAULT_WORKDIR;
+
+	while ((c = getopt(argc, argv, "n:p:r:d:b:o:W:S:g:w:h")) != -1)
+	{
+		switch (c)
+		{
+			case 'n':
+				config->devices = strtoul(optarg, NULL, 0);
+				break;
+			case 'p':
+				if (!Load_ParsePattern(optarg, &config->load.pattern))
+				{
+					PrintUsage(argv[0]);
+					return -1;
+				}
+				break;
+			case 'r':
+				config->load.rate = strtod(optarg, NULL);
+				break;
+			case 'd':
+				config->load.duration = strtoul(optarg, NULL, 0);
+				break;
+			case 'b':
+				config->load.burst = strtoul(optarg, NULL, 0);
+				break;
+			case 'o':
+				config->load.outage = strtoul(optarg, NULL, 0);
+				break;
+			case 'W':
+				config->load.window = strtoul(optarg, NULL, 0);
+				break;
+			case 'S':
+				config->load.seed = strtoul(optarg, NULL, 0);
+				break;
+			case 'g':
+				config->gateway = optarg;
+				break;
+			case 'w':
+				config->workdir = optarg;
+				break;
+			case 'h':
+				PrintUsage(argv[0]);
+				return 0;
+			default:
+				PrintUsage(argv[0]);
+				return -1;
+		}
+	}
+
+	if (config->devices == 0 || config->devices > STANDIN_MAX_DEVICES || config->load.rate <= 0 ||
+		config->load.duration == 0 || config->load.burst == 0)
+	{
+		PrintUsage(argv[0]);
+		return -1;
+	}
+	return 1;
+}
+
+/**
+ * @brief Get milliseconds on the monotonic clock.
+ * @return milliseconds.
+ */
+static long long NowMs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long)now.tv_sec * MS_PER_SECOND + now.tv_nsec / NS_PER_MS;
+}
+
+/**
+ * @brief Write the gateway's bindings, one button driving the led of the same device, and a
+ *        Flow access file so Flow registers right away.
+ * @param *config settings.
+ * @return true on success, else false.
+ */
+static bool WriteGatewayFiles(const BenchConfig *config)
+{
+	FILE *file;
+	unsigned int i;
+
+	file = fopen(BINDINGS_FILE, "w");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	fprintf(file, "bindings = (\n");
+	for (i = 0; i < config->devices; i++)
+	{
+		fprintf(file, "    { client = \"%s%u\"; path = \"%s\";\n"
+				"      leds = ( { client = \"%s%u\"; path = \"%s\"; } ); }%s\n",
+				STANDIN_DEVICE_PREFIX, i, STANDIN_BUTTON_PATH, STANDIN_DEVICE_PREFIX, i,
+				STANDIN_LED_PATH, i + 1 < config->devices ? "," : "");
+	}
+	fprintf(file, ");\noutbox = { file = \"flow_outbox\"; };\n"
+			"metrics = { socket = \"metrics.sock\"; };\n");
+	if (fclose(file) != 0)
+	{
+		return false;
+	}
+
+	file = fopen(FLOW_CONFIG_FILE, "w");
+	if (file == NULL)
+	{
+		return false;
+	}
+	fprintf(file, "URL = \"http://localhost\";\nCustomerKey = \"bench\";\n"
+			"CustomerSecret = \"bench\";\nRememberMeToken = \"bench\";\n");
+	return fclose(file) == 0;
+}
+
+/**
+ * @brief Start the gateway in the working directory.
+ * @param *gateway absolute path of the gateway binary.
+ * @return process ID, or -1 on failure.
+ */
+static pid_t StartGateway(const char *gateway)
+{
+	pid_t pid = fork();
+
+	if (pid == 0)
+	{
+		execl(gateway, gateway, "-c", BINDINGS_FILE, "-l", LOG_FILE, "-s", STARTUP_FILE,
+				"-r", "gpio", (char *)NULL);
+		fprintf(stderr, "Failed to run %s: %s\n", gateway, strerror(errno));
+		_exit(EXIT_FAILURE);
+	}
+	return pid;
+}
+
+/**
+ * @brief Wait until the gateway observes every button.
+ * @param *fleet devices.
+ * @param gateway gateway process.
+ * @return true if every button is observed, false on timeout or if the gateway exited.
+ */
+static bool WaitForObservations(StandinFleet *fleet, pid_t gateway)
+{
+	long long deadline = NowMs() + OBSERVE_TIMEOUT;
+	unsigned int observed;
+
+	do
+	{
+		pthread_mutex_lock(&fleet->lock);
+		observed = fleet->observed;
+		pthread_mutex_unlock(&fleet->lock);
+
+		if (observed == fleet->count)
+		{
+			return true;
+		}
+
+		if (waitpid(gateway, NULL, WNOHANG) == gateway)
+		{
+			fprintf(stderr, "Gateway exited\n");
+			return false;
+		}
+		usleep(POLL_INTERVAL * MS_PER_SECOND);
+	}
+	while (NowMs() < deadline);
+
+	fprintf(stderr, "Only %u of %u buttons observed\n", observed, fleet->count);
+	return false;
+}
+
+/**
+ * @brief Wait until writes and sets stop arriving.
+ * @param *fleet devices.
+ * @return time of the last write or set, in milliseconds.
+ */
+static long long Drain(StandinFleet *fleet)
+{
+	long long deadline = NowMs() + DRAIN_TIMEOUT;
+	long long lastChange = NowMs();
+	unsigned long last = 0;
+
+	while (NowMs() < deadline && NowMs() - lastChange < SETTLE_TIME)
+	{
+		unsigned long count;
+
+		pthread_mutex_lock(&fleet->lock);
+		count = fleet->writes + fleet->sets;
+		pthread_mutex_unlock(&fleet->lock);
+
+		if (count != last)
+		{
+			last = count;
+			lastChange = NowMs();
+		}
+		usleep(POLL_INTERVAL * MS_PER_SECOND);
+	}
+	return lastChange;
+}
+
+/**
+ * @brief Print a latency histogram summary.
+ * @param *histogram histogram.
+ */
+static void PrintLatency(const Histogram *histogram)
+{
+	HistogramSummary summary;
+
+	Histogram_GetSummary(histogram, &summary);
+	printf("%-14s %8lu  p50 %8u us  p99 %8u us  p99.9 %8u us  max %8u us\n", histogram->name,
+			summary.count, summary.p50, summary.p99, summary.p999, summary.max);
+}
+
+int main(int argc, char *argv[])
+{
+	BenchConfig config;
+	StandinFleet fleet;
+	StandinDaemon server, client;
+	char gateway[PATH_MAX];
+	LoadResult result;
+	long long start, end;
+	pid_t pid;
+	int ret;
+
+	ret = ParseCommandArgs(argc, argv, &config);
+	if (ret <= 0)
+	{
+		return ret;
+	}
+
+	if (realpath(config.gateway, gateway) == NULL)
+	{
+		fprintf(stderr, "Gateway binary %s not found\n", config.gateway);
+		return -1;
+	}
+
+	if ((mkdir(config.workdir, 0755) != 0 && errno != EEXIST) || chdir(config.workdir) != 0 ||
+		!WriteGatewayFiles(&config))
+	{
+		fprintf(stderr, "Failed to prepare %s: %s\n", config.workdir, strerror(errno));
+		return -1;
+	}
+
+	if (!StandinFleet_Init(&fleet, config.devices))
+	{
+		fprintf(stderr, "Failed to create %u devices\n", config.devices);
+		return -1;
+	}
+
+	if (!StandinDaemon_Start(&server, StandinRole_Server, &fleet))
+	{
+		StandinFleet_Free(&fleet);
+		return -1;
+	}
+
+	if (!StandinDaemon_Start(&client, StandinRole_Client, &fleet))
+	{
+		StandinDaemon_Stop(&server);
+		StandinFleet_Free(&fleet);
+		return -1;
+	}
+
+	ret = -1;
+	start = NowMs();
+	pid = StartGateway(gateway);
+	if (pid > 0 && WaitForObservations(&fleet, pid))
+	{
+		/* Covers listing the registered devices and observing every button */
+		printf("%u devices observed %lld ms after start, %s pattern\n", config.devices,
+				NowMs() - start, Load_PatternName(config.load.pattern));
+		start = NowMs();
+		Load_Run(&server, &config.load, &result);
+		end = Drain(&fleet);
+
+		/* The gateway logs its own latency breakdown, and flushes its log once a second */
+		kill(pid, SIGUSR1);
+		usleep(REPORT_DELAY * MS_PER_SECOND);
+
+		pthread_mutex_lock(&fleet.lock);
+		if (config.load.pattern == LoadPattern_Herd)
+		{
+			printf("recovery       %8lld ms from power on to every button observed\n",
+					result.recoveryMs);
+		}
+		printf("presses        %8lu  (%lu not notified)\n", result.presses, result.failed);
+		printf("server writes  %8lu  %.1f per second\n", fleet.writes,
+				fleet.writes * (double)MS_PER_SECOND / (end - start));
+		printf("client sets    %8lu  %.1f per second\n", fleet.sets,
+				fleet.sets * (double)MS_PER_SECOND / (end - start));
+		PrintLatency(&fleet.writeLatency);
+		PrintLatency(&fleet.setLatency);
+		pthread_mutex_unlock(&fleet.lock);
+		printf("Gateway log and startup report in %s\n", config.workdir);
+		ret = 0;
+	}
+
+	if (pid > 0)
+	{
+		kill(pid, SIGTERM);
+		waitpid(pid, NULL, 0);
+	}
+	StandinDaemon_Stop(&client);
+	StandinDaemon_Stop(&server);
+	StandinFleet_Free(&fleet);
+	return ret;
+}
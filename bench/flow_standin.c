@@ -0,0 +1,182 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file flow_standin.c
+ * @brief Stand-in for the Flow libraries, linked into the benchmark build of the gateway. The
+ *        device is always logged in and every message is accepted. A round trip to the Flow
+ *        server can be simulated by setting BENCH_FLOW_LATENCY_US in the environment.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "flow/flowmessaging.h"
+#include "flow/core/flow_memalloc.h"
+#include "flow/core/flow_time.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define LATENCY_VARIABLE		"BENCH_FLOW_LATENCY_US"
+//! @endcond
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+static char deviceID[] = "bench-device";
+static char userID[] = "bench-user";
+static struct FlowMemoryManagerImpl *memoryManager = (struct FlowMemoryManagerImpl *)deviceID;
+static struct FlowDeviceImpl *device = (struct FlowDeviceImpl *)deviceID;
+static struct FlowUserImpl *user = (struct FlowUserImpl *)userID;
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Sleep for the simulated Flow round trip, if any.
+ */
+static void SimulateRoundTrip(void)
+{
+	const char *latency = getenv(LATENCY_VARIABLE);
+
+	if (latency != NULL && atoi(latency) > 0)
+	{
+		usleep(atoi(latency));
+	}
+}
+
+bool FlowCore_Initialise(void)
+{
+	return true;
+}
+
+void FlowCore_RegisterTypes(void)
+{
+}
+
+void FlowCore_Shutdown(void)
+{
+}
+
+bool FlowNVS_Set(const char *key, const void *value, size_t length)
+{
+	return true;
+}
+
+bool FlowClient_ConnectToServer(const char *url, const char *key, const char *secret,
+		bool remember)
+{
+	SimulateRoundTrip();
+	return true;
+}
+
+bool FlowClient_IsDeviceLoggedIn(void)
+{
+	return true;
+}
+
+FlowDevice FlowClient_GetLoggedInDevice(FlowMemoryManager manager)
+{
+	return device;
+}
+
+FlowMemoryManager FlowMemoryManager_New(void)
+{
+	return memoryManager;
+}
+
+void FlowMemoryManager_Free(FlowMemoryManager *manager)
+{
+	*manager = NULL;
+}
+
+FlowUser FlowDevice_RetrieveOwner(FlowDevice owned)
+{
+	return user;
+}
+
+FlowID FlowDevice_GetDeviceID(FlowDevice owned)
+{
+	return deviceID;
+}
+
+FlowID FlowUser_GetUserID(FlowUser owner)
+{
+	return userID;
+}
+
+bool FlowMessaging_Initialise(void)
+{
+	return true;
+}
+
+void FlowMessaging_Shutdown(void)
+{
+}
+
+bool FlowMessaging_SendMessageToUser(FlowID to, const char *contentType, const char *content,
+		size_t length, int expirySeconds)
+{
+	SimulateRoundTrip();
+	return true;
+}
+
+bool FlowMessaging_PublishToDeviceTopic(const char *topic, FlowID from, const char *contentType,
+		const char *content, size_t length, int expirySeconds)
+{
+	SimulateRoundTrip();
+	return true;
+}
+
+void *Flow_MemAlloc(size_t size)
+{
+	return calloc(1, size);
+}
+
+void Flow_MemFree(void **buffer)
+{
+	free(*buffer);
+	*buffer = NULL;
+}
+
+void Flow_GetTime(time_t *now)
+{
+	time(now);
+}
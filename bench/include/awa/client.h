@@ -0,0 +1,99 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file client.h
+ * @brief Stand-in for the Awa LWM2M client API, talking to the benchmark's stand-in client daemon.
+ */
+
+#ifndef AWA_CLIENT_H
+#define AWA_CLIENT_H
+
+#include "awa/common.h"
+
+typedef struct _AwaClientSession AwaClientSession;
+typedef struct _AwaClientDefineOperation AwaClientDefineOperation;
+typedef struct _AwaClientGetOperation AwaClientGetOperation;
+typedef struct _AwaClientGetResponse AwaClientGetResponse;
+typedef struct _AwaClientSetOperation AwaClientSetOperation;
+typedef struct _AwaClientSetResponse AwaClientSetResponse;
+typedef struct _AwaClientSubscribeOperation AwaClientSubscribeOperation;
+typedef struct _AwaClientChangeSubscription AwaClientChangeSubscription;
+
+typedef void (*AwaClientSubscriptionCallback)(const AwaChangeSet *changeSet, void *context);
+
+AwaClientSession *AwaClientSession_New(void);
+AwaError AwaClientSession_SetIPCAsUDP(AwaClientSession *session, const char *address,
+		unsigned short port);
+AwaError AwaClientSession_Connect(AwaClientSession *session);
+AwaError AwaClientSession_Disconnect(AwaClientSession *session);
+AwaError AwaClientSession_Free(AwaClientSession **session);
+AwaError AwaClientSession_Process(AwaClientSession *session, AwaTimeout timeout);
+AwaError AwaClientSession_DispatchCallbacks(AwaClientSession *session);
+bool AwaClientSession_IsObjectDefined(const AwaClientSession *session, AwaObjectID objectID);
+
+AwaClientDefineOperation *AwaClientDefineOperation_New(const AwaClientSession *session);
+AwaError AwaClientDefineOperation_Add(AwaClientDefineOperation *operation,
+		const AwaObjectDefinition *objectDefinition);
+AwaError AwaClientDefineOperation_Perform(AwaClientDefineOperation *operation,
+		AwaTimeout timeout);
+AwaError AwaClientDefineOperation_Free(AwaClientDefineOperation **operation);
+
+AwaClientGetOperation *AwaClientGetOperation_New(const AwaClientSession *session);
+AwaError AwaClientGetOperation_AddPath(AwaClientGetOperation *operation, const char *path);
+AwaError AwaClientGetOperation_Perform(AwaClientGetOperation *operation, AwaTimeout timeout);
+const AwaClientGetResponse *AwaClientGetOperation_GetResponse(
+		const AwaClientGetOperation *operation);
+bool AwaClientGetResponse_ContainsPath(const AwaClientGetResponse *response, const char *path);
+AwaError AwaClientGetOperation_Free(AwaClientGetOperation **operation);
+
+AwaClientSetOperation *AwaClientSetOperation_New(const AwaClientSession *session);
+AwaError AwaClientSetOperation_CreateObjectInstance(AwaClientSetOperation *operation,
+		const char *path);
+AwaError AwaClientSetOperation_AddValueAsBoolean(AwaClientSetOperation *operation,
+		const char *path, AwaBoolean value);
+AwaError AwaClientSetOperation_Perform(AwaClientSetOperation *operation, AwaTimeout timeout);
+const AwaClientSetResponse *AwaClientSetOperation_GetResponse(
+		const AwaClientSetOperation *operation);
+const AwaPathResult *AwaClientSetResponse_GetPathResult(const AwaClientSetResponse *response,
+		const char *path);
+AwaError AwaClientSetOperation_Free(AwaClientSetOperation **operation);
+
+AwaClientChangeSubscription *AwaClientChangeSubscription_New(const char *path,
+		AwaClientSubscriptionCallback callback, void *context);
+AwaError AwaClientChangeSubscription_Free(AwaClientChangeSubscription **subscription);
+AwaClientSubscribeOperation *AwaClientSubscribeOperation_New(const AwaClientSession *session);
+AwaError AwaClientSubscribeOperation_AddChangeSubscription(AwaClientSubscribeOperation *operation,
+		AwaClientChangeSubscription *subscription);
+AwaError AwaClientSubscribeOperation_Perform(AwaClientSubscribeOperation *operation,
+		AwaTimeout timeout);
+AwaError AwaClientSubscribeOperation_Free(AwaClientSubscribeOperation **operation);
+
+#endif	/* AWA_CLIENT_H */
@@ -0,0 +1,141 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file common.h
+ * @brief Stand-in for the Awa LWM2M API types shared by client and server sessions. Only what the
+ *        gateway uses is declared, so it can be benchmarked against the stand-in daemons of the
+ *        benchmark driver instead of awa_clientd and awa_serverd.
+ */
+
+#ifndef AWA_COMMON_H
+#define AWA_COMMON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int AwaObjectID;
+typedef int AwaObjectInstanceID;
+typedef int AwaResourceID;
+typedef int AwaResourceInstanceID;
+typedef int64_t AwaInteger;
+typedef bool AwaBoolean;
+typedef int32_t AwaTimeout;
+
+/**
+ * Result of an API call.
+ */
+typedef enum
+{
+	AwaError_Success,
+	AwaError_Unspecified,
+	AwaError_IPCError,
+	AwaError_Timeout,
+	AwaError_Response,
+	AwaError_PathNotFound,
+	AwaError_PathInvalid,
+	AwaError_SessionNotConnected,
+	AwaError_SessionInvalid,
+	AwaError_OperationInvalid,
+	AwaError_ClientNotFound,
+	AwaError_DefinitionInvalid
+}AwaError;
+
+/**
+ * Type of a resource.
+ */
+typedef enum
+{
+	AwaResourceType_Invalid,
+	AwaResourceType_Integer,
+	AwaResourceType_Boolean
+}AwaResourceType;
+
+/**
+ * Operations allowed on a resource.
+ */
+typedef enum
+{
+	AwaResourceOperations_ReadOnly,
+	AwaResourceOperations_WriteOnly,
+	AwaResourceOperations_ReadWrite
+}AwaResourceOperations;
+
+/**
+ * How a server write treats existing values.
+ */
+typedef enum
+{
+	AwaWriteMode_Replace,
+	AwaWriteMode_Update
+}AwaWriteMode;
+
+typedef struct _AwaObjectDefinition AwaObjectDefinition;
+typedef struct _AwaResourceDefinition AwaResourceDefinition;
+typedef struct _AwaPathResult AwaPathResult;
+typedef struct _AwaChangeSet AwaChangeSet;
+typedef struct _AwaPathIterator AwaPathIterator;
+typedef struct _AwaClientIterator AwaClientIterator;
+
+const char *AwaError_ToString(AwaError error);
+
+AwaError AwaAPI_MakeObjectPath(char *path, size_t pathSize, AwaObjectID objectID);
+AwaError AwaAPI_MakeObjectInstancePath(char *path, size_t pathSize, AwaObjectID objectID,
+		AwaObjectInstanceID objectInstanceID);
+
+AwaObjectDefinition *AwaObjectDefinition_New(AwaObjectID objectID, const char *objectName,
+		int minimumInstances, int maximumInstances);
+void AwaObjectDefinition_Free(AwaObjectDefinition **objectDefinition);
+AwaError AwaObjectDefinition_AddResourceDefinitionAsInteger(AwaObjectDefinition *objectDefinition,
+		AwaResourceID resourceID, const char *resourceName, bool isMandatory,
+		AwaResourceOperations operations, AwaInteger defaultValue);
+AwaError AwaObjectDefinition_AddResourceDefinitionAsBoolean(AwaObjectDefinition *objectDefinition,
+		AwaResourceID resourceID, const char *resourceName, bool isMandatory,
+		AwaResourceOperations operations, AwaBoolean *defaultValue);
+const AwaResourceDefinition *AwaObjectDefinition_GetResourceDefinition(
+		const AwaObjectDefinition *objectDefinition, AwaResourceID resourceID);
+
+AwaError AwaPathResult_GetError(const AwaPathResult *result);
+
+const char *AwaChangeSet_GetClientID(const AwaChangeSet *changeSet);
+AwaPathIterator *AwaChangeSet_NewPathIterator(const AwaChangeSet *changeSet);
+AwaError AwaChangeSet_GetValueAsIntegerPointer(const AwaChangeSet *changeSet, const char *path,
+		const AwaInteger **value);
+
+bool AwaPathIterator_Next(AwaPathIterator *iterator);
+const char *AwaPathIterator_Get(const AwaPathIterator *iterator);
+void AwaPathIterator_Free(AwaPathIterator **iterator);
+
+bool AwaClientIterator_Next(AwaClientIterator *iterator);
+const char *AwaClientIterator_GetClientID(const AwaClientIterator *iterator);
+void AwaClientIterator_Free(AwaClientIterator **iterator);
+
+#endif	/* AWA_COMMON_H */
@@ -0,0 +1,128 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file server.h
+ * @brief Stand-in for the Awa LWM2M server API, talking to the benchmark's stand-in server daemon.
+ */
+
+#ifndef AWA_SERVER_H
+#define AWA_SERVER_H
+
+#include "awa/common.h"
+
+typedef struct _AwaServerSession AwaServerSession;
+typedef struct _AwaServerDefineOperation AwaServerDefineOperation;
+typedef struct _AwaServerListClientsOperation AwaServerListClientsOperation;
+typedef struct _AwaServerWriteOperation AwaServerWriteOperation;
+typedef struct _AwaServerWriteResponse AwaServerWriteResponse;
+typedef struct _AwaServerObserveOperation AwaServerObserveOperation;
+typedef struct _AwaServerObserveResponse AwaServerObserveResponse;
+typedef struct _AwaServerObservation AwaServerObservation;
+typedef struct _AwaServerClientRegisterEvent AwaServerClientRegisterEvent;
+typedef struct _AwaServerClientUpdateEvent AwaServerClientUpdateEvent;
+typedef struct _AwaServerClientDeregisterEvent AwaServerClientDeregisterEvent;
+
+typedef void (*AwaServerObservationCallback)(const AwaChangeSet *changeSet, void *context);
+typedef void (*AwaServerClientRegisterEventCallback)(const AwaServerClientRegisterEvent *event,
+		void *context);
+typedef void (*AwaServerClientUpdateEventCallback)(const AwaServerClientUpdateEvent *event,
+		void *context);
+typedef void (*AwaServerClientDeregisterEventCallback)(const AwaServerClientDeregisterEvent *event,
+		void *context);
+
+AwaServerSession *AwaServerSession_New(void);
+AwaError AwaServerSession_SetIPCAsUDP(AwaServerSession *session, const char *address,
+		unsigned short port);
+AwaError AwaServerSession_Connect(AwaServerSession *session);
+AwaError AwaServerSession_Disconnect(AwaServerSession *session);
+AwaError AwaServerSession_Free(AwaServerSession **session);
+AwaError AwaServerSession_Process(AwaServerSession *session, AwaTimeout timeout);
+AwaError AwaServerSession_DispatchCallbacks(AwaServerSession *session);
+bool AwaServerSession_IsObjectDefined(const AwaServerSession *session, AwaObjectID objectID);
+const AwaObjectDefinition *AwaServerSession_GetObjectDefinition(const AwaServerSession *session,
+		AwaObjectID objectID);
+AwaError AwaServerSession_PathToIDs(const AwaServerSession *session, const char *path,
+		AwaObjectID *objectID, AwaObjectInstanceID *objectInstanceID, AwaResourceID *resourceID);
+AwaError AwaServerSession_SetClientRegisterEventCallback(AwaServerSession *session,
+		AwaServerClientRegisterEventCallback callback, void *context);
+AwaError AwaServerSession_SetClientUpdateEventCallback(AwaServerSession *session,
+		AwaServerClientUpdateEventCallback callback, void *context);
+AwaError AwaServerSession_SetClientDeregisterEventCallback(AwaServerSession *session,
+		AwaServerClientDeregisterEventCallback callback, void *context);
+
+AwaClientIterator *AwaServerClientRegisterEvent_NewClientIterator(
+		const AwaServerClientRegisterEvent *event);
+AwaClientIterator *AwaServerClientUpdateEvent_NewClientIterator(
+		const AwaServerClientUpdateEvent *event);
+AwaClientIterator *AwaServerClientDeregisterEvent_NewClientIterator(
+		const AwaServerClientDeregisterEvent *event);
+
+AwaServerDefineOperation *AwaServerDefineOperation_New(const AwaServerSession *session);
+AwaError AwaServerDefineOperation_Add(AwaServerDefineOperation *operation,
+		const AwaObjectDefinition *objectDefinition);
+AwaError AwaServerDefineOperation_Perform(AwaServerDefineOperation *operation,
+		AwaTimeout timeout);
+AwaError AwaServerDefineOperation_Free(AwaServerDefineOperation **operation);
+
+AwaServerListClientsOperation *AwaServerListClientsOperation_New(const AwaServerSession *session);
+AwaError AwaServerListClientsOperation_Perform(AwaServerListClientsOperation *operation,
+		AwaTimeout timeout);
+AwaClientIterator *AwaServerListClientsOperation_NewClientIterator(
+		const AwaServerListClientsOperation *operation);
+AwaError AwaServerListClientsOperation_Free(AwaServerListClientsOperation **operation);
+
+AwaServerWriteOperation *AwaServerWriteOperation_New(const AwaServerSession *session,
+		AwaWriteMode mode);
+AwaError AwaServerWriteOperation_AddValueAsBoolean(AwaServerWriteOperation *operation,
+		const char *path, AwaBoolean value);
+AwaError AwaServerWriteOperation_Perform(AwaServerWriteOperation *operation, const char *clientID,
+		AwaTimeout timeout);
+const AwaServerWriteResponse *AwaServerWriteOperation_GetResponse(
+		const AwaServerWriteOperation *operation, const char *clientID);
+const AwaPathResult *AwaServerWriteResponse_GetPathResult(
+		const AwaServerWriteResponse *response, const char *path);
+AwaError AwaServerWriteOperation_Free(AwaServerWriteOperation **operation);
+
+AwaServerObservation *AwaServerObservation_New(const char *clientID, const char *path,
+		AwaServerObservationCallback callback, void *context);
+AwaError AwaServerObservation_Free(AwaServerObservation **observation);
+AwaServerObserveOperation *AwaServerObserveOperation_New(const AwaServerSession *session);
+AwaError AwaServerObserveOperation_AddObservation(AwaServerObserveOperation *operation,
+		AwaServerObservation *observation);
+AwaError AwaServerObserveOperation_Perform(AwaServerObserveOperation *operation,
+		AwaTimeout timeout);
+const AwaServerObserveResponse *AwaServerObserveOperation_GetResponse(
+		const AwaServerObserveOperation *operation, const char *clientID);
+const AwaPathResult *AwaServerObserveResponse_GetPathResult(
+		const AwaServerObserveResponse *response, const char *path);
+AwaError AwaServerObserveOperation_Free(AwaServerObserveOperation **operation);
+
+#endif	/* AWA_SERVER_H */
@@ -0,0 +1,72 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file flowmessaging.h
+ * @brief Stand-in for the FlowCore and FlowMessaging APIs used by the gateway. Every call succeeds
+ *        at once, after an optional delay standing in for the cloud round trip.
+ */
+
+#ifndef FLOWMESSAGING_H
+#define FLOWMESSAGING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef char *FlowID;
+typedef struct FlowMemoryManagerImpl *FlowMemoryManager;
+typedef struct FlowDeviceImpl *FlowDevice;
+typedef struct FlowUserImpl *FlowUser;
+
+bool FlowCore_Initialise(void);
+void FlowCore_RegisterTypes(void);
+void FlowCore_Shutdown(void);
+bool FlowNVS_Set(const char *key, const void *value, size_t length);
+
+bool FlowClient_ConnectToServer(const char *url, const char *key, const char *secret,
+		bool remember);
+bool FlowClient_IsDeviceLoggedIn(void);
+FlowDevice FlowClient_GetLoggedInDevice(FlowMemoryManager memoryManager);
+
+FlowMemoryManager FlowMemoryManager_New(void);
+void FlowMemoryManager_Free(FlowMemoryManager *memoryManager);
+
+FlowUser FlowDevice_RetrieveOwner(FlowDevice device);
+FlowID FlowDevice_GetDeviceID(FlowDevice device);
+FlowID FlowUser_GetUserID(FlowUser user);
+
+bool FlowMessaging_Initialise(void);
+void FlowMessaging_Shutdown(void);
+bool FlowMessaging_SendMessageToUser(FlowID userID, const char *contentType, const char *content,
+		size_t length, int expirySeconds);
+bool FlowMessaging_PublishToDeviceTopic(const char *topic, FlowID deviceID,
+		const char *contentType, const char *content, size_t length, int expirySeconds);
+
+#endif	/* FLOWMESSAGING_H */
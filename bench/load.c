@@ -0,0 +1,259 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file load.c
+ * @brief Load generator driving button presses of a simulated fleet.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "load.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+/** Calculate size of array. */
+#define ARRAY_SIZE(x) ((sizeof x) / (sizeof *x))
+
+//! @cond Doxygen_Suppress
+#define RECOVERY_TIMEOUT		(60000)
+#define POLL_INTERVAL			(1)
+#define MS_PER_SECOND			(1000)
+#define NS_PER_MS				(1000000)
+#define NS_PER_SECOND			(1000000000L)
+//! @endcond
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+static const char *patternNames[] = {"steady", "bursty", "herd"};
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+bool Load_ParsePattern(const char *name, LoadPattern *pattern)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(patternNames); i++)
+	{
+		if (strcmp(name, patternNames[i]) == 0)
+		{
+			*pattern = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char *Load_PatternName(LoadPattern pattern)
+{
+	return patternNames[pattern];
+}
+
+/**
+ * @brief Get milliseconds on the monotonic clock.
+ * @return milliseconds.
+ */
+static long long NowMs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long)now.tv_sec * MS_PER_SECOND + now.tv_nsec / NS_PER_MS;
+}
+
+/**
+ * @brief Sleep until a time offset from a start time.
+ * @param *start start time on the monotonic clock.
+ * @param offsetNs offset from start, in nanoseconds.
+ */
+static void SleepUntil(const struct timespec *start, long long offsetNs)
+{
+	struct timespec until = *start;
+
+	until.tv_sec += offsetNs / NS_PER_SECOND;
+	until.tv_nsec += offsetNs % NS_PER_SECOND;
+	if (until.tv_nsec >= NS_PER_SECOND)
+	{
+		until.tv_nsec -= NS_PER_SECOND;
+		until.tv_sec++;
+	}
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR)
+	{
+	}
+}
+
+/**
+ * @brief Press the button of a device and count the outcome.
+ * @param *server server daemon.
+ * @param index device index.
+ * @param *result counts to update.
+ */
+static void Press(StandinDaemon *server, unsigned int index, LoadResult *result)
+{
+	if (StandinDaemon_Press(server, index))
+	{
+		result->presses++;
+	}
+	else
+	{
+		result->failed++;
+	}
+}
+
+/**
+ * @brief Press random buttons in bursts spaced to average the rate. A burst of one press is
+ *        the steady pattern.
+ * @param *server server daemon.
+ * @param *config settings.
+ * @param burst presses per burst.
+ * @param *result counts to update.
+ */
+static void RunBursts(StandinDaemon *server, const LoadConfig *config, unsigned int burst,
+		LoadResult *result)
+{
+	unsigned long total = config->rate * config->duration;
+	double intervalNs = burst * NS_PER_SECOND / config->rate;
+	unsigned int seed = config->seed;
+	unsigned long i;
+	struct timespec start;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < total; i++)
+	{
+		Press(server, rand_r(&seed) % server->fleet->count, result);
+		if ((i + 1) % burst == 0)
+		{
+			SleepUntil(&start, intervalNs * ((i + 1) / burst));
+		}
+	}
+}
+
+/**
+ * @brief Cut the power of the whole fleet, bring it back with registrations spread randomly
+ *        over the window, wait for every button to be observed again and press them all at once,
+ *        as counters that changed while the gateway could not see them.
+ * @param *server server daemon.
+ * @param *config settings.
+ * @param *result counts and recovery time to update.
+ */
+static void RunHerd(StandinDaemon *server, const LoadConfig *config, LoadResult *result)
+{
+	StandinFleet *fleet = server->fleet;
+	unsigned int *order = malloc(fleet->count * sizeof(*order));
+	unsigned int seed = config->seed;
+	unsigned int i, observed;
+	long long powerOn, deadline;
+	struct timespec start;
+
+	result->recoveryMs = -1;
+	if (order == NULL)
+	{
+		return;
+	}
+
+	for (i = 0; i < fleet->count; i++)
+	{
+		StandinDaemon_SetRegistered(server, i, false);
+		order[i] = i;
+	}
+	usleep(config->outage * MS_PER_SECOND);
+
+	/* Devices boot in random order */
+	for (i = fleet->count - 1; i > 0; i--)
+	{
+		unsigned int j = rand_r(&seed) % (i + 1);
+		unsigned int swap = order[i];
+
+		order[i] = order[j];
+		order[j] = swap;
+	}
+
+	powerOn = NowMs();
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < fleet->count; i++)
+	{
+		SleepUntil(&start, (long long)config->window * NS_PER_MS * i / fleet->count);
+		StandinDaemon_SetRegistered(server, order[i], true);
+	}
+
+	deadline = powerOn + config->window + RECOVERY_TIMEOUT;
+	do
+	{
+		pthread_mutex_lock(&fleet->lock);
+		observed = fleet->observed;
+		pthread_mutex_unlock(&fleet->lock);
+		usleep(POLL_INTERVAL * MS_PER_SECOND);
+	}
+	while (observed < fleet->count && NowMs() < deadline);
+
+	if (observed == fleet->count)
+	{
+		result->recoveryMs = NowMs() - powerOn;
+	}
+
+	for (i = 0; i < fleet->count; i++)
+	{
+		Press(server, order[i], result);
+	}
+	free(order);
+}
+
+void Load_Run(StandinDaemon *server, const LoadConfig *config, LoadResult *result)
+{
+	memset(result, 0, sizeof(*result));
+
+	switch (config->pattern)
+	{
+		case LoadPattern_Steady:
+			RunBursts(server, config, 1, result);
+			break;
+		case LoadPattern_Bursty:
+			RunBursts(server, config, config->burst, result);
+			break;
+		case LoadPattern_Herd:
+			RunHerd(server, config, result);
+			break;
+	}
+}
@@ -0,0 +1,106 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file load.h
+ * @brief Header file for the load generator, which drives button presses of a simulated fleet
+ *        with a steady, bursty or thundering herd pattern.
+ */
+
+#ifndef LOAD_H
+#define LOAD_H
+
+#include <stdbool.h>
+
+#include "standin_daemon.h"
+
+/**
+ * Pattern of button presses.
+ */
+typedef enum
+{
+	LoadPattern_Steady, /**< presses evenly spaced at the rate */
+	LoadPattern_Bursty, /**< bursts of presses back to back, spaced to average the rate */
+	LoadPattern_Herd /**< power cut, the fleet re-registers and every button changes at once */
+}LoadPattern;
+
+/**
+ * A structure to contain the load generator settings.
+ */
+typedef struct
+{
+	/*@{*/
+	LoadPattern pattern; /**< pattern of presses */
+	double rate; /**< presses per second over the fleet, steady and bursty */
+	unsigned int duration; /**< seconds to press for, steady and bursty */
+	unsigned int burst; /**< presses per burst, bursty */
+	unsigned int outage; /**< milliseconds the fleet is powered off, herd */
+	unsigned int window; /**< milliseconds the fleet re-registers over, herd */
+	unsigned int seed; /**< seed of the device choice */
+	/*@}*/
+}LoadConfig;
+
+/**
+ * A structure to contain what the load generator did.
+ */
+typedef struct
+{
+	/*@{*/
+	unsigned long presses; /**< presses notified */
+	unsigned long failed; /**< presses of devices not observed */
+	long long recoveryMs; /**< herd, from power on to every button observed, -1 if never */
+	/*@}*/
+}LoadResult;
+
+/**
+ * @brief Get the pattern of a name.
+ * @param *name steady, bursty or herd.
+ * @param *pattern set to the pattern.
+ * @return true if the name is known, else false.
+ */
+bool Load_ParsePattern(const char *name, LoadPattern *pattern);
+
+/**
+ * @brief Get the name of a pattern.
+ * @param pattern pattern.
+ * @return name.
+ */
+const char *Load_PatternName(LoadPattern pattern);
+
+/**
+ * @brief Drive button presses of the fleet served by a server daemon. Returns once the last
+ *        press is notified.
+ * @param *server server daemon.
+ * @param *config settings.
+ * @param *result filled with what was done.
+ */
+void Load_Run(StandinDaemon *server, const LoadConfig *config, LoadResult *result);
+
+#endif	/* LOAD_H */
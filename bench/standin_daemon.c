@@ -0,0 +1,700 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file standin_daemon.c
+ * @brief Stand-in Awa server and client daemons, speaking the protocol of standin_protocol.h.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "standin_daemon.h"
+#include "standin_protocol.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define POLL_INTERVAL		(100)
+#define NS_PER_SECOND		(1000000000ULL)
+#define NS_PER_US			(1000)
+#define WORD_SEPARATORS		" \n"
+#define REPLY_HEADER_SIZE	(32)
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Get nanoseconds on the monotonic clock.
+ * @return nanoseconds.
+ */
+static uint64_t NowNs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * NS_PER_SECOND + now.tv_nsec;
+}
+
+/**
+ * @brief Record the latency of a press that reached a device's led, once per press.
+ * @param *histogram histogram to record to.
+ * @param *pressNs time of the press, cleared.
+ */
+static void RecordPress(Histogram *histogram, uint64_t *pressNs)
+{
+	if (*pressNs != 0)
+	{
+		Histogram_Record(histogram, (NowNs() - *pressNs) / NS_PER_US);
+		*pressNs = 0;
+	}
+}
+
+/**
+ * @brief Find the device a client name stands for.
+ * @param *fleet devices.
+ * @param *clientID client name.
+ * @return device, or NULL if there is no such device.
+ */
+static StandinDevice *FindDevice(StandinFleet *fleet, const char *clientID)
+{
+	size_t prefixLength = strlen(STANDIN_DEVICE_PREFIX);
+	char *end;
+	unsigned long index;
+
+	if (strncmp(clientID, STANDIN_DEVICE_PREFIX, prefixLength) != 0)
+	{
+		return NULL;
+	}
+
+	index = strtoul(clientID + prefixLength, &end, 10);
+	if (end == clientID + prefixLength || *end != '\0' || index >= fleet->count)
+	{
+		return NULL;
+	}
+	return &fleet->devices[index];
+}
+
+/**
+ * @brief Find the session requests from an address come from.
+ * @param *daemon daemon.
+ * @param *from request address.
+ * @return session, or NULL if not connected.
+ */
+static StandinSession *FindSession(StandinDaemon *daemon, const struct sockaddr_in *from)
+{
+	unsigned int i;
+
+	for (i = 0; i < daemon->numSessions; i++)
+	{
+		if (daemon->sessions[i].request.sin_port == from->sin_port &&
+			daemon->sessions[i].request.sin_addr.s_addr == from->sin_addr.s_addr)
+		{
+			return &daemon->sessions[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Connect a session, replacing an earlier one from the same address.
+ * @param *daemon daemon.
+ * @param *from request address.
+ * @param *port notify port of the session.
+ * @return status to answer.
+ */
+static const char *Connect(StandinDaemon *daemon, const struct sockaddr_in *from, const char *port)
+{
+	StandinSession *session = FindSession(daemon, from);
+
+	if (port == NULL)
+	{
+		return STANDIN_STATUS_ERROR;
+	}
+
+	if (session == NULL)
+	{
+		if (daemon->numSessions == STANDIN_MAX_SESSIONS)
+		{
+			return STANDIN_STATUS_ERROR;
+		}
+		session = &daemon->sessions[daemon->numSessions];
+		pthread_mutex_lock(&daemon->fleet->lock);
+		daemon->numSessions++;
+		pthread_mutex_unlock(&daemon->fleet->lock);
+	}
+
+	pthread_mutex_lock(&daemon->fleet->lock);
+	session->request = *from;
+	session->notify = *from;
+	session->notify.sin_port = htons(atoi(port));
+	pthread_mutex_unlock(&daemon->fleet->lock);
+	return STANDIN_STATUS_OK;
+}
+
+/**
+ * @brief Forget a session and the observations it made.
+ * @param *daemon daemon.
+ * @param *from request address.
+ */
+static void Disconnect(StandinDaemon *daemon, const struct sockaddr_in *from)
+{
+	StandinSession *session = FindSession(daemon, from);
+	StandinFleet *fleet = daemon->fleet;
+	unsigned int i;
+
+	if (session == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&fleet->lock);
+	for (i = 0; i < fleet->count; i++)
+	{
+		StandinDevice *device = &fleet->devices[i];
+
+		if (device->observed && device->observer.sin_port == session->notify.sin_port)
+		{
+			device->observed = false;
+			fleet->observed--;
+		}
+	}
+	*session = daemon->sessions[--daemon->numSessions];
+	pthread_mutex_unlock(&fleet->lock);
+}
+
+/**
+ * @brief Add object definitions to those sent to connecting sessions, and keep the maximum
+ *        instances of the led object for instance creation.
+ * @param *daemon daemon.
+ * @param *definitions definitions of the DEFINE request, modified.
+ * @return status to answer.
+ */
+static const char *Define(StandinDaemon *daemon, char *definitions)
+{
+	size_t length = strlen(daemon->definitions);
+	char *save = NULL;
+	char *word;
+
+	if (length + strlen(definitions) + 1 >= STANDIN_DEFINITIONS_SIZE)
+	{
+		return STANDIN_STATUS_ERROR;
+	}
+	snprintf(daemon->definitions + length, STANDIN_DEFINITIONS_SIZE - length, " %s", definitions);
+
+	for (word = strtok_r(definitions, WORD_SEPARATORS, &save); word != NULL;
+		word = strtok_r(NULL, WORD_SEPARATORS, &save))
+	{
+		unsigned int objectID, maximumInstances;
+
+		if (sscanf(word, "%u/%u:", &objectID, &maximumInstances) == 2 &&
+			objectID == STANDIN_LED_OBJECT_ID)
+		{
+			daemon->ledInstances = maximumInstances;
+		}
+	}
+	return STANDIN_STATUS_OK;
+}
+
+/**
+ * @brief Observe device buttons for a session.
+ * @param *daemon server daemon.
+ * @param *session observing session.
+ * @param *paths client and path pairs, modified.
+ * @param *results filled with a status per pair.
+ * @param size size of results.
+ * @return status to answer.
+ */
+static const char *Observe(StandinDaemon *daemon, const StandinSession *session, char *paths,
+		char *results, size_t size)
+{
+	StandinFleet *fleet = daemon->fleet;
+	size_t length = 0;
+	char *save = NULL;
+	char *clientID;
+	char *path;
+
+	if (session == NULL)
+	{
+		return STANDIN_STATUS_ERROR;
+	}
+
+	pthread_mutex_lock(&fleet->lock);
+	while ((clientID = strtok_r(length ? NULL : paths, WORD_SEPARATORS, &save)) != NULL &&
+		(path = strtok_r(NULL, WORD_SEPARATORS, &save)) != NULL && length < size)
+	{
+		StandinDevice *device = FindDevice(fleet, clientID);
+		bool found = (device != NULL && device->registered &&
+				strcmp(path, STANDIN_BUTTON_PATH) == 0);
+
+		if (found)
+		{
+			fleet->observed += !device->observed;
+			device->observed = true;
+			device->observer = session->notify;
+		}
+		length += snprintf(results + length, size - length, " %s",
+				found ? STANDIN_STATUS_OK : STANDIN_STATUS_NOTFOUND);
+	}
+	pthread_mutex_unlock(&fleet->lock);
+	return STANDIN_STATUS_OK;
+}
+
+/**
+ * @brief Write resources of a device, recording the latency of the press that led to a led
+ *        write. Each path is answered on its own, so one unknown path doesn't fail the others.
+ * @param *fleet devices.
+ * @param *arguments device followed by path and value pairs, modified.
+ * @param *results filled with the status of each path.
+ * @param size size of results.
+ * @return status to answer.
+ */
+static const char *Write(StandinFleet *fleet, char *arguments, char *results, size_t size)
+{
+	StandinDevice *device;
+	size_t length = 0;
+	char *save = NULL;
+	char *clientID = strtok_r(arguments, WORD_SEPARATORS, &save);
+	char *path;
+	char *value;
+
+	if (clientID == NULL)
+	{
+		return STANDIN_STATUS_ERROR;
+	}
+
+	pthread_mutex_lock(&fleet->lock);
+	device = FindDevice(fleet, clientID);
+	if (device == NULL || !device->registered)
+	{
+		pthread_mutex_unlock(&fleet->lock);
+		return STANDIN_STATUS_NOCLIENT;
+	}
+
+	while ((path = strtok_r(NULL, WORD_SEPARATORS, &save)) != NULL &&
+		(value = strtok_r(NULL, WORD_SEPARATORS, &save)) != NULL && length < size)
+	{
+		bool found = (strcmp(path, STANDIN_LED_PATH) == 0);
+
+		if (found)
+		{
+			RecordPress(&fleet->writeLatency, &device->writeNs[atoi(value) != 0]);
+			fleet->writes++;
+		}
+		length += snprintf(results + length, size - length, " %s",
+				found ? STANDIN_STATUS_OK : STANDIN_STATUS_NOTFOUND);
+	}
+	pthread_mutex_unlock(&fleet->lock);
+	return STANDIN_STATUS_OK;
+}
+
+/**
+ * @brief Get the device a local led instance path mirrors. Instances are numbered in order of
+ *        first appearance in the bindings, which the driver writes in device order.
+ * @param *fleet devices.
+ * @param *path local led instance or resource path.
+ * @return device, or NULL if the path is not a local led.
+ */
+static StandinDevice *FindLocalLed(StandinFleet *fleet, const char *path)
+{
+	unsigned int objectID, instanceID;
+
+	if (sscanf(path, "/%u/%u", &objectID, &instanceID) != 2 ||
+		objectID != STANDIN_LED_OBJECT_ID || instanceID >= fleet->count)
+	{
+		return NULL;
+	}
+	return &fleet->devices[instanceID];
+}
+
+/**
+ * @brief Report which paths exist on the client daemon. Objects other than the led object, like
+ *        the Flow access object, are taken as provisioned.
+ * @param *fleet devices.
+ * @param *paths requested paths, modified.
+ * @param *results filled with the paths that exist.
+ * @param size size of results.
+ * @return status to answer.
+ */
+static const char *Get(StandinFleet *fleet, char *paths, char *results, size_t size)
+{
+	size_t length = 0;
+	char *save = NULL;
+	char *path;
+	unsigned int objectID;
+
+	pthread_mutex_lock(&fleet->lock);
+	for (path = strtok_r(paths, WORD_SEPARATORS, &save); path != NULL && length < size;
+		path = strtok_r(NULL, WORD_SEPARATORS, &save))
+	{
+		StandinDevice *device = FindLocalLed(fleet, path);
+
+		if ((device != NULL && device->instanceCreated) ||
+			(sscanf(path, "/%u", &objectID) == 1 && objectID != STANDIN_LED_OBJECT_ID))
+		{
+			length += snprintf(results + length, size - length, " %s", path);
+		}
+	}
+	pthread_mutex_unlock(&fleet->lock);
+	return STANDIN_STATUS_OK;
+}
+
+/**
+ * @brief Set a local led, creating its instance first if asked to, and record the latency of
+ *        the press that led to it. Like the real daemon, instances beyond the maximum of the led
+ *        object definition can't be created.
+ * @param *fleet devices.
+ * @param maximumInstances maximum instances of the led object.
+ * @param *createPath instance to create, or "-".
+ * @param *path set resource.
+ * @param *value set value.
+ * @return status to answer.
+ */
+static const char *Set(StandinFleet *fleet, unsigned int maximumInstances,
+		const char *createPath, const char *path, const char *value)
+{
+	StandinDevice *device;
+	const char *status = STANDIN_STATUS_OK;
+	unsigned int objectID, instanceID;
+
+	if (createPath == NULL || path == NULL || value == NULL)
+	{
+		return STANDIN_STATUS_ERROR;
+	}
+
+	if (sscanf(createPath, "/%u/%u", &objectID, &instanceID) == 2 &&
+		objectID == STANDIN_LED_OBJECT_ID && instanceID >= maximumInstances)
+	{
+		return STANDIN_STATUS_ERROR;
+	}
+
+	pthread_mutex_lock(&fleet->lock);
+	device = FindLocalLed(fleet, path);
+	if (device == NULL)
+	{
+		status = STANDIN_STATUS_NOTFOUND;
+	}
+	else
+	{
+		device->instanceCreated |= (strcmp(createPath, "-") != 0);
+		if (!device->instanceCreated)
+		{
+			status = STANDIN_STATUS_NOTFOUND;
+		}
+		else
+		{
+			RecordPress(&fleet->setLatency, &device->setNs[atoi(value) != 0]);
+			fleet->sets++;
+		}
+	}
+	pthread_mutex_unlock(&fleet->lock);
+	return status;
+}
+
+/**
+ * @brief Serve one request and send its answer.
+ * @param *daemon daemon.
+ * @param *request received datagram, modified.
+ * @param *from address of the requesting session.
+ */
+static void HandleRequest(StandinDaemon *daemon, char *request, const struct sockaddr_in *from)
+{
+	char results[STANDIN_DATAGRAM_SIZE - REPLY_HEADER_SIZE];
+	char reply[STANDIN_DATAGRAM_SIZE];
+	const char *status = STANDIN_STATUS_ERROR;
+	char *save = NULL;
+	char *id = strtok_r(request, WORD_SEPARATORS, &save);
+	char *verb = strtok_r(NULL, WORD_SEPARATORS, &save);
+	char *arguments = save != NULL ? save : "";
+	int length;
+
+	if (id == NULL || verb == NULL)
+	{
+		return;
+	}
+
+	results[0] = '\0';
+	if (strcmp(verb, "CONNECT") == 0)
+	{
+		status = Connect(daemon, from, strtok_r(NULL, WORD_SEPARATORS, &save));
+		snprintf(results, sizeof(results), "%s", daemon->definitions);
+	}
+	else if (strcmp(verb, "DISCONNECT") == 0)
+	{
+		Disconnect(daemon, from);
+		return;
+	}
+	else if (strcmp(verb, "DEFINE") == 0)
+	{
+		status = Define(daemon, arguments);
+	}
+	else if (strcmp(verb, "SUBSCRIBE") == 0)
+	{
+		status = STANDIN_STATUS_OK;
+	}
+	else if (daemon->role == StandinRole_Server && strcmp(verb, "LIST") == 0)
+	{
+		unsigned int i;
+		size_t used = 0;
+
+		pthread_mutex_lock(&daemon->fleet->lock);
+		for (i = 0; i < daemon->fleet->count && used < sizeof(results); i++)
+		{
+			if (daemon->fleet->devices[i].registered)
+			{
+				used += snprintf(results + used, sizeof(results) - used, " %s%u",
+						STANDIN_DEVICE_PREFIX, i);
+			}
+		}
+		pthread_mutex_unlock(&daemon->fleet->lock);
+		status = STANDIN_STATUS_OK;
+	}
+	else if (daemon->role == StandinRole_Server && strcmp(verb, "OBSERVE") == 0)
+	{
+		status = Observe(daemon, FindSession(daemon, from), arguments, results, sizeof(results));
+	}
+	else if (daemon->role == StandinRole_Server && strcmp(verb, "WRITE") == 0)
+	{
+		status = Write(daemon->fleet, arguments, results, sizeof(results));
+	}
+	else if (daemon->role == StandinRole_Client && strcmp(verb, "GET") == 0)
+	{
+		status = Get(daemon->fleet, arguments, results, sizeof(results));
+	}
+	else if (daemon->role == StandinRole_Client && strcmp(verb, "SET") == 0)
+	{
+		char *createPath = strtok_r(NULL, WORD_SEPARATORS, &save);
+		char *path = strtok_r(NULL, WORD_SEPARATORS, &save);
+
+		status = Set(daemon->fleet, daemon->ledInstances, createPath, path,
+				strtok_r(NULL, WORD_SEPARATORS, &save));
+	}
+
+	length = snprintf(reply, sizeof(reply), "%s %s%s", id, status, results);
+	sendto(daemon->fd, reply, length, 0, (const struct sockaddr *)from, sizeof(*from));
+}
+
+/**
+ * @brief Serve requests until the daemon is stopped.
+ * @param *context daemon.
+ * @return NULL.
+ */
+static void *Serve(void *context)
+{
+	StandinDaemon *daemon = context;
+	char request[STANDIN_DATAGRAM_SIZE];
+	struct pollfd poller = {daemon->fd, POLLIN, 0};
+
+	while (__atomic_load_n(&daemon->running, __ATOMIC_ACQUIRE))
+	{
+		struct sockaddr_in from;
+		socklen_t fromLength = sizeof(from);
+		ssize_t received;
+
+		if (poll(&poller, 1, POLL_INTERVAL) <= 0)
+		{
+			continue;
+		}
+
+		received = recvfrom(daemon->fd, request, sizeof(request) - 1, 0,
+				(struct sockaddr *)&from, &fromLength);
+		if (received > 0)
+		{
+			request[received] = '\0';
+			HandleRequest(daemon, request, &from);
+		}
+	}
+	return NULL;
+}
+
+bool StandinFleet_Init(StandinFleet *fleet, unsigned int count)
+{
+	unsigned int i;
+
+	memset(fleet, 0, sizeof(*fleet));
+
+	if (count == 0 || count > STANDIN_MAX_DEVICES)
+	{
+		return false;
+	}
+
+	fleet->devices = calloc(count, sizeof(*fleet->devices));
+	if (fleet->devices == NULL)
+	{
+		return false;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		fleet->devices[i].registered = true;
+	}
+
+	pthread_mutex_init(&fleet->lock, NULL);
+	fleet->count = count;
+	fleet->registered = count;
+	Histogram_Init(&fleet->writeLatency, "server write");
+	Histogram_Init(&fleet->setLatency, "client set");
+	return true;
+}
+
+void StandinFleet_Free(StandinFleet *fleet)
+{
+	pthread_mutex_destroy(&fleet->lock);
+	free(fleet->devices);
+	fleet->devices = NULL;
+	fleet->count = 0;
+}
+
+bool StandinDaemon_Start(StandinDaemon *daemon, StandinRole role, StandinFleet *fleet)
+{
+	struct sockaddr_in address;
+
+	memset(daemon, 0, sizeof(*daemon));
+	daemon->role = role;
+	daemon->fleet = fleet;
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(role == StandinRole_Server ? STANDIN_SERVER_PORT :
+			STANDIN_CLIENT_PORT);
+	inet_pton(AF_INET, STANDIN_ADDRESS, &address.sin_addr);
+
+	daemon->fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (daemon->fd < 0)
+	{
+		return false;
+	}
+
+	if (bind(daemon->fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+	{
+		fprintf(stderr, "Failed to bind port %u: %s\n", ntohs(address.sin_port),
+				strerror(errno));
+		close(daemon->fd);
+		return false;
+	}
+
+	daemon->running = true;
+	if (pthread_create(&daemon->thread, NULL, Serve, daemon) != 0)
+	{
+		close(daemon->fd);
+		return false;
+	}
+	return true;
+}
+
+void StandinDaemon_Stop(StandinDaemon *daemon)
+{
+	__atomic_store_n(&daemon->running, false, __ATOMIC_RELEASE);
+	pthread_join(daemon->thread, NULL);
+	close(daemon->fd);
+	daemon->fd = -1;
+}
+
+bool StandinDaemon_Press(StandinDaemon *server, unsigned int index)
+{
+	StandinFleet *fleet = server->fleet;
+	StandinDevice *device = &fleet->devices[index];
+	struct sockaddr_in observer;
+	char notification[STANDIN_NAME_SIZE + STANDIN_PATH_SIZE + 32];
+	int length;
+	uint64_t now;
+
+	pthread_mutex_lock(&fleet->lock);
+	if (!device->observed)
+	{
+		pthread_mutex_unlock(&fleet->lock);
+		return false;
+	}
+
+	device->counter++;
+	now = NowNs();
+	device->writeNs[device->counter % 2] = now;
+	device->setNs[device->counter % 2] = now;
+	observer = device->observer;
+	length = snprintf(notification, sizeof(notification), "NOTIFY %s%u %s %lld",
+			STANDIN_DEVICE_PREFIX, index, STANDIN_BUTTON_PATH, (long long)device->counter);
+	pthread_mutex_unlock(&fleet->lock);
+
+	return sendto(server->fd, notification, length, 0, (struct sockaddr *)&observer,
+			sizeof(observer)) == length;
+}
+
+void StandinDaemon_SetRegistered(StandinDaemon *server, unsigned int index, bool registered)
+{
+	StandinFleet *fleet = server->fleet;
+	StandinDevice *device = &fleet->devices[index];
+	char notification[STANDIN_NAME_SIZE + 16];
+	unsigned int i;
+	int length;
+
+	pthread_mutex_lock(&fleet->lock);
+	if (device->registered != registered)
+	{
+		device->registered = registered;
+		if (registered)
+		{
+			fleet->registered++;
+		}
+		else
+		{
+			fleet->registered--;
+		}
+	}
+
+	if (!registered && device->observed)
+	{
+		device->observed = false;
+		fleet->observed--;
+	}
+
+	length = snprintf(notification, sizeof(notification), "%s %s%u",
+			registered ? "REGISTER" : "DEREGISTER", STANDIN_DEVICE_PREFIX, index);
+	for (i = 0; i < server->numSessions; i++)
+	{
+		sendto(server->fd, notification, length, 0,
+				(struct sockaddr *)&server->sessions[i].notify, sizeof(server->sessions[i].notify));
+	}
+	pthread_mutex_unlock(&fleet->lock);
+}
@@ -0,0 +1,180 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file standin_daemon.h
+ * @brief Header file for the stand-in Awa server and client daemons run by the benchmark driver.
+ *        The server daemon serves a fleet of simulated devices, each with a button and a led,
+ *        and the client daemon serves the gateway's own objects. Both time how long a button
+ *        press takes to reach them as a write or set of the led it drives.
+ */
+
+#ifndef STANDIN_DAEMON_H
+#define STANDIN_DAEMON_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <netinet/in.h>
+
+#include "histogram.h"
+
+//! @cond Doxygen_Suppress
+#define STANDIN_MAX_DEVICES			(4000)
+#define STANDIN_MAX_SESSIONS		(16)
+#define STANDIN_DEFINITIONS_SIZE	(1024)
+#define STANDIN_DEVICE_PREFIX		"BenchDevice"
+#define STANDIN_BUTTON_PATH			"/3200/0/5501"
+#define STANDIN_LED_PATH			"/3311/0/5850"
+#define STANDIN_LED_OBJECT_ID		(3311)
+//! @endcond
+
+/**
+ * Daemon a stand-in plays.
+ */
+typedef enum
+{
+	StandinRole_Server, /**< lwm2m server daemon, talks to the devices */
+	StandinRole_Client /**< lwm2m client daemon, holds the gateway's own objects */
+}StandinRole;
+
+/**
+ * A structure to contain one simulated device.
+ */
+typedef struct
+{
+	/*@{*/
+	int64_t counter; /**< button counter, its parity is the led value it drives */
+	uint64_t writeNs[2]; /**< time of the last press not yet written, per led value, or 0 */
+	uint64_t setNs[2]; /**< time of the last press not yet set locally, per led value, or 0 */
+	bool registered; /**< true while registered with the server daemon */
+	bool observed; /**< true once the gateway observes the button */
+	struct sockaddr_in observer; /**< notify address of the observing session */
+	bool instanceCreated; /**< true once the gateway created its local led instance */
+	/*@}*/
+}StandinDevice;
+
+/**
+ * A structure to contain the devices and results shared by the daemons and the driver. Every
+ * member, and the sessions of the daemons serving the fleet, are protected by lock.
+ */
+typedef struct
+{
+	/*@{*/
+	pthread_mutex_t lock; /**< protects the fleet */
+	StandinDevice *devices; /**< simulated devices */
+	unsigned int count; /**< number of devices */
+	unsigned int registered; /**< devices registered */
+	unsigned int observed; /**< devices whose button is observed */
+	unsigned long writes; /**< led writes received by the server daemon */
+	unsigned long sets; /**< led sets received by the client daemon */
+	Histogram writeLatency; /**< press to server write */
+	Histogram setLatency; /**< press to client set */
+	/*@}*/
+}StandinFleet;
+
+/**
+ * A structure to contain a session connected to a daemon.
+ */
+typedef struct
+{
+	/*@{*/
+	struct sockaddr_in request; /**< address requests come from */
+	struct sockaddr_in notify; /**< address notifications go to */
+	/*@}*/
+}StandinSession;
+
+/**
+ * A structure to contain one stand-in daemon.
+ */
+typedef struct
+{
+	/*@{*/
+	StandinRole role; /**< daemon played */
+	StandinFleet *fleet; /**< devices served */
+	int fd; /**< socket bound to the daemon port */
+	pthread_t thread; /**< serving thread */
+	bool running; /**< cleared to stop the thread */
+	StandinSession sessions[STANDIN_MAX_SESSIONS]; /**< connected sessions */
+	unsigned int numSessions; /**< number of sessions */
+	char definitions[STANDIN_DEFINITIONS_SIZE]; /**< defined objects, as sent on CONNECT */
+	unsigned int ledInstances; /**< maximum instances of the led object, 0 until defined */
+	/*@}*/
+}StandinDaemon;
+
+/**
+ * @brief Create a fleet of devices named STANDIN_DEVICE_PREFIX followed by their index. Every
+ *        device starts registered.
+ * @param *fleet fleet to initialize.
+ * @param count number of devices, at most STANDIN_MAX_DEVICES.
+ * @return true on success, else false.
+ */
+bool StandinFleet_Init(StandinFleet *fleet, unsigned int count);
+
+/**
+ * @brief Free the devices of a fleet.
+ * @param *fleet fleet to free.
+ */
+void StandinFleet_Free(StandinFleet *fleet);
+
+/**
+ * @brief Bind a daemon to its port and start serving.
+ * @param *daemon daemon to start.
+ * @param role daemon to play.
+ * @param *fleet devices served, shared with the other daemon.
+ * @return true on success, else false.
+ */
+bool StandinDaemon_Start(StandinDaemon *daemon, StandinRole role, StandinFleet *fleet);
+
+/**
+ * @brief Stop serving and close the daemon's socket.
+ * @param *daemon daemon to stop.
+ */
+void StandinDaemon_Stop(StandinDaemon *daemon);
+
+/**
+ * @brief Press the button of a device, notifying the session observing it.
+ * @param *server server daemon.
+ * @param index device index.
+ * @return true if the press was notified, false if the button is not observed.
+ */
+bool StandinDaemon_Press(StandinDaemon *server, unsigned int index);
+
+/**
+ * @brief Register a device, or deregister it as if it lost power. Every session of the server
+ *        daemon is notified. A deregistered device is no longer listed and loses its
+ *        observation.
+ * @param *server server daemon.
+ * @param index device index.
+ * @param registered true to register, false to deregister.
+ */
+void StandinDaemon_SetRegistered(StandinDaemon *server, unsigned int index, bool registered);
+
+#endif	/* STANDIN_DAEMON_H */
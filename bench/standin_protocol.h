@@ -0,0 +1,80 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file standin_protocol.h
+ * @brief Datagram protocol between the stand-in Awa library linked into the gateway and the
+ *        stand-in daemons run by the benchmark driver. It keeps what matters for timing from the
+ *        real Awa IPC: sessions talk UDP to the daemon ports, operations are request and
+ *        response, and notifications arrive on a socket of their own that wakes the event loop.
+ *
+ *        Every datagram is one line of space separated words. Requests from a session are
+ *        "<id> <verb> <arguments>" and are answered with "<id> <status> <results>", status being
+ *        one of the STANDIN_STATUS strings:
+ *
+ *        CONNECT <notify port>                        OK <object>/<maximum instances>:
+ *                                                     <resource>,... for every defined object
+ *        DISCONNECT                                   not answered
+ *        DEFINE <object>/<maximum instances>:         OK
+ *               <resource>,... ...
+ *        LIST                                         OK <client> ...
+ *        OBSERVE <client> <path> ...                  OK followed by OK or NOTFOUND for each
+ *                                                     path
+ *        WRITE <client> <path> <0|1> ...              OK followed by OK or NOTFOUND for each
+ *                                                     path, or NOCLIENT
+ *        GET <path> ...                               OK <path> ... for paths that exist
+ *        SET <create instance path|-> <path> <0|1>    OK, NOTFOUND, or ERROR if the instance
+ *                                                     exceeds the object's maximum instances
+ *        SUBSCRIBE <path>                             OK
+ *
+ *        Notifications sent by the server daemon to a session's notify port:
+ *
+ *        NOTIFY <client> <path> <value>
+ *        REGISTER <client>, UPDATE <client>, DEREGISTER <client>
+ */
+
+#ifndef STANDIN_PROTOCOL_H
+#define STANDIN_PROTOCOL_H
+
+//! @cond Doxygen_Suppress
+#define STANDIN_ADDRESS				"127.0.0.1"
+#define STANDIN_SERVER_PORT			(54321)
+#define STANDIN_CLIENT_PORT			(12345)
+#define STANDIN_DATAGRAM_SIZE		(65000)
+#define STANDIN_NAME_SIZE			(64)
+#define STANDIN_PATH_SIZE			(32)
+
+#define STANDIN_STATUS_OK			"OK"
+#define STANDIN_STATUS_NOTFOUND		"NOTFOUND"
+#define STANDIN_STATUS_NOCLIENT		"NOCLIENT"
+#define STANDIN_STATUS_ERROR		"ERROR"
+//! @endcond
+
+#endif	/* STANDIN_PROTOCOL_H */
@@ -0,0 +1,463 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file bindings.c
+ * @brief Loads button to led bindings from a libconfig file and indexes them by client ID and
+ *        resource path. The file looks like:
+ *
+ *        bindings = (
+ *            {
+ *                client = "ButtonDevice";
+ *                path = "/3200/0/5501";
+ *                leds = ( { client = "LedDevice"; path = "/3311/0/5850"; } );
+ *            }
+ *        );
+ *
+ *        Each distinct led gets its own instance of the gateway's led object, in order of first
+ *        appearance. Paths of these instances are computed here once, so actuation never
+ *        formats paths.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <libconfig.h>
+
+#include "bindings.h"
+#include "log.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define DEFAULT_BUTTON_CLIENT	"ButtonDevice"
+#define DEFAULT_BUTTON_PATH		"/3200/0/5501"
+#define DEFAULT_LED_CLIENT		"LedDevice"
+#define DEFAULT_LED_PATH		"/3311/0/5850"
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Check that path names a single resource, i.e. /object/instance/resource.
+ * @param *path path to check.
+ * @return true if path is a resource path, else false.
+ */
+static bool IsResourcePath(const char *path)
+{
+	unsigned int objectID, instanceID, resourceID;
+	char extra;
+
+	return strlen(path) < BINDING_PATH_SIZE &&
+			sscanf(path, "/%u/%u/%u%c", &objectID, &instanceID, &resourceID, &extra) == 3;
+}
+
+/**
+ * @brief Copy client ID and path into fixed size fields, after validating them.
+ * @param *clientID destination client ID.
+ * @param *path destination path.
+ * @param *srcClientID client ID from configuration.
+ * @param *srcPath path from configuration.
+ * @return true if both are valid, else false.
+ */
+static bool CopyKey(char *clientID, char *path, const char *srcClientID, const char *srcPath)
+{
+	if (strlen(srcClientID) == 0 || strlen(srcClientID) >= BINDING_CLIENT_ID_SIZE)
+	{
+		LOG(LOG_ERR, "Invalid client ID '%s' in bindings", srcClientID);
+		return false;
+	}
+
+	if (!IsResourcePath(srcPath))
+	{
+		LOG(LOG_ERR, "Invalid resource path '%s' in bindings", srcPath);
+		return false;
+	}
+
+	strcpy(clientID, srcClientID);
+	strcpy(path, srcPath);
+	return true;
+}
+
+/**
+ * @brief Record an endpoint name unless already recorded.
+ * @param *table bindings.
+ * @param *endpoints index of recorded endpoint names.
+ * @param *clientID endpoint name, must outlive the table.
+ * @return true on success, else false.
+ */
+static bool AddEndpoint(BindingTable *table, HashTable *endpoints, const char *clientID)
+{
+	if (HashTable_Get(endpoints, clientID, NULL) != NULL)
+	{
+		return true;
+	}
+
+	if (!HashTable_Put(endpoints, clientID, NULL, (void *)clientID))
+	{
+		return false;
+	}
+	table->endpoints[table->numEndpoints++] = clientID;
+	return true;
+}
+
+/**
+ * @brief Compute paths of the gateway's own led instance mirroring a led. The mirror uses the
+ *        same object and resource as the led, on the led's local instance.
+ * @param *led led with a valid path and local instance.
+ */
+static void SetLocalPaths(LedTarget *led)
+{
+	unsigned int objectID, instanceID, resourceID;
+
+	sscanf(led->path, "/%u/%u/%u", &objectID, &instanceID, &resourceID);
+	snprintf(led->localInstancePath, BINDING_PATH_SIZE, "/%u/%d", objectID, led->localInstance);
+	snprintf(led->localPath, BINDING_PATH_SIZE, "/%u/%d/%u",
+			objectID, led->localInstance, resourceID);
+}
+
+/**
+ * @brief Find or create the led target for a led resource.
+ * @param *table bindings.
+ * @param *clientID endpoint name of the led device.
+ * @param *path led resource path.
+ * @return led target, or NULL on failure.
+ */
+static LedTarget *AddLed(BindingTable *table, const char *clientID, const char *path)
+{
+	LedTarget *led = HashTable_Get(&table->ledIndex, clientID, path);
+
+	if (led != NULL)
+	{
+		return led;
+	}
+
+	/* Every distinct led gets its own instance of the gateway's led object */
+	if (table->numLeds == BINDING_MAX_LOCAL_LEDS)
+	{
+		LOG(LOG_ERR, "More than %u distinct leds are bound, led %s %s has no local instance",
+				BINDING_MAX_LOCAL_LEDS, clientID, path);
+		return NULL;
+	}
+
+	led = &table->leds[table->numLeds];
+	if (!CopyKey(led->clientID, led->path, clientID, path))
+	{
+		return NULL;
+	}
+	led->localInstance = table->numLeds;
+	SetLocalPaths(led);
+
+	if (!HashTable_Put(&table->ledIndex, led->clientID, led->path, led))
+	{
+		return NULL;
+	}
+	table->numLeds++;
+	return led;
+}
+
+/**
+ * @brief Add a binding and index it.
+ * @param *table bindings.
+ * @param *clientID endpoint name of the button device.
+ * @param *path button counter resource path.
+ * @return binding, or NULL on failure.
+ */
+static Binding *AddBinding(BindingTable *table, const char *clientID, const char *path)
+{
+	Binding *binding = &table->bindings[table->numBindings];
+
+	if (!CopyKey(binding->clientID, binding->path, clientID, path))
+	{
+		return NULL;
+	}
+
+	if (HashTable_Get(&table->buttonIndex, binding->clientID, binding->path) != NULL)
+	{
+		LOG(LOG_ERR, "Button %s%s is bound twice", clientID, path);
+		return NULL;
+	}
+
+	if (!HashTable_Put(&table->buttonIndex, binding->clientID, binding->path, binding))
+	{
+		return NULL;
+	}
+	binding->source.context = binding;
+	table->numBindings++;
+	return binding;
+}
+
+/**
+ * @brief Allocate storage and indexes for the given number of bindings and leds.
+ * @param *table bindings.
+ * @param numBindings number of bindings.
+ * @param numLeds upper bound for number of distinct leds.
+ * @return true on success, else false.
+ */
+static bool AllocateTable(BindingTable *table, unsigned int numBindings, unsigned int numLeds)
+{
+	table->bindings = calloc(numBindings, sizeof(*table->bindings));
+	table->leds = calloc(numLeds, sizeof(*table->leds));
+	table->endpoints = calloc(numBindings + numLeds, sizeof(*table->endpoints));
+
+	return table->bindings != NULL && table->leds != NULL && table->endpoints != NULL &&
+			HashTable_Init(&table->buttonIndex, numBindings) &&
+			HashTable_Init(&table->ledIndex, numLeds);
+}
+
+/**
+ * @brief Build the endpoint list from bindings and leds, and point every led at its endpoint.
+ * @param *table bindings.
+ * @return true on success, else false.
+ */
+static bool CollectEndpoints(BindingTable *table)
+{
+	HashTable endpoints;
+	unsigned int i;
+	bool success;
+
+	if (!HashTable_Init(&endpoints, table->numBindings + table->numLeds))
+	{
+		return false;
+	}
+
+	success = true;
+	for (i = 0; i < table->numBindings && success; i++)
+	{
+		success = AddEndpoint(table, &endpoints, table->bindings[i].clientID);
+	}
+	for (i = 0; i < table->numLeds && success; i++)
+	{
+		success = AddEndpoint(table, &endpoints, table->leds[i].clientID);
+		table->leds[i].endpoint = HashTable_Get(&endpoints, table->leds[i].clientID, NULL);
+	}
+	HashTable_Destroy(&endpoints);
+	return success;
+}
+
+/**
+ * @brief Fill table with the single binding used when no configuration file exists.
+ * @param *table bindings.
+ * @return true on success, else false.
+ */
+static bool LoadDefaultBinding(BindingTable *table)
+{
+	Binding *binding;
+
+	if (!AllocateTable(table, 1, 1))
+	{
+		return false;
+	}
+
+	binding = AddBinding(table, DEFAULT_BUTTON_CLIENT, DEFAULT_BUTTON_PATH);
+	if (binding == NULL)
+	{
+		return false;
+	}
+
+	binding->leds[0] = AddLed(table, DEFAULT_LED_CLIENT, DEFAULT_LED_PATH);
+	binding->numLeds = 1;
+	return binding->leds[0] != NULL;
+}
+
+/**
+ * @brief Fill table from the bindings list of a configuration.
+ * @param *table bindings.
+ * @param *list bindings list setting.
+ * @return true on success, else false.
+ */
+static bool LoadBindingList(BindingTable *table, const config_setting_t *list)
+{
+	unsigned int i, j, numBindings, numLeds = 0;
+
+	numBindings = config_setting_length(list);
+	for (i = 0; i < numBindings; i++)
+	{
+		config_setting_t *leds = config_setting_get_member(config_setting_get_elem(list, i), "leds");
+
+		if (leds != NULL)
+		{
+			numLeds += config_setting_length(leds);
+		}
+	}
+
+	if (numBindings == 0)
+	{
+		LOG(LOG_ERR, "No bindings configured");
+		return false;
+	}
+
+	if (!AllocateTable(table, numBindings, numLeds ? numLeds : 1))
+	{
+		LOG(LOG_ERR, "Failed to allocate %u bindings", numBindings);
+		return false;
+	}
+
+	for (i = 0; i < numBindings; i++)
+	{
+		config_setting_t *element = config_setting_get_elem(list, i);
+		config_setting_t *leds = config_setting_get_member(element, "leds");
+		const char *clientID, *path;
+		Binding *binding;
+
+		if (!config_setting_lookup_string(element, "client", &clientID) ||
+			!config_setting_lookup_string(element, "path", &path))
+		{
+			LOG(LOG_ERR, "Binding %u needs client and path", i);
+			return false;
+		}
+
+		binding = AddBinding(table, clientID, path);
+		if (binding == NULL)
+		{
+			return false;
+		}
+
+		if (leds == NULL || config_setting_length(leds) == 0 ||
+			config_setting_length(leds) > BINDING_MAX_LEDS)
+		{
+			LOG(LOG_ERR, "Binding %u needs 1 to %d leds", i, BINDING_MAX_LEDS);
+			return false;
+		}
+
+		for (j = 0; j < config_setting_length(leds); j++)
+		{
+			config_setting_t *ledElement = config_setting_get_elem(leds, j);
+
+			if (!config_setting_lookup_string(ledElement, "client", &clientID) ||
+				!config_setting_lookup_string(ledElement, "path", &path))
+			{
+				LOG(LOG_ERR, "Led %u of binding %u needs client and path", j, i);
+				return false;
+			}
+
+			binding->leds[j] = AddLed(table, clientID, path);
+			if (binding->leds[j] == NULL)
+			{
+				return false;
+			}
+			binding->numLeds++;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Load bindings from a libconfig file. If the file does not exist, the single
+ *        ButtonDevice to LedDevice binding is used. At most BINDING_MAX_LOCAL_LEDS distinct
+ *        leds can be bound, one gateway led instance each.
+ * @param *table table to fill.
+ * @param *file configuration file.
+ * @return true if bindings were loaded, else false.
+ */
+bool Bindings_Load(BindingTable *table, const char *file)
+{
+	config_t cfg;
+	config_setting_t *list;
+	bool success = false;
+
+	memset(table, 0, sizeof(*table));
+
+	if (access(file, F_OK) != 0)
+	{
+		LOG(LOG_INFO, "No bindings file %s, using default binding", file);
+		success = LoadDefaultBinding(table);
+	}
+	else
+	{
+		config_init(&cfg);
+
+		if (!config_read_file(&cfg, file))
+		{
+			LOG(LOG_ERR, "Failed to read %s:%d: %s",
+					file, config_error_line(&cfg), config_error_text(&cfg));
+		}
+		else if ((list = config_lookup(&cfg, "bindings")) == NULL)
+		{
+			LOG(LOG_ERR, "No bindings list in %s", file);
+		}
+		else
+		{
+			success = LoadBindingList(table, list);
+		}
+		config_destroy(&cfg);
+	}
+
+	if (success)
+	{
+		success = CollectEndpoints(table);
+	}
+
+	if (success)
+	{
+		LOG(LOG_INFO, "Loaded %u bindings driving %u leds on %u devices",
+				table->numBindings, table->numLeds, table->numEndpoints);
+	}
+	else
+	{
+		Bindings_Free(table);
+	}
+	return success;
+}
+
+/**
+ * @brief Find the binding for a button resource.
+ * @param *table bindings.
+ * @param *clientID endpoint name of the notifying device.
+ * @param *path notified resource path.
+ * @return binding, or NULL if resource is not bound.
+ */
+Binding *Bindings_Find(const BindingTable *table, const char *clientID, const char *path)
+{
+	return HashTable_Get(&table->buttonIndex, clientID, path);
+}
+
+/**
+ * @brief Free all bindings and indexes.
+ * @param *table table to free.
+ */
+void Bindings_Free(BindingTable *table)
+{
+	HashTable_Destroy(&table->buttonIndex);
+	HashTable_Destroy(&table->ledIndex);
+	free(table->bindings);
+	free(table->leds);
+	free(table->endpoints);
+	memset(table, 0, sizeof(*table));
+}
@@ -0,0 +1,134 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file bindings.h
+ * @brief Header file for button to led bindings. Bindings are read from a libconfig file at
+ *        startup and indexed by client ID and resource path, so a notification resolves to its
+ *        leds without scanning.
+ */
+
+#ifndef BINDINGS_H
+#define BINDINGS_H
+
+#include <stdbool.h>
+
+#include "awa/server.h"
+#include "event_queue.h"
+#include "hash_table.h"
+
+//! @cond Doxygen_Suppress
+#define BINDINGS_FILE				"/etc/lwm2m/button_gateway.cfg"
+#define BINDING_CLIENT_ID_SIZE		(64)
+#define BINDING_PATH_SIZE			(32)
+#define BINDING_MAX_LEDS			(16)
+#define BINDING_MAX_LOCAL_LEDS		(65535)
+//! @endcond
+
+/**
+ * A structure to contain one led resource on a constrained device.
+ */
+typedef struct
+{
+	/*@{*/
+	char clientID[BINDING_CLIENT_ID_SIZE]; /**< endpoint name of the led device */
+	char path[BINDING_PATH_SIZE]; /**< led resource path on the device */
+	const char *endpoint; /**< endpoint name shared by every led on the same device */
+	AwaObjectInstanceID localInstance; /**< gateway's own led instance mirroring this led */
+	char localInstancePath[BINDING_PATH_SIZE]; /**< path of the mirroring instance */
+	char localPath[BINDING_PATH_SIZE]; /**< path of the mirroring resource */
+	const AwaResourceDefinition *definition; /**< led resource definition, server write session */
+	unsigned int generation; /**< server write session generation of definition, 0 if none */
+	bool localDefined; /**< whether the mirroring instance exists on client daemon */
+	unsigned int localGeneration; /**< client set session generation of localDefined, 0 if unknown */
+	bool state; /**< last state requested for the led */
+	bool hasState; /**< true once a state has been requested */
+	/*@}*/
+}LedTarget;
+
+/**
+ * A structure to contain one button resource and the leds it drives.
+ */
+typedef struct
+{
+	/*@{*/
+	char clientID[BINDING_CLIENT_ID_SIZE]; /**< endpoint name of the button device */
+	char path[BINDING_PATH_SIZE]; /**< button counter resource path on the device */
+	unsigned int numLeds; /**< number of leds driven */
+	LedTarget *leds[BINDING_MAX_LEDS]; /**< leds driven, shared between bindings */
+	bool ledState; /**< last state applied to the leds */
+	EventSource source; /**< counter tracking for button events */
+	AwaServerObservation *observation; /**< observation of the button resource */
+	/*@}*/
+}Binding;
+
+/**
+ * A structure to contain all bindings and their indexes.
+ */
+typedef struct
+{
+	/*@{*/
+	Binding *bindings; /**< all bindings */
+	unsigned int numBindings; /**< number of bindings */
+	LedTarget *leds; /**< all distinct leds */
+	unsigned int numLeds; /**< number of distinct leds */
+	const char **endpoints; /**< distinct endpoint names used by bindings */
+	unsigned int numEndpoints; /**< number of distinct endpoint names */
+	HashTable buttonIndex; /**< client ID and path to Binding */
+	HashTable ledIndex; /**< client ID and path to LedTarget */
+	/*@}*/
+}BindingTable;
+
+/**
+ * @brief Load bindings from a libconfig file. If the file does not exist, the single
+ *        ButtonDevice to LedDevice binding is used. At most BINDING_MAX_LOCAL_LEDS distinct
+ *        leds can be bound, one gateway led instance each.
+ * @param *table table to fill.
+ * @param *file configuration file.
+ * @return true if bindings were loaded, else false.
+ */
+bool Bindings_Load(BindingTable *table, const char *file);
+
+/**
+ * @brief Find the binding for a button resource.
+ * @param *table bindings.
+ * @param *clientID endpoint name of the notifying device.
+ * @param *path notified resource path.
+ * @return binding, or NULL if resource is not bound.
+ */
+Binding *Bindings_Find(const BindingTable *table, const char *clientID, const char *path);
+
+/**
+ * @brief Free all bindings and indexes.
+ * @param *table table to free.
+ */
+void Bindings_Free(BindingTable *table);
+
+#endif	/* BINDINGS_H */
@@ -0,0 +1,247 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file breaker.c
+ * @brief Per device circuit breakers. A closed breaker counts consecutive failed operations and
+ *        opens at BREAKER_THRESHOLD. An open breaker fails operations fast until it is probed
+ *        after BREAKER_RETRY ms, when it goes half open and lets a single operation through
+ *        whose result closes or reopens it.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <string.h>
+
+#include "breaker.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define MS_PER_SECOND	(1000)
+#define NS_PER_MS		(1000000)
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Get printable name of a breaker state.
+ * @param state breaker state.
+ * @return state name.
+ */
+const char *Breaker_StateToString(BreakerState state)
+{
+	switch (state)
+	{
+		case BreakerState_Closed:
+			return "closed";
+		case BreakerState_Open:
+			return "open";
+		case BreakerState_HalfOpen:
+			return "half open";
+	}
+	return "unknown";
+}
+
+/**
+ * @brief Start a closed breaker.
+ * @param *breaker breaker to initialize.
+ */
+void Breaker_Init(Breaker *breaker)
+{
+	memset(breaker, 0, sizeof(*breaker));
+	breaker->state = BreakerState_Closed;
+	pthread_mutex_init(&breaker->lock, NULL);
+}
+
+/**
+ * @brief Free a breaker.
+ * @param *breaker breaker to destroy.
+ */
+void Breaker_Destroy(Breaker *breaker)
+{
+	pthread_mutex_destroy(&breaker->lock);
+}
+
+/**
+ * @brief Check whether an operation may be performed. A half open breaker lets a single probe
+ *        through and fails the others fast until the probe's result is recorded. Safe to call
+ *        from any thread.
+ * @param *breaker breaker of the device.
+ * @return false if the operation has to fail fast, else true.
+ */
+bool Breaker_Allow(Breaker *breaker)
+{
+	bool allowed;
+
+	pthread_mutex_lock(&breaker->lock);
+	allowed = (breaker->state == BreakerState_Closed ||
+			(breaker->state == BreakerState_HalfOpen && !breaker->probing));
+	if (breaker->state == BreakerState_HalfOpen)
+	{
+		breaker->probing = true;
+	}
+	if (!allowed)
+	{
+		breaker->rejected++;
+	}
+	pthread_mutex_unlock(&breaker->lock);
+	return allowed;
+}
+
+/**
+ * @brief Record an operation the device answered, which closes the breaker. Safe to call from
+ *        any thread.
+ * @param *breaker breaker of the device.
+ */
+void Breaker_Success(Breaker *breaker)
+{
+	pthread_mutex_lock(&breaker->lock);
+	breaker->state = BreakerState_Closed;
+	breaker->failures = 0;
+	breaker->probing = false;
+	pthread_mutex_unlock(&breaker->lock);
+}
+
+/**
+ * @brief Record an operation the device didn't answer. BREAKER_THRESHOLD consecutive failures, or
+ *        a failed probe, open the breaker. Safe to call from any thread.
+ * @param *breaker breaker of the device.
+ * @return true if the breaker opened, else false.
+ */
+bool Breaker_Failure(Breaker *breaker)
+{
+	bool opened = false;
+
+	pthread_mutex_lock(&breaker->lock);
+	breaker->failures++;
+	breaker->probing = false;
+	if (breaker->state == BreakerState_HalfOpen ||
+		(breaker->state == BreakerState_Closed && breaker->failures >= BREAKER_THRESHOLD))
+	{
+		breaker->state = BreakerState_Open;
+		clock_gettime(CLOCK_MONOTONIC, &breaker->opened);
+		breaker->trips++;
+		opened = true;
+	}
+	pthread_mutex_unlock(&breaker->lock);
+	return opened;
+}
+
+/**
+ * @brief Let a probe through once the breaker has been open for BREAKER_RETRY ms. With nothing
+ *        to probe with, the breaker stays open and waits another BREAKER_RETRY ms. Safe to call
+ *        from any thread.
+ * @param *breaker breaker of the device.
+ * @param canProbe true if the caller will queue an operation to probe the device with.
+ * @return true if the breaker went half open, else false.
+ */
+bool Breaker_Probe(Breaker *breaker, bool canProbe)
+{
+	struct timespec now;
+	long long openMs;
+	bool probing = false;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	pthread_mutex_lock(&breaker->lock);
+	/* A half open breaker whose probe was never let through is probed again as well */
+	if (breaker->state == BreakerState_Open ||
+		(breaker->state == BreakerState_HalfOpen && !breaker->probing))
+	{
+		openMs = (long long)(now.tv_sec - breaker->opened.tv_sec) * MS_PER_SECOND +
+				(now.tv_nsec - breaker->opened.tv_nsec) / NS_PER_MS;
+		if (openMs >= BREAKER_RETRY)
+		{
+			breaker->state = canProbe ? BreakerState_HalfOpen : BreakerState_Open;
+			breaker->opened = now;
+			probing = canProbe;
+		}
+	}
+	pthread_mutex_unlock(&breaker->lock);
+	return probing;
+}
+
+/**
+ * @brief Record that an operation let through got no answer either way, like one that could not
+ *        be sent. An abandoned probe leaves the breaker open for another BREAKER_RETRY ms. Safe
+ *        to call from any thread.
+ * @param *breaker breaker of the device.
+ */
+void Breaker_Abandon(Breaker *breaker)
+{
+	pthread_mutex_lock(&breaker->lock);
+	if (breaker->state == BreakerState_HalfOpen && breaker->probing)
+	{
+		breaker->state = BreakerState_Open;
+		breaker->probing = false;
+		clock_gettime(CLOCK_MONOTONIC, &breaker->opened);
+	}
+	pthread_mutex_unlock(&breaker->lock);
+}
+
+/**
+ * @brief Close the breaker because the device is known to be reachable. Safe to call from any
+ *        thread.
+ * @param *breaker breaker of the device.
+ * @return true if the breaker was open or half open, else false.
+ */
+bool Breaker_Close(Breaker *breaker)
+{
+	bool wasOpen;
+
+	pthread_mutex_lock(&breaker->lock);
+	wasOpen = (breaker->state != BreakerState_Closed);
+	breaker->state = BreakerState_Closed;
+	breaker->failures = 0;
+	breaker->probing = false;
+	pthread_mutex_unlock(&breaker->lock);
+	return wasOpen;
+}
+
+/**
+ * @brief Get a consistent copy of a breaker.
+ * @param *breaker breaker of the device.
+ * @param *stats filled with the breaker state.
+ */
+void Breaker_GetStats(Breaker *breaker, BreakerStats *stats)
+{
+	pthread_mutex_lock(&breaker->lock);
+	stats->state = breaker->state;
+	stats->failures = breaker->failures;
+	stats->trips = breaker->trips;
+	stats->rejected = breaker->rejected;
+	pthread_mutex_unlock(&breaker->lock);
+}
@@ -0,0 +1,165 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file breaker.h
+ * @brief Header file for per device circuit breakers. After repeated failed writes a device is
+ *        treated as unreachable and writes to it fail fast, instead of each waiting out its
+ *        timeout, until a probe gets through or the device updates its registration.
+ */
+
+#ifndef BREAKER_H
+#define BREAKER_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+
+//! @cond Doxygen_Suppress
+#define BREAKER_THRESHOLD	(3)
+#define BREAKER_RETRY		(10000)
+//! @endcond
+
+/**
+ * Circuit breaker state.
+ */
+typedef enum
+{
+	BreakerState_Closed, /**< device reachable, operations are performed */
+	BreakerState_Open, /**< device unreachable, operations fail fast */
+	BreakerState_HalfOpen /**< probing, one operation is performed and its result decides */
+}BreakerState;
+
+/**
+ * A structure to contain the circuit breaker of one device.
+ */
+typedef struct
+{
+	/*@{*/
+	pthread_mutex_t lock; /**< protects everything below */
+	BreakerState state; /**< current state */
+	unsigned int failures; /**< consecutive failed operations */
+	bool probing; /**< the half open probe has been let through and is in flight */
+	struct timespec opened; /**< monotonic time the breaker last opened or went half open */
+	unsigned long trips; /**< times the breaker opened */
+	unsigned long rejected; /**< operations failed fast while open */
+	/*@}*/
+}Breaker;
+
+/**
+ * A structure to contain a snapshot of a circuit breaker.
+ */
+typedef struct
+{
+	/*@{*/
+	BreakerState state; /**< current state */
+	unsigned int failures; /**< consecutive failed operations */
+	unsigned long trips; /**< times the breaker opened */
+	unsigned long rejected; /**< operations failed fast while open */
+	/*@}*/
+}BreakerStats;
+
+/**
+ * @brief Get printable name of a breaker state.
+ * @param state breaker state.
+ * @return state name.
+ */
+const char *Breaker_StateToString(BreakerState state);
+
+/**
+ * @brief Start a closed breaker.
+ * @param *breaker breaker to initialize.
+ */
+void Breaker_Init(Breaker *breaker);
+
+/**
+ * @brief Free a breaker.
+ * @param *breaker breaker to destroy.
+ */
+void Breaker_Destroy(Breaker *breaker);
+
+/**
+ * @brief Check whether an operation may be performed. A half open breaker lets a single probe
+ *        through and fails the others fast until the probe's result is recorded. Safe to call
+ *        from any thread.
+ * @param *breaker breaker of the device.
+ * @return false if the operation has to fail fast, else true.
+ */
+bool Breaker_Allow(Breaker *breaker);
+
+/**
+ * @brief Record an operation the device answered, which closes the breaker. Safe to call from
+ *        any thread.
+ * @param *breaker breaker of the device.
+ */
+void Breaker_Success(Breaker *breaker);
+
+/**
+ * @brief Record an operation the device didn't answer. BREAKER_THRESHOLD consecutive failures, or
+ *        a failed probe, open the breaker. Safe to call from any thread.
+ * @param *breaker breaker of the device.
+ * @return true if the breaker opened, else false.
+ */
+bool Breaker_Failure(Breaker *breaker);
+
+/**
+ * @brief Let a probe through once the breaker has been open for BREAKER_RETRY ms. With nothing
+ *        to probe with, the breaker stays open and waits another BREAKER_RETRY ms. Safe to call
+ *        from any thread.
+ * @param *breaker breaker of the device.
+ * @param canProbe true if the caller will queue an operation to probe the device with.
+ * @return true if the breaker went half open, else false.
+ */
+bool Breaker_Probe(Breaker *breaker, bool canProbe);
+
+/**
+ * @brief Record that an operation let through got no answer either way, like one that could not
+ *        be sent. An abandoned probe leaves the breaker open for another BREAKER_RETRY ms. Safe
+ *        to call from any thread.
+ * @param *breaker breaker of the device.
+ */
+void Breaker_Abandon(Breaker *breaker);
+
+/**
+ * @brief Close the breaker because the device is known to be reachable. Safe to call from any
+ *        thread.
+ * @param *breaker breaker of the device.
+ * @return true if the breaker was open or half open, else false.
+ */
+bool Breaker_Close(Breaker *breaker);
+
+/**
+ * @brief Get a consistent copy of a breaker.
+ * @param *breaker breaker of the device.
+ * @param *stats filled with the breaker state.
+ */
+void Breaker_GetStats(Breaker *breaker, BreakerStats *stats);
+
+#endif	/* BREAKER_H */
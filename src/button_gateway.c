@@ -50,6 +50,19 @@
 #include "awa/server.h"
 #include "awa/client.h"
 #include "flow_interface.h"
+#include "gpio.h"
+#include "event_queue.h"
+#include "reactor.h"
+#include "worker.h"
+#include "bindings.h"
+#include "registry.h"
+#include "rtt.h"
+#include "outbox.h"
+#include "flow_connection.h"
+#include "startup.h"
+#include "histogram.h"
+#include "metrics.h"
+#include "trace.h"
 #include "flow/core/flow_time.h"
 #include "flow/core/flow_memalloc.h"
 #include "log.h"
@@ -67,8 +80,6 @@
 #define IP_ADDRESS				"127.0.0.1"
 #define COUNTER_STR				"Counter"
 #define ON_OFF_STR					"On/Off"
-#define BUTTON_DEVICE_STR		"ButtonDevice"
-#define LED_DEVICE_STR			"LedDevice"
 #define FLOW_ACCESS_OBJECT_ID		(20001)
 #define FLOW_OBJECT_INSTANCE_ID		(0)
 #define ON_STR				"on"
@@ -77,12 +88,18 @@
 #define BUTTON_RESOURCE_ID	(5501)
 #define LED_OBJECT_ID		(3311)
 #define LED_RESOURCE_ID		(5850)
-#define LED_RESOURCE_PATH	"/3311/0"
 #define MIN_INSTANCES     (0)
-#define MAX_INSTANCES     (1)
+#define MAX_INSTANCES     (255)
 #define OPERATION_TIMEOUT	(5000)
 #define URL_PATH_SIZE		(16)
-#define FLOW_SERVER_CONNECT_TRIALS	(5)
+#define HEARTBEAT_LED_PIN	(76)
+#define HEARTBEAT_INTERVAL	(1000)
+#define SESSION_POLL_INTERVAL	(1000)
+#define PROVISIONING_INTERVAL	(2000)
+#define WORKER_STATS_INTERVAL	(60000)
+#define OUTBOX_DRAIN_INTERVAL	(10000)
+#define OUTBOX_DRAIN_BATCH		(16)
+#define BREAKER_PROBE_INTERVAL	(1000)
 //! @endcond
 
 /***************************************************************************************************
@@ -108,7 +125,6 @@ typedef struct
 typedef struct
 {
 	/*@{*/
-	char *clientID; /**< client ID */
 	AwaObjectID id; /**< object ID */
 	AwaObjectInstanceID instanceID; /**< object instance ID */
 	const char *name; /**< object name */
@@ -117,24 +133,107 @@ typedef struct
 	/*@}*/
 }OBJECT_T;
 
+/**
+ * A structure to contain state shared by the event loop callbacks.
+ */
+typedef struct
+{
+	/*@{*/
+	AwaClientSession *clientSession; /**< session with client daemon */
+	AwaServerSession *serverSession; /**< session with server daemon */
+	AwaClientChangeSubscription *provisioningSubscription; /**< flow access object changes */
+	/*@}*/
+}GATEWAY_T;
+
+/**
+ * A structure to contain a worker's own session with server daemon.
+ */
+typedef struct
+{
+	/*@{*/
+	AwaServerSession *session; /**< session with server daemon, NULL while disconnected */
+	unsigned int generation; /**< incremented whenever session is re-established */
+	unsigned long timeouts; /**< operations that timed out, read atomically by the metrics */
+	/*@}*/
+}SERVER_SINK_T;
+
+/**
+ * A structure to contain a worker's own session with client daemon.
+ */
+typedef struct
+{
+	/*@{*/
+	AwaClientSession *session; /**< session with client daemon, NULL while disconnected */
+	unsigned int generation; /**< incremented whenever session is re-established */
+	unsigned long timeouts; /**< operations that timed out, read atomically by the metrics */
+	/*@}*/
+}CLIENT_SINK_T;
+
 /***************************************************************************************************
  * Globals
  **************************************************************************************************/
 
-/** Variable storing device registration status. */
-static bool isDeviceRegistered = false;
+/** Whether the gateway is provisioned and its objects are defined on client daemon. */
+static bool isProvisioned = false;
+/** Startup phase timing. */
+static StartupReport startupReport;
+/** Flow registration, kept up by its own thread. */
+static FlowConnection flowConnection;
 /** Set default debug level to info. */
 int debugLevel = LOG_INFO;
 /** Set default debug stream to NULL. */
 FILE *debugStream = NULL;
-/** Button state on button constrained device. */
-bool buttonState = false;
+/** Button counter notifications waiting to be handled by the main loop. */
+static EventQueue buttonEvents;
+/** Button to led bindings. */
+static BindingTable bindings;
+/** Registration cache of the devices used by bindings. */
+static Registry registry;
+/** Floor and ceiling of the timeouts of operations on constrained devices. */
+static RttConfig timeoutConfig;
+/** Wakes the event loop when a device needs its observations and led state restored. */
+static int registrationNotifier = -1;
+/** Wakes the event loop to check whether the gateway got provisioned. */
+static int provisioningNotifier = -1;
+/** Retries the provisioning check while client daemon can't be subscribed to. */
+static int provisioningTimer = -1;
+/** Event loop multiplexing Awa sessions, timers and internal queues. */
+static Reactor reactor;
+/** Wakes the event loop when buttonEvents gets a new event. */
+static int buttonEventsNotifier = -1;
+/** Current heartbeat led state. */
+static bool heartbeatState = false;
+/** Number of times the heartbeat led was toggled. */
+static unsigned long heartbeatToggles;
+/** Local metrics endpoint. */
+static MetricsServer metricsServer = {.fd = -1};
+/** Writes led state to the led constrained device through the server daemon. */
+static Worker serverWriter;
+/** Sets led state on the gateway's own led resource through the client daemon. */
+static Worker clientSetter;
+/** Sends led state to the Flow user and device topic. */
+static Worker flowSender;
+/** Set while an outbox drain is requested and no flow send item was handled since. */
+static bool outboxDrainPending;
+/** Flow messages waiting to be sent, only used by the flow send worker. */
+static Outbox flowOutbox = {.fd = -1};
+/** Button notification received to led updates queued. */
+static Histogram dispatchLatency;
+/** Led resource write on the server. */
+static Histogram writeLatency;
+/** Led resource set on the client. */
+static Histogram setLatency;
+/** Flow message queue and send. */
+static Histogram flowLatency;
+/** Button notification received to led resource written on the server. */
+static Histogram totalLatency;
+/** Heartbeat led line, kept open for the life of the process. */
+static Gpio heartbeatGpio = {GpioBackend_Sysfs, HEARTBEAT_LED_PIN, -1, -1};
 
 /** Initializing objects. */
 static OBJECT_T objects[] =
 {
 	{
-		BUTTON_DEVICE_STR,
 		BUTTON_OBJECT_ID,
 		0,
 		"DigitalInput",
@@ -149,7 +248,6 @@ static OBJECT_T objects[] =
 						}
 	},
 	{
-		LED_DEVICE_STR,
 		LED_OBJECT_ID,
 		0,
 		"LightControl",
@@ -175,18 +273,7 @@ static OBJECT_T objects[] =
  */
 static void SetHeartbeatLed(bool status)
 {
-	int tmp = 0;
-
-	if (status)
-	{
-		tmp = system("/usr/bin/set_led.sh 1");
-	}
-	else
-	{
-		tmp = system("/usr/bin/set_led.sh 0");
-	}
-
-	if (tmp != 0)
+	if (heartbeatGpio.fd >= 0 && !Gpio_Set(&heartbeatGpio, status))
 	{
 		LOG(LOG_WARN, "Setting heartbeat led failed.");
 	}
@@ -200,25 +287,39 @@ static void PrintUsage(const char *program)
 {
 	printf("Usage: %s [options]\n\n"
 			" -l : Log filename.\n"
+			" -b : Write the log file in binary format, to be decoded with\n"
+			"      button_gateway_logdecode.\n"
 			" -v : Debug level from 1 to 5\n"
 			"      fatal(1), error(2), warning(3), info(4), debug(5) and max(>5)\n"
 			"      default is info.\n"
+			" -g : Heartbeat led gpio number, default is %d.\n"
+			" -d : Drive heartbeat led through this gpiochip device (e.g. /dev/gpiochip0),\n"
+			"      -g is then the line offset on the chip. Default is sysfs.\n"
+			" -r : Sysfs gpio root, default is %s.\n"
+			" -c : Button to led bindings file, default is %s.\n"
+			" -s : Write startup phase timing report to this file.\n"
 			" -h : Print help and exit.\n\n",
-			program);
+			program, HEARTBEAT_LED_PIN, GPIO_SYSFS_ROOT, BINDINGS_FILE);
 }
 
 /**
  * @brief Parses command line arguments passed to button_gateway_appd.
+ * @param *fptr log file name, if given.
+ * @param *binaryLog set if log file is to be written in binary format.
+ * @param *gpioConfig heartbeat led line configuration.
+ * @param *bindingsFile bindings file name, if given.
+ * @param *reportFile startup report file name, if given.
  * @return -1 in case of failure, 0 for printing help and exit, and 1 for success.
  */
-static int ParseCommandArgs(int argc, char *argv[], const char **fptr)
+static int ParseCommandArgs(int argc, char *argv[], const char **fptr, bool *binaryLog,
+		GpioConfig *gpioConfig, const char **bindingsFile, const char **reportFile)
 {
 	int opt, tmp;
 	opterr = 0;
 
 	while (1)
 	{
-		opt = getopt(argc, argv, "l:v:");
+		opt = getopt(argc, argv, "l:bv:g:d:r:c:s:");
 		if (opt == -1)
 		{
 			break;
@@ -229,6 +330,9 @@ static int ParseCommandArgs(int argc, char *argv[], const char **fptr)
 			case 'l':
 				*fptr = optarg;
 				break;
+			case 'b':
+				*binaryLog = true;
+				break;
 			case 'v':
 				tmp = strtoul(optarg, NULL, 0);
 				if (tmp >= LOG_FATAL && tmp <= LOG_DBG)
@@ -242,6 +346,22 @@ static int ParseCommandArgs(int argc, char *argv[], const char **fptr)
 					return -1;
 				}
 				break;
+			case 'g':
+				gpioConfig->pin = strtoul(optarg, NULL, 0);
+				break;
+			case 'd':
+				gpioConfig->backend = GpioBackend_CharDev;
+				gpioConfig->chipPath = optarg;
+				break;
+			case 'r':
+				gpioConfig->sysfsRoot = optarg;
+				break;
+			case 'c':
+				*bindingsFile = optarg;
+				break;
+			case 's':
+				*reportFile = optarg;
+				break;
 			case 'h':
 				PrintUsage(argv[0]);
 				return 0;
@@ -255,12 +375,70 @@ static int ParseCommandArgs(int argc, char *argv[], const char **fptr)
 }
 
 /**
- * @brief Construct a flow message, depending on ledState, and send it to user.
+ * @brief Outbox send callback, sends a payload to user and publishes it as device status.
  *        This is done using FlowMessaging SDK apis.
+ * @param *payload flow message.
+ * @param pending OUTBOX_MESSAGE and OUTBOX_STATUS sends to do.
+ * @param *context unused.
+ * @return sends which failed and have to be retried.
+ */
+static uint32_t SendFlowPayload(const char *payload, uint32_t pending, void *context)
+{
+	if (pending & OUTBOX_MESSAGE)
+	{
+		TRACE_BEGIN(start);
+		if (SendMessage((char *)payload))
+		{
+			pending &= ~OUTBOX_MESSAGE;
+		}
+		TRACE_END("Flow SendMessage", start);
+	}
+
+	if (pending & OUTBOX_STATUS)
+	{
+		TRACE_BEGIN(start);
+		if (PublishStatus((char *)payload))
+		{
+			pending &= ~OUTBOX_STATUS;
+		}
+		TRACE_END("Flow PublishStatus", start);
+	}
+	return pending;
+}
+
+/**
+ * @brief Send as many queued flow messages as possible. Nothing is sent until the device is
+ *        registered with Flow.
+ */
+static void DrainFlowOutbox(void)
+{
+	unsigned int sent;
+
+	if (!FlowConnection_IsConnected(&flowConnection))
+	{
+		return;
+	}
+
+	do
+	{
+		sent = Outbox_Drain(&flowOutbox, SendFlowPayload, NULL, OUTBOX_DRAIN_BATCH);
+	} while (sent == OUTBOX_DRAIN_BATCH);
+
+	if (Outbox_GetDepth(&flowOutbox) != 0)
+	{
+		LOG(LOG_WARN, "Flow unreachable, %u messages kept in outbox", Outbox_GetDepth(&flowOutbox));
+		FlowConnection_ReportFailure(&flowConnection);
+	}
+}
+
+/**
+ * @brief Construct a flow message, depending on ledState, and queue it in the outbox for the user
+ *        and the device status topic. Without an outbox the message is sent right away, or
+ *        dropped while Flow is disconnected.
  * @param ledState holds led's states whether led is on or off.
- * @return true if construction and sending of flow message is successful, else false.
+ * @return true if construction and queueing of flow message is successful, else false.
  */
-static bool ConstructAndSendFlowMessage(const bool ledState)
+static bool ConstructAndQueueFlowMessage(const bool ledState)
 {
 	char *data = NULL;
 	bool success = true;
@@ -274,10 +452,10 @@ static bool ConstructAndSendFlowMessage(const bool ledState)
 
 	if (data)
 	{
-		time_t time;
-		Flow_GetTime(&time);
+		time_t now;
+		Flow_GetTime(&now);
 		struct tm timeNow;
-		gmtime_r(&time, &timeNow);
+		gmtime_r(&now, &timeNow);
 
 		snprintf(data, msgSize, msgStr,
 				timeNow.tm_hour,
@@ -288,7 +466,26 @@ static bool ConstructAndSendFlowMessage(const bool ledState)
 				timeNow.tm_year + 1900,
 				ledState?ON_STR:OFF_STR);
 
-		success = SendMessage(data) && PublishStatus(data);
+		if (flowOutbox.header != NULL)
+		{
+			if (!Outbox_Push(&flowOutbox, data, OUTBOX_MESSAGE | OUTBOX_STATUS))
+			{
+				LOG(LOG_WARN, "Flow outbox full, a message was discarded");
+			}
+		}
+		else if (FlowConnection_IsConnected(&flowConnection))
+		{
+			success = (SendFlowPayload(data, OUTBOX_MESSAGE | OUTBOX_STATUS, NULL) == 0);
+			if (!success)
+			{
+				FlowConnection_ReportFailure(&flowConnection);
+			}
+		}
+		else
+		{
+			LOG(LOG_WARN, "Flow is disconnected and there is no outbox, a message was dropped");
+			success = false;
+		}
 		Flow_MemFree((void **)&data);
 	}
 	else
@@ -342,35 +539,30 @@ static bool WaitForProvisioning(AwaClientSession *session)
 }
 
 /**
- * @brief Checks whether Led object is defined or not on client server.
+ * @brief Checks whether Led object instance is defined or not on client server.
  * @param *session holds client session.
+ * @param *instancePath led object instance path.
  * @return true if object is already defined, else false.
  */
-bool IsLedObjectDefined(const AwaClientSession *session)
+bool IsLedObjectDefined(const AwaClientSession *session, const char *instancePath)
 {
 	AwaClientGetOperation *operation = AwaClientGetOperation_New(session);
-	char instancePath[URL_PATH_SIZE] = {0};
 	bool success = false;
 
 	if (operation != NULL)
 	{
-		if (AwaAPI_MakeObjectInstancePath(instancePath,
-												URL_PATH_SIZE,
-												LED_OBJECT_ID, 0) == AwaError_Success)
+		if (AwaClientGetOperation_AddPath(operation, instancePath) == AwaError_Success)
 		{
-			if (AwaClientGetOperation_AddPath(operation, instancePath) == AwaError_Success)
+			if (AwaClientGetOperation_Perform(operation,
+													OPERATION_TIMEOUT) == AwaError_Success)
 			{
-				if (AwaClientGetOperation_Perform(operation,
-														OPERATION_TIMEOUT) == AwaError_Success)
+				const AwaClientGetResponse *response = NULL;
+				response = AwaClientGetOperation_GetResponse(operation);
+				if (response)
 				{
-					const AwaClientGetResponse *response = NULL;
-					response = AwaClientGetOperation_GetResponse(operation);
-					if (response)
+					if (AwaClientGetResponse_ContainsPath(response, instancePath))
 					{
-						if (AwaClientGetResponse_ContainsPath(response, instancePath))
-						{
-							success = true;
-						}
+						success = true;
 					}
 				}
 			}
@@ -381,64 +573,127 @@ bool IsLedObjectDefined(const AwaClientSession *session)
 }
 
 /**
- * @brief Set Led resource on AwaLWM2M client.
- * @param *session holds client session.
+ * @brief Checks whether an operation failed because the session with the daemon is gone.
+ * @param error operation error.
+ * @return true if session has to be re-established, else false.
+ */
+static bool IsSessionError(AwaError error)
+{
+	return (error == AwaError_IPCError || error == AwaError_SessionNotConnected ||
+			error == AwaError_SessionInvalid);
+}
+
+/**
+ * @brief Drop a worker's client session, it is re-established before the next operation.
+ * @param *sink worker's client session.
+ */
+static void Client_InvalidateSink(CLIENT_SINK_T *sink)
+{
+	AwaClientSession_Free(&sink->session);
+}
+
+/**
+ * @brief Drop a worker's server session, it is re-established before the next operation.
+ * @param *sink worker's server session.
+ */
+static void Server_InvalidateSink(SERVER_SINK_T *sink)
+{
+	AwaServerSession_Free(&sink->session);
+}
+
+/**
+ * @brief Checks whether a set operation failed because its object instance doesn't exist.
+ * @param *operation performed set operation.
+ * @param *path resource path set by the operation.
+ * @return true if the instance is missing on client daemon, else false.
+ */
+static bool IsInstanceMissing(const AwaClientSetOperation *operation, const char *path)
+{
+	const AwaClientSetResponse *response = AwaClientSetOperation_GetResponse(operation);
+	const AwaPathResult *result = NULL;
+
+	if (response != NULL)
+	{
+		result = AwaClientSetResponse_GetPathResult(response, path);
+	}
+	return (result != NULL && AwaPathResult_GetError(result) == AwaError_PathNotFound);
+}
+
+/**
+ * @brief Set Led resource on AwaLWM2M client. Whether the mirroring instance exists is only
+ *        asked from client daemon once per session, and then tracked from the sets themselves.
+ * @param *sink holds client session.
+ * @param *led led whose mirroring instance to set.
  * @param value resource value to set.
  * @return true if setting resource value is successful, else false.
  */
-static bool SetLedResource(const AwaClientSession *session, const bool value)
+static bool SetLedResource(CLIENT_SINK_T *sink, LedTarget *led, const bool value)
 {
 	AwaClientSetOperation *operation = NULL;
-	char ledResourcePath[URL_PATH_SIZE] = {0};
 	bool success = false;
+	bool create = false;
 	AwaError error;
 
-	operation = AwaClientSetOperation_New(session);
+	operation = AwaClientSetOperation_New(sink->session);
 
 	if (operation != NULL)
 	{
-		if (AwaAPI_MakeResourcePath(ledResourcePath,
-										URL_PATH_SIZE,
-										LED_OBJECT_ID, 0, LED_RESOURCE_ID) == AwaError_Success)
+		if (led->localGeneration != sink->generation)
+		{
+			led->localDefined = IsLedObjectDefined(sink->session, led->localInstancePath);
+			led->localGeneration = sink->generation;
+		}
+
+		if (!led->localDefined)
+		{
+			create = true;
+			AwaClientSetOperation_CreateObjectInstance(operation, led->localInstancePath);
+		}
+
+		if (AwaClientSetOperation_AddValueAsBoolean(operation,
+															led->localPath,
+															value) == AwaError_Success)
 		{
-			if (!IsLedObjectDefined(session))
+			if ((error = AwaClientSetOperation_Perform(operation,
+													OPERATION_TIMEOUT)) == AwaError_Success)
 			{
-				AwaClientSetOperation_CreateObjectInstance(operation, LED_RESOURCE_PATH);
+				success = true;
+				led->localDefined = true;
+				LOG(LOG_INFO, "Set %d on client %s.\n", value, led->localPath);
 			}
-
-			if (AwaClientSetOperation_AddValueAsBoolean(operation,
-																ledResourcePath,
-																value) == AwaError_Success)
+			else
 			{
-				if ((error = AwaClientSetOperation_Perform(operation,
-														OPERATION_TIMEOUT)) == AwaError_Success)
+				LOG(LOG_ERR, "AwaClientSetOperation_Perform failed\n"
+													"error: %s", AwaError_ToString(error));
+				if (error == AwaError_Timeout)
 				{
-					success = true;
-					LOG(LOG_INFO, "Set %d on client.\n",value);
+					__atomic_add_fetch(&sink->timeouts, 1, __ATOMIC_RELAXED);
 				}
-				else
+				/* Instance was removed behind our back, or creating it failed: ask again */
+				if (create || IsInstanceMissing(operation, led->localPath))
 				{
-					LOG(LOG_ERR, "AwaClientSetOperation_Perform failed\n"
-														"error: %s", AwaError_ToString(error));
+					led->localGeneration = 0;
+				}
+
+				if (IsSessionError(error))
+				{
+					Client_InvalidateSink(sink);
 				}
 			}
 		}
-		else
-		{
-			LOG(LOG_INFO, "Couldn't generate object and resource path for LED.");
-		}
 		AwaClientSetOperation_Free(&operation);
 	}
 	return success;
 }
 
 /**
- * @brief Checks if resource is defined on server or not.
+ * @brief Look up resource definition on server.
  * @param *session holds server session.
  * @param *path full path of resource to be searched.
- * @return true if resource is defined on server, else false.
+ * @return resource definition if resource is defined on server, else NULL.
  */
-static bool IsResourceDefined(const AwaServerSession *session, const char *path)
+static const AwaResourceDefinition *GetResourceDefinition(const AwaServerSession *session,
+		const char *path)
 {
 	AwaObjectID objectID;
 	AwaResourceID resourceID;
@@ -468,198 +723,502 @@ static bool IsResourceDefined(const AwaServerSession *session, const char *path)
 		LOG(LOG_ERR, "AwaServerSession_PathToIDs() failed\n"
 														"error: %s", AwaError_ToString(error));
 	}
-	return (resourceDefinition != NULL);
+	return resourceDefinition;
+}
+
+/**
+ * @brief Get the round trip time estimate of a constrained device. Safe to call from any thread,
+ *        the registry index is not modified after startup.
+ * @param *clientID endpoint name of the device.
+ * @return estimate, or NULL if no binding uses the device.
+ */
+static RttEstimator *GetDeviceRtt(const char *clientID)
+{
+	Endpoint *endpoint = Registry_Find(&registry, clientID);
+
+	return endpoint != NULL ? &endpoint->rtt : NULL;
+}
+
+/**
+ * @brief Account an operation on a constrained device to its round trip time estimate. An error
+ *        the device answered with still measures a round trip.
+ * @param *rtt estimate of the device, or NULL.
+ * @param error result of the operation.
+ * @param *start monotonic time the operation was started.
+ */
+static void RecordDeviceRtt(RttEstimator *rtt, AwaError error, const struct timespec *start)
+{
+	if (rtt == NULL)
+	{
+		return;
+	}
+
+	if (error == AwaError_Timeout)
+	{
+		Rtt_Timeout(rtt);
+	}
+	else if (error == AwaError_Success || error == AwaError_Response)
+	{
+		Rtt_Sample(rtt, start);
+	}
+}
+
+/**
+ * @brief Get the circuit breaker of a constrained device. Safe to call from any thread, the
+ *        registry index is not modified after startup.
+ * @param *clientID endpoint name of the device.
+ * @return breaker, or NULL if no binding uses the device.
+ */
+static Breaker *GetDeviceBreaker(const char *clientID)
+{
+	Endpoint *endpoint = Registry_Find(&registry, clientID);
+
+	return endpoint != NULL ? &endpoint->breaker : NULL;
+}
+
+/**
+ * @brief Account a led write to the circuit breaker of its device. Any answer from the device
+ *        closes the breaker, a write the device didn't answer counts towards opening it, and a
+ *        write that failed on the gateway's side tells nothing about the device.
+ * @param *clientID endpoint name of the device.
+ * @param *breaker breaker of the device, or NULL.
+ * @param error result of the write.
+ */
+static void RecordDeviceWrite(const char *clientID, Breaker *breaker, AwaError error)
+{
+	if (breaker == NULL)
+	{
+		return;
+	}
+
+	if (error == AwaError_Success || error == AwaError_Response)
+	{
+		Breaker_Success(breaker);
+	}
+	else if (error == AwaError_Timeout || error == AwaError_ClientNotFound)
+	{
+		if (Breaker_Failure(breaker))
+		{
+			LOG(LOG_WARN, "Constrained device %s is unreachable, led writes fail fast until it "
+					"is probed or updates its registration", clientID);
+		}
+	}
+	else
+	{
+		Breaker_Abandon(breaker);
+	}
+}
+
+/**
+ * @brief Resolve led resource definition on the sink's session, unless it is already cached
+ *        for the sink's current session generation.
+ * @param *sink holds server session.
+ * @param *led led to resolve.
+ * @return true if led resource is defined on server, else false.
+ */
+static bool ResolveLedResource(const SERVER_SINK_T *sink, LedTarget *led)
+{
+	if (led->generation != sink->generation)
+	{
+		led->definition = GetResourceDefinition(sink->session, led->path);
+		led->generation = led->definition != NULL ? sink->generation : 0;
+	}
+	return (led->definition != NULL);
 }
 
 /**
  * @brief Update led resource value on server.
- * @param *session holds server session.
+ * @param *sink holds server session.
+ * @param *led led device and resource to write.
  * @param value resource value to write.
  * @return true if writing resource value is successful, else false.
  */
-static bool WriteLedResource(const AwaServerSession *session, const bool value)
+static bool WriteLedResource(SERVER_SINK_T *sink, LedTarget *led, const bool value)
 {
-	char ledResourcePath[URL_PATH_SIZE] = {0};
 	bool success = false;
 	AwaError error;
+	RttEstimator *rtt = GetDeviceRtt(led->clientID);
+	Breaker *breaker = GetDeviceBreaker(led->clientID);
+	struct timespec start;
 
 	AwaServerWriteOperation *operation = NULL;
-	operation = AwaServerWriteOperation_New(session, AwaWriteMode_Update);
+	operation = AwaServerWriteOperation_New(sink->session, AwaWriteMode_Update);
 
 	if (operation != NULL)
 	{
-		if (AwaAPI_MakeResourcePath(ledResourcePath,
-											URL_PATH_SIZE,
-											LED_OBJECT_ID, 0, LED_RESOURCE_ID) == AwaError_Success)
+		if (ResolveLedResource(sink, led))
 		{
-			if (IsResourceDefined(session, ledResourcePath))
+			if (AwaServerWriteOperation_AddValueAsBoolean(operation,
+																led->path,
+																value) == AwaError_Success)
 			{
-				if (AwaServerWriteOperation_AddValueAsBoolean(operation,
-																	ledResourcePath,
-																	value) == AwaError_Success)
+				clock_gettime(CLOCK_MONOTONIC, &start);
+				error = AwaServerWriteOperation_Perform(operation,
+														led->clientID,
+														Rtt_GetTimeout(rtt, &timeoutConfig));
+				RecordDeviceRtt(rtt, error, &start);
+				RecordDeviceWrite(led->clientID, breaker, error);
+				if (error == AwaError_Success)
+				{
+					LOG(LOG_INFO, "Written %d to %s%s.\n", value, led->clientID, led->path);
+					success = true;
+				}
+				else
 				{
-					if ((error = AwaServerWriteOperation_Perform(operation,
-															LED_DEVICE_STR,
-															OPERATION_TIMEOUT)) == AwaError_Success)
+					LOG(LOG_ERR, "AwaServerWriteOperation_Perform failed\n"
+														"error: %s", AwaError_ToString(error));
+					if (error == AwaError_Timeout)
 					{
-						LOG(LOG_INFO, "Written %d to server.\n", value);
-						success = true;
+						__atomic_add_fetch(&sink->timeouts, 1, __ATOMIC_RELAXED);
 					}
-					else
+					if (IsSessionError(error))
 					{
-						LOG(LOG_ERR, "AwaServerWriteOperation_Perform failed\n"
-															"error: %s", AwaError_ToString(error));
+						Server_InvalidateSink(sink);
 					}
 				}
 			}
 		}
-		else
-		{
-			LOG(LOG_INFO, "Couldn't generate all object and resource paths.\n");
-		}
 		AwaServerWriteOperation_Free(&operation);
 	}
 	return success;
 }
 
 /**
- * @brief Update led resource value on client and server both, and also send flow message to user.
- * @param *clientSession holds client session.
- * @param *serverSession holds server session.
- * @param buttonState button resource value to update.
+ * @brief Update the resources of several leds of one device with a single write operation.
+ *        If the device rejects some of them, each rejected led is written again on its own, so
+ *        one bad resource doesn't fail the others.
+ * @param *sink holds server session.
+ * @param *items work items of leds on the same device.
+ * @param count number of items.
+ * @param *results set to whether each led was written.
  */
-void PerformUpdate(const AwaClientSession *clientSession,
-						const AwaServerSession *serverSession,
-						const bool buttonState)
+static void WriteLedResources(SERVER_SINK_T *sink, const WorkItem *items, unsigned int count,
+		bool *results)
 {
-	if (!WriteLedResource(serverSession, buttonState))
+	AwaServerWriteOperation *operation = NULL;
+	const AwaServerWriteResponse *response = NULL;
+	const char *clientID = ((const LedTarget *)items[0].target)->clientID;
+	RttEstimator *rtt = GetDeviceRtt(clientID);
+	Breaker *breaker = GetDeviceBreaker(clientID);
+	bool added[WORKER_MAX_BATCH];
+	unsigned int numAdded = 0, i;
+	struct timespec start;
+	AwaError error;
+
+	for (i = 0; i < count; i++)
 	{
-		LOG(LOG_ERR, "Writing to LED resource on server failed.\n");
+		results[i] = false;
+		added[i] = false;
 	}
 
-	if (!SetLedResource(clientSession, buttonState))
+	/* Desired state stays in the leds, it is written again once the device is back */
+	if (breaker != NULL && !Breaker_Allow(breaker))
 	{
-		LOG(LOG_ERR, "Setting to LED resource on client failed.\n");
+		LOG(LOG_DBG, "Skipping write of %u leds to unreachable %s", count, clientID);
+		return;
 	}
 
-	if (isDeviceRegistered)
+	operation = AwaServerWriteOperation_New(sink->session, AwaWriteMode_Update);
+	if (operation == NULL)
 	{
-		if (ConstructAndSendFlowMessage(buttonState) == false)
+		if (breaker != NULL)
 		{
-			LOG(LOG_ERR, "Flow message send failed");
+			Breaker_Abandon(breaker);
 		}
+		return;
 	}
-}
-
-/**
- * @brief Observe callback gets called when there is change in button status.
- * @param *context a pointer to any data passed from callback registration function.
- * @param *changeSet a pointer to a valid ChangeSet.
- */
-void ObserveCallback(const AwaChangeSet *changeSet, void *context)
-{
-	char path[URL_PATH_SIZE] = {0};
-	const AwaInteger *value = NULL;
-	const AwaServerSession *serverSession = AwaChangeSet_GetServerSession(changeSet);
 
-	if (AwaAPI_MakeResourcePath(path,
-										URL_PATH_SIZE,
-										BUTTON_OBJECT_ID,
-										0, BUTTON_RESOURCE_ID) != AwaError_Success)
+	for (i = 0; i < count; i++)
 	{
-		LOG(LOG_INFO, "Couldn't generate all object and resource paths.\n");
-	}
+		LedTarget *led = (LedTarget *)items[i].target;
 
+		if (ResolveLedResource(sink, led) &&
+			AwaServerWriteOperation_AddValueAsBoolean(operation,
+														led->path,
+														items[i].value) == AwaError_Success)
+		{
+			added[i] = true;
+			numAdded++;
+		}
+	}
 
-	if (path != NULL)
+	if (numAdded == 0)
 	{
-		AwaObjectID objectID = AWA_INVALID_ID;
-		AwaObjectInstanceID objectInstanceID = AWA_INVALID_ID;
-		AwaResourceID resourceID = AWA_INVALID_ID;
-		AwaError result;
+		if (breaker != NULL)
+		{
+			Breaker_Abandon(breaker);
+		}
+		AwaServerWriteOperation_Free(&operation);
+		return;
+	}
 
-		AwaServerSession_PathToIDs(serverSession, path, &objectID, &objectInstanceID, &resourceID);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	error = AwaServerWriteOperation_Perform(operation,
+											clientID,
+											Rtt_GetTimeout(rtt, &timeoutConfig));
+	RecordDeviceRtt(rtt, error, &start);
+	RecordDeviceWrite(clientID, breaker, error);
+	if (error == AwaError_Success)
+	{
+		for (i = 0; i < count; i++)
+		{
+			results[i] = added[i];
+		}
+		LOG(LOG_INFO, "Written %u leds of %s.\n", numAdded, clientID);
+	}
+	else if (error == AwaError_Response &&
+			(response = AwaServerWriteOperation_GetResponse(operation, clientID)) != NULL)
+	{
+		for (i = 0; i < count; i++)
+		{
+			const LedTarget *led = items[i].target;
+			const AwaPathResult *result;
 
-		result = AwaChangeSet_GetValueAsIntegerPointer(changeSet, path, &value);
+			if (!added[i])
+			{
+				continue;
+			}
+			result = AwaServerWriteResponse_GetPathResult(response, led->path);
+			results[i] = (result != NULL && AwaPathResult_GetError(result) == AwaError_Success);
+			if (!results[i])
+			{
+				LOG(LOG_WARN, "Writing %s%s rejected, retrying on its own", clientID, led->path);
+			}
+		}
+	}
+	else
+	{
+		LOG(LOG_ERR, "AwaServerWriteOperation_Perform failed\n"
+											"error: %s", AwaError_ToString(error));
+		if (error == AwaError_Timeout)
+		{
+			__atomic_add_fetch(&sink->timeouts, 1, __ATOMIC_RELAXED);
+		}
+		if (IsSessionError(error))
+		{
+			Server_InvalidateSink(sink);
+		}
+	}
+	AwaServerWriteOperation_Free(&operation);
 
-		if (result == AwaError_Success)
+	/* Only paths the device answered for are retried, a timeout would only repeat itself */
+	if (response != NULL)
+	{
+		for (i = 0; i < count; i++)
 		{
-			buttonState = *value % 2;
+			if (added[i] && !results[i])
+			{
+				results[i] = WriteLedResource(sink, (LedTarget *)items[i].target, items[i].value);
+			}
 		}
 	}
 }
 
 /**
- * @brief Observe button status on server and call for update in case of changes.
-
- * @param *serverSession holds server session.
- * @return true if observing button has been set successfully, else false.
+ * @brief Flow worker handler, queues flow message for user and device status, then drains the
+ *        outbox. Items without a target only drain the outbox. Since every item drains, it
+ *        serves any drain requested before it started.
+ * @param *item work item holding led state.
+ * @param *context unused.
+ * @return true if message was queued, else false.
  */
-static bool StartObservingButton(const AwaServerSession *session)
+static bool FlowSendHandler(const WorkItem *item, void *context)
 {
-	AwaServerObserveOperation *operation = NULL;
-	char buttonResourcePath[URL_PATH_SIZE] = {0};
-	const AwaPathResult *pathResult = NULL;
+	bool success = true;
+	struct timespec start;
 
-	operation = AwaServerObserveOperation_New(session);
-	if (operation == NULL)
+	__atomic_store_n(&outboxDrainPending, false, __ATOMIC_RELEASE);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (item->target != NULL && ConstructAndQueueFlowMessage(item->value) == false)
 	{
-		LOG(LOG_ERR, "Failed to create observe operation");
-		return false;
+		LOG(LOG_ERR, "Flow message send failed");
+		success = false;
 	}
+	DrainFlowOutbox();
 
-	if (AwaAPI_MakeResourcePath(buttonResourcePath,
-										URL_PATH_SIZE,
-										BUTTON_OBJECT_ID,
-										0, BUTTON_RESOURCE_ID) != AwaError_Success)
+	if (item->target != NULL && success)
 	{
-		LOG(LOG_INFO, "Couldn't generate all object and resource paths.\n");
-		return false;
+		Histogram_RecordSince(&flowLatency, &start);
 	}
+	return success;
+}
+
+/**
+ * @brief Queue led state update on client and server both for every led of a binding, and also
+ *        flow message to user. Each is performed by its own worker, so this never blocks.
+ * @param *binding button binding whose state changed.
+ * @param *event button event which changed the state.
+ * @param buttonState button resource value to update.
+ */
+void PerformUpdate(Binding *binding, const ButtonEvent *event, const bool buttonState)
+{
+	WorkItem item;
+	unsigned int i;
 
-	AwaServerObservation *observation = AwaServerObservation_New(BUTTON_DEVICE_STR,
-																	buttonResourcePath,
-																	ObserveCallback,
-																	NULL);
+	item.value = buttonState;
+	item.sequence = event->sequence;
+	item.received = event->received;
+	clock_gettime(CLOCK_MONOTONIC, &item.queued);
+	Histogram_RecordSince(&dispatchLatency, &event->received);
 
-	if (observation != NULL)
+	for (i = 0; i < binding->numLeds; i++)
 	{
-		if (AwaServerObserveOperation_AddObservation(operation, observation) != AwaError_Success)
+		binding->leds[i]->state = buttonState;
+		binding->leds[i]->hasState = true;
+		item.target = binding->leds[i];
+		item.slot = binding->leds[i]->localInstance;
+		item.group = binding->leds[i]->endpoint;
+
+		if (!Worker_Enqueue(&serverWriter, &item))
+		{
+			LOG(LOG_WARN, "%s backlog full, oldest update dropped", serverWriter.name);
+		}
+
+		if (!Worker_Enqueue(&clientSetter, &item))
+		{
+			LOG(LOG_WARN, "%s backlog full, oldest update dropped", clientSetter.name);
+		}
+	}
+
+	item.target = binding;
+	if (!Worker_Enqueue(&flowSender, &item))
+	{
+		LOG(LOG_WARN, "%s backlog full, oldest update dropped", flowSender.name);
+	}
+}
+
+/**
+ * @brief Observe callback gets called when there is change in button status.
+ * @param *context a pointer to any data passed from callback registration function.
+ * @param *changeSet a pointer to a valid ChangeSet.
+ */
+void ObserveCallback(const AwaChangeSet *changeSet, void *context)
+{
+	const AwaInteger *value = NULL;
+	const char *clientID = AwaChangeSet_GetClientID(changeSet);
+	TRACE_BEGIN(start);
+	AwaPathIterator *iterator = AwaChangeSet_NewPathIterator(changeSet);
+
+	if (iterator == NULL)
+	{
+		LOG(LOG_ERR, "AwaChangeSet_NewPathIterator failed");
+		return;
+	}
+
+	while (AwaPathIterator_Next(iterator))
+	{
+		const char *path = AwaPathIterator_Get(iterator);
+		Binding *binding = Bindings_Find(&bindings, clientID, path);
+
+		if (binding == NULL)
+		{
+			continue;
+		}
+
+		if (AwaChangeSet_GetValueAsIntegerPointer(changeSet, path, &value) == AwaError_Success)
+		{
+			if (!EventQueue_Push(&buttonEvents, &binding->source, *value))
+			{
+				LOG(LOG_WARN, "Button event queue full, %lu events dropped",
+						EventQueue_GetDrops(&buttonEvents));
+			}
+			Reactor_Notify(buttonEventsNotifier);
+		}
+	}
+	AwaPathIterator_Free(&iterator);
+	TRACE_END("Awa notification", start);
+}
+
+/**
+ * @brief Observe status of bound buttons on server and call for update in case of changes.
+ *        Observations left from an earlier registration of the device are replaced.
+
+ * @param *serverSession holds server session.
+ * @param **buttons bindings whose buttons are to be observed, all on the same device.
+ * @param numButtons number of bindings.
+ * @param *rtt round trip time estimate of the device.
+ * @return true if observing all buttons has been set successfully, else false.
+ */
+static bool StartObservingButtons(const AwaServerSession *session,
+									Binding **buttons,
+									unsigned int numButtons,
+									RttEstimator *rtt)
+{
+	AwaServerObserveOperation *operation = NULL;
+	const AwaPathResult *pathResult = NULL;
+	bool success = true;
+	unsigned int i;
+	struct timespec start;
+	AwaError error;
+
+	operation = AwaServerObserveOperation_New(session);
+	if (operation == NULL)
+	{
+		LOG(LOG_ERR, "Failed to create observe operation");
+		return false;
+	}
+
+	for (i = 0; i < numButtons; i++)
+	{
+		Binding *binding = buttons[i];
+
+		if (binding->observation != NULL)
+		{
+			AwaServerObservation_Free(&binding->observation);
+		}
+
+		binding->observation = AwaServerObservation_New(binding->clientID,
+															binding->path,
+															ObserveCallback,
+															NULL);
+
+		if (binding->observation == NULL ||
+			AwaServerObserveOperation_AddObservation(operation,
+													binding->observation) != AwaError_Success)
 		{
 			LOG(LOG_ERR, "AwaServerObserveOperation_AddObservation failed");
+			AwaServerObserveOperation_Free(&operation);
 			return false;
 		}
 	}
 
-	if (AwaServerObserveOperation_Perform(operation, OPERATION_TIMEOUT) != AwaError_Success)
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	error = AwaServerObserveOperation_Perform(operation, Rtt_GetTimeout(rtt, &timeoutConfig));
+	RecordDeviceRtt(rtt, error, &start);
+	if (error != AwaError_Success)
 	{
 		LOG(LOG_ERR, "Failed to perform observe operation");
+		AwaServerObserveOperation_Free(&operation);
 		return false;
 	}
 
-	const AwaServerObserveResponse *response = NULL;
-	response = AwaServerObserveOperation_GetResponse(operation, BUTTON_DEVICE_STR);
-
-	pathResult = AwaServerObserveResponse_GetPathResult(response, buttonResourcePath);
-	if (AwaPathResult_GetError(pathResult) != AwaError_Success)
+	for (i = 0; i < numButtons; i++)
 	{
-		LOG(LOG_ERR, "AwaServerObserveResponse_GetPathResult failed\n");
-		return false;
+		Binding *binding = buttons[i];
+		const AwaServerObserveResponse *response = NULL;
+
+		response = AwaServerObserveOperation_GetResponse(operation, binding->clientID);
+		pathResult = AwaServerObserveResponse_GetPathResult(response, binding->path);
+		if (AwaPathResult_GetError(pathResult) != AwaError_Success)
+		{
+			LOG(LOG_ERR, "Observing %s%s failed\n", binding->clientID, binding->path);
+			success = false;
+		}
 	}
 
 	AwaServerObserveOperation_Free(&operation);
 
-	return true;
+	return success;
 }
 
 /**
- * @brief Check to see if a constrained device by the name endPointName has registered
- *        itself with the server on the gateway or not.
+ * @brief Seed the registration cache with the constrained devices already registered with the
+ *        server on the gateway. Later changes arrive as client register, update and deregister
+ *        events, so the client list is only fetched once.
  * @param *session holds server session.
- * @param *endPointName holds client name.
- * @return true if constrained device is in client list i.e. registered, else false.
+ * @return true if client list was read, else false.
  */
-static bool CheckConstrainedRegistered(const AwaServerSession *session, const char *endPointName)
+static bool CheckConstrainedRegistered(const AwaServerSession *session)
 {
 	bool success = false;
 	AwaError error;
@@ -678,14 +1237,13 @@ static bool CheckConstrainedRegistered(const AwaServerSession *session, const ch
 				{
 					const char *clientID = AwaClientIterator_GetClientID(clientIterator);
 
-					if (!strcmp(endPointName, clientID))
+					if (Registry_SetRegistered(&registry, clientID, false) != NULL)
 					{
-						LOG(LOG_INFO, "Constrained device %s registered", endPointName);
-						success = true;
-						break;
+						Reactor_Notify(registrationNotifier);
 					}
 				}
 				AwaClientIterator_Free(&clientIterator);
+				success = true;
 			}
 			else
 			{
@@ -711,6 +1269,122 @@ static bool CheckConstrainedRegistered(const AwaServerSession *session, const ch
 	return success;
 }
 
+/**
+ * @brief Count the leds of a device that have a state to write.
+ * @param *endpoint device whose leds are counted.
+ * @return number of leds with a state.
+ */
+static unsigned int CountEndpointLedStates(const Endpoint *endpoint)
+{
+	unsigned int i, count = 0;
+
+	for (i = 0; i < endpoint->numLeds; i++)
+	{
+		count += endpoint->leds[i]->hasState;
+	}
+	return count;
+}
+
+/**
+ * @brief Queue the last known state of every led of a device to the server writer.
+ * @param *endpoint device whose leds are written.
+ */
+static void ReplayEndpointLeds(const Endpoint *endpoint)
+{
+	WorkItem item;
+	unsigned int i;
+
+	for (i = 0; i < endpoint->numLeds; i++)
+	{
+		if (endpoint->leds[i]->hasState)
+		{
+			memset(&item, 0, sizeof(item));
+			item.value = endpoint->leds[i]->state;
+			item.target = endpoint->leds[i];
+			item.slot = endpoint->leds[i]->localInstance;
+			item.group = endpoint->name;
+			clock_gettime(CLOCK_MONOTONIC, &item.queued);
+			Worker_Enqueue(&serverWriter, &item);
+		}
+	}
+}
+
+/**
+ * @brief Mark every client in a registration event as registered. A register or update shows
+ *        the device is reachable, so its circuit breaker is closed and led writes it missed are
+ *        replayed.
+ * @param *iterator client iterator of the event, freed here.
+ * @param isRegister true for a register event, false for an update event.
+ */
+static void HandleRegistrations(AwaClientIterator *iterator, bool isRegister)
+{
+	const char *clientID;
+	Endpoint *endpoint;
+
+	if (iterator == NULL)
+	{
+		return;
+	}
+
+	while (AwaClientIterator_Next(iterator))
+	{
+		clientID = AwaClientIterator_GetClientID(iterator);
+		if (Registry_SetRegistered(&registry, clientID, isRegister) != NULL)
+		{
+			Reactor_Notify(registrationNotifier);
+		}
+
+		endpoint = Registry_Find(&registry, clientID);
+		if (endpoint != NULL && Breaker_Close(&endpoint->breaker))
+		{
+			LOG(LOG_INFO, "Constrained device %s is reachable again", clientID);
+			ReplayEndpointLeds(endpoint);
+		}
+	}
+	AwaClientIterator_Free(&iterator);
+}
+
+/**
+ * @brief Client register event callback.
+ * @param *event register event.
+ * @param *context unused.
+ */
+static void ClientRegisterCallback(const AwaServerClientRegisterEvent *event, void *context)
+{
+	HandleRegistrations(AwaServerClientRegisterEvent_NewClientIterator(event), true);
+}
+
+/**
+ * @brief Client update event callback.
+ * @param *event update event.
+ * @param *context unused.
+ */
+static void ClientUpdateCallback(const AwaServerClientUpdateEvent *event, void *context)
+{
+	HandleRegistrations(AwaServerClientUpdateEvent_NewClientIterator(event), false);
+}
+
+/**
+ * @brief Client deregister event callback.
+ * @param *event deregister event.
+ * @param *context unused.
+ */
+static void ClientDeregisterCallback(const AwaServerClientDeregisterEvent *event, void *context)
+{
+	AwaClientIterator *iterator = AwaServerClientDeregisterEvent_NewClientIterator(event);
+
+	if (iterator == NULL)
+	{
+		return;
+	}
+
+	while (AwaClientIterator_Next(iterator))
+	{
+		Registry_SetDeregistered(&registry, AwaClientIterator_GetClientID(iterator));
+	}
+	AwaClientIterator_Free(&iterator);
+}
+
 /**
  * @brief Add all resource definitions belongs to object.
  * @param *object whose resources are to be defined.
@@ -719,9 +1393,16 @@ static bool CheckConstrainedRegistered(const AwaServerSession *session, const ch
 static AwaObjectDefinition *AddResourceDefinitions(OBJECT_T *object)
 {
 	int i;
+	int maxInstances = MAX_INSTANCES;
+
+	// the gateway mirrors every bound led in an instance of its own
+	if (object->id == LED_OBJECT_ID && bindings.numLeds > MAX_INSTANCES)
+	{
+		maxInstances = bindings.numLeds;
+	}
 
 	AwaObjectDefinition *objectDefinition = AwaObjectDefinition_New(object->id,
-		object->name, MIN_INSTANCES, MAX_INSTANCES);
+		object->name, MIN_INSTANCES, maxInstances);
 	if (objectDefinition != NULL)
 	{
 		// define resources
@@ -970,135 +1651,1150 @@ AwaServerSession *Server_EstablishSession(unsigned int port, const char *address
 }
 
 /**
- * @brief Button gateway application to poll a button press on constrained device,
- *        and set the led on another. Also send a flow message to user for change in LED state.
+ * @brief Process IPC traffic from server daemon and dispatch its callbacks.
+ * @param fd readable socket.
+ * @param events epoll events.
+ * @param *context holds server session.
  */
-int main(int argc, char **argv)
+static void ServerSessionReadable(int fd, uint32_t events, void *context)
 {
-	int i, ret;
-	FILE *configFile;
-	const char *fptr = NULL;
+	AwaServerSession *session = context;
+	TRACE_BEGIN(start);
 
-	ret = ParseCommandArgs(argc, argv, &fptr);
-	if (ret <= 0)
+	if (AwaServerSession_Process(session, 0) != AwaError_Success)
 	{
-		return ret;
+		LOG(LOG_ERR, "AwaServerSession_Process() failed");
+		Reactor_Stop(&reactor);
+		return;
 	}
+	TRACE_END("AwaServerSession_Process", start);
 
-	if (fptr)
-	{
-		configFile = fopen(fptr, "w");
-		if (configFile != NULL)
-		{
-			debugStream  = configFile;
-		}
-		else
-		{
-			LOG(LOG_ERR, "Failed to create or open %s file", fptr);
-		}
-	}
+	TRACE_BEGIN(dispatch);
+	AwaServerSession_DispatchCallbacks(session);
+	TRACE_END("AwaServerSession_DispatchCallbacks", dispatch);
+}
 
-	AwaClientSession *clientSession = NULL;
-	AwaServerSession *serverSession = NULL;
+/**
+ * @brief Process IPC traffic from client daemon and dispatch its callbacks.
+ * @param fd readable socket.
+ * @param events epoll events.
+ * @param *context holds client session.
+ */
+static void ClientSessionReadable(int fd, uint32_t events, void *context)
+{
+	AwaClientSession *session = context;
 
-	LOG(LOG_INFO, "Button Gateway Application");
-	LOG(LOG_INFO, "------------------------\n");
+	if (AwaClientSession_Process(session, 0) != AwaError_Success)
+	{
+		LOG(LOG_ERR, "AwaClientSession_Process() failed");
+		return;
+	}
+	AwaClientSession_DispatchCallbacks(session);
+}
 
-	clientSession = Client_EstablishSession(IPC_CLIENT_PORT, IP_ADDRESS);
-	if (clientSession != NULL)
+/**
+ * @brief Route a session's IPC sockets into the event loop. If they cannot be found, the
+ *        session is polled on a timer instead.
+ * @param *snapshot sockets open before the session was connected.
+ * @param callback processes the session.
+ * @param *session session to watch.
+ */
+static void WatchSession(SocketSnapshot *snapshot, ReactorCallback callback, void *session)
+{
+	if (Reactor_AddNewSockets(&reactor, snapshot, callback, session) == 0)
 	{
-		LOG(LOG_ERR, "Client session established\n");
+		LOG(LOG_WARN, "No IPC sockets found for session, polling it instead");
+		Reactor_AddTimer(&reactor, SESSION_POLL_INTERVAL, SESSION_POLL_INTERVAL, callback, session);
 	}
+}
 
-	serverSession = Server_EstablishSession(IPC_SERVER_PORT, IP_ADDRESS);
-	if (serverSession == NULL)
+/**
+ * @brief Handle every queued button state change in the order it was notified.
+ * @param fd notifier.
+ * @param events epoll events.
+ * @param *context unused.
+ */
+static void HandleButtonEvents(int fd, uint32_t events, void *context)
+{
+	ButtonEvent event;
+
+	while (EventQueue_Pop(&buttonEvents, &event))
 	{
-		LOG(LOG_ERR, "Failed to establish server session\n");
+		Binding *binding = event.source->context;
+		bool buttonState = event.counter % 2;
+
+		TRACE_SET_EVENT(event.sequence);
+		TRACE_END("Event queued", event.received);
+		TRACE_BEGIN(start);
+
+		LOG(LOG_DBG, "Button event %u from %s%s, counter %lld, %u more queued",
+				event.sequence, binding->clientID, binding->path,
+				(long long)event.counter, EventQueue_GetDepth(&buttonEvents));
+
+		if (buttonState != binding->ledState)
+		{
+			PerformUpdate(binding, &event, buttonState);
+			binding->ledState = buttonState;
+		}
+		TRACE_END("Event handled", start);
 	}
+	TRACE_SET_EVENT(TRACE_NO_EVENT);
+}
 
-	LOG(LOG_INFO, "Wait until device is provisioned\n");
-	SetHeartbeatLed(true);
+/**
+ * @brief Checks whether buttons of every bound device are observed.
+ * @return true if all buttons are observed, else false.
+ */
+static bool AreAllButtonsObserved(void)
+{
+	unsigned int i;
 
-	while (!WaitForProvisioning(clientSession))
+	for (i = 0; i < registry.numEndpoints; i++)
 	{
-		LOG(LOG_INFO, "Waiting...\n");
-		AwaClientSession_Free(&clientSession);
-		sleep(2);
-		clientSession = Client_EstablishSession(IPC_CLIENT_PORT, IP_ADDRESS);
+		if (registry.endpoints[i].numButtons > 0 && !registry.endpoints[i].observed)
+		{
+			return false;
+		}
 	}
+	return true;
+}
+
+/**
+ * @brief Queue the last known state of every led to a worker.
+ * @param *worker worker to queue to.
+ */
+static void ReplayLedState(Worker *worker)
+{
+	WorkItem item;
+	unsigned int i;
 
-	for (i = FLOW_SERVER_CONNECT_TRIALS; i > 0; i--)
+	for (i = 0; i < bindings.numLeds; i++)
 	{
-		isDeviceRegistered = InitializeAndRegisterFlowDevice();
-		if (isDeviceRegistered)
+		if (bindings.leds[i].hasState)
 		{
-			break;
+			memset(&item, 0, sizeof(item));
+			item.value = bindings.leds[i].state;
+			item.target = &bindings.leds[i];
+			item.slot = bindings.leds[i].localInstance;
+			item.group = bindings.leds[i].endpoint;
+			clock_gettime(CLOCK_MONOTONIC, &item.queued);
+			Worker_Enqueue(worker, &item);
 		}
-		LOG(LOG_INFO, "Try to connect to Flow Server for %d more trials..\n", i);
-		sleep(1);
 	}
+}
+
+/**
+ * @brief Restore observations and led state of every device that registered since last call.
+ *        Runs from the event loop rather than the registration callbacks, since it performs
+ *        operations on the session that is dispatching them.
+ * @param fd notifier.
+ * @param events epoll events.
+ * @param *context holds gateway state.
+ */
+static void SynchroniseEndpoints(int fd, uint32_t events, void *context)
+{
+	GATEWAY_T *gateway = context;
+	Endpoint *endpoint;
 
-	if (DefineServerObjects(serverSession) && DefineClientObjects(clientSession))
+	while ((endpoint = Registry_PopPending(&registry)) != NULL)
 	{
-		for (i = 0; i < ARRAY_SIZE(objects); i++)
+		if (!endpoint->registered)
 		{
-			LOG(LOG_INFO, "Waiting for constrained device '%s' to be up",objects[i].clientID);
-			while (CheckConstrainedRegistered(serverSession, objects[i].clientID) == false)
-			{
-				sleep(1 /*second*/);
-			}
+			continue;
 		}
 
-		if (StartObservingButton(serverSession))
+		if (endpoint->numButtons > 0)
 		{
-			bool cachedButtonState = buttonState;
-			while(true)
+			endpoint->observed = StartObservingButtons(gateway->serverSession,
+														endpoint->buttons,
+														endpoint->numButtons,
+														&endpoint->rtt);
+			if (endpoint->observed)
 			{
-				SetHeartbeatLed(false);
-				if (AwaServerSession_Process(serverSession, 1000 /* 1 second */) != AwaError_Success)
-				{
-					LOG(LOG_ERR, "AwaServerSession_Process() failed");
-					break;
-				}
-				AwaServerSession_DispatchCallbacks(serverSession);
-
-				/* Check if button state is changed */
-				if (buttonState != cachedButtonState)
+				Startup_End(&startupReport, StartupPhase_FirstObservation);
+				if (AreAllButtonsObserved())
 				{
-					PerformUpdate(clientSession, serverSession, buttonState);
-					cachedButtonState = buttonState;
+					Startup_End(&startupReport, StartupPhase_AllObserved);
 				}
-				SetHeartbeatLed(true);
 			}
 		}
-		else
+
+		ReplayEndpointLeds(endpoint);
+		LOG(LOG_INFO, "Constrained device %s synchronised, %u of %u devices registered",
+				endpoint->name, registry.numRegistered, registry.numEndpoints);
+	}
+}
+
+/**
+ * @brief Probe every device whose circuit breaker has been open long enough, by writing its
+ *        led state again. The result of the write closes or reopens the breaker. A device with
+ *        no led state yet has nothing to probe with and stays open.
+ * @param fd timer.
+ * @param events epoll events.
+ * @param *context unused.
+ */
+static void ProbeUnreachableDevices(int fd, uint32_t events, void *context)
+{
+	unsigned int i;
+
+	for (i = 0; i < registry.numEndpoints; i++)
+	{
+		Endpoint *endpoint = &registry.endpoints[i];
+
+		if (Breaker_Probe(&endpoint->breaker, CountEndpointLedStates(endpoint) != 0))
 		{
-			LOG(LOG_ERR, "StartObservingButton failed");
+			LOG(LOG_INFO, "Probing unreachable constrained device %s", endpoint->name);
+			ReplayEndpointLeds(endpoint);
 		}
 	}
+}
 
-	/* Should never come here */
-	SetHeartbeatLed(false);
+/**
+ * @brief Toggle heartbeat led to show the event loop is alive.
+ * @param fd timer.
+ * @param events epoll events.
+ * @param *context unused.
+ */
+static void HeartbeatTimeout(int fd, uint32_t events, void *context)
+{
+	heartbeatState = !heartbeatState;
+	heartbeatToggles++;
+	SetHeartbeatLed(heartbeatState);
+}
 
-	if (AwaServerSession_Disconnect(serverSession) != AwaError_Success)
+/**
+ * @brief Ask the flow send worker to retry queued flow messages. A drain item is only queued
+ *        when no request is pending and the queue is empty, otherwise a queued item does the
+ *        drain, so drain requests never displace flow messages. Safe to call from any thread.
+ */
+static void RequestOutboxDrain(void)
+{
+	WorkItem item = {0};
+	WorkerStats stats;
+
+	if (__atomic_exchange_n(&outboxDrainPending, true, __ATOMIC_ACQ_REL))
 	{
-		LOG(LOG_ERR, "Failed to disconnect server session");
+		return;
 	}
 
-	if (AwaServerSession_Free(&serverSession) != AwaError_Success)
+	Worker_GetStats(&flowSender, &stats);
+	if (stats.depth == 0)
 	{
-		LOG(LOG_WARN, "Failed to free server session");
+		clock_gettime(CLOCK_MONOTONIC, &item.queued);
+		Worker_Enqueue(&flowSender, &item);
 	}
+}
+
+/**
+ * @brief SIGHUP callback, reopens the log file after it was moved by an external rotation.
+ * @param fd signal descriptor.
+ * @param events epoll events.
+ * @param *context unused.
+ */
+static void ReopenLog(int fd, uint32_t events, void *context)
+{
+	Log_Reopen();
+}
+
+#ifdef TRACE_ENABLED
+/**
+ * @brief SIGUSR2 callback, writes the recorded spans for chrome://tracing or Perfetto.
+ * @param fd signal descriptor.
+ * @param events epoll events.
+ * @param *context unused.
+ */
+static void DumpTrace(int fd, uint32_t events, void *context)
+{
+	Trace_Dump(TRACE_FILE);
+}
+#endif
+
+/**
+ * @brief SIGUSR1 callback, logs percentiles of the button to led latency histograms.
+ * @param fd signal descriptor.
+ * @param events epoll events.
+ * @param *context unused.
+ */
+static void ReportLatency(int fd, uint32_t events, void *context)
+{
+	Histogram *histograms[] = {&dispatchLatency, &writeLatency, &setLatency, &flowLatency,
+			&totalLatency};
+	HistogramSummary summary;
+	int i;
 
-	if (AwaClientSession_Disconnect(clientSession) != AwaError_Success)
+	for (i = 0; i < ARRAY_SIZE(histograms); i++)
 	{
-		LOG(LOG_ERR, "Failed to disconnect client session");
+		Histogram_GetSummary(histograms[i], &summary);
+		LOG(LOG_INFO, "Latency %s: %lu samples, p50 %u us, p99 %u us, p999 %u us, max %u us",
+				histograms[i]->name, summary.count, summary.p50, summary.p99, summary.p999,
+				summary.max);
 	}
+}
 
-	if (AwaClientSession_Free(&clientSession) != AwaError_Success)
+/**
+ * @brief Outbox timer callback, retries queued flow messages.
+ * @param fd timer.
+ * @param events epoll events.
+ * @param *context unused.
+ */
+static void OutboxDrainTimeout(int fd, uint32_t events, void *context)
+{
+	RequestOutboxDrain();
+}
+
+/**
+ * @brief Flow connection callback, sends what was queued while disconnected.
+ * @param *context unused.
+ */
+static void FlowConnected(void *context)
+{
+	Startup_End(&startupReport, StartupPhase_FlowConnect);
+	RequestOutboxDrain();
+}
+
+/**
+ * @brief Log latency and backlog of each actuation worker.
+ * @param fd timer.
+ * @param events epoll events.
+ * @param *context unused.
+ */
+static void WorkerStatsTimeout(int fd, uint32_t events, void *context)
+{
+	Worker *workers[] = {&serverWriter, &clientSetter, &flowSender};
+	WorkerStats stats;
+	FlowConnectionStats flowStats;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(workers); i++)
 	{
-		LOG(LOG_WARN, "Failed to free client session");
+		unsigned long count;
+
+		Worker_GetStats(workers[i], &stats);
+		count = stats.succeeded + stats.failed;
+		LOG(LOG_DBG, "%s: depth %u (max %u), %lu ok, %lu failed, %lu dropped, %lu coalesced, "
+				"latency last %llu us, avg %llu us, max %llu us",
+				workers[i]->name, stats.depth, stats.maxDepth,
+				stats.succeeded, stats.failed, stats.dropped, stats.coalesced,
+				(unsigned long long)stats.lastLatencyUs,
+				(unsigned long long)(count ? stats.totalLatencyUs / count : 0),
+				(unsigned long long)stats.maxLatencyUs);
+	}
+	FlowConnection_GetStats(&flowConnection, &flowStats);
+	LOG(LOG_DBG, "Flow: %s, %lu attempts, %lu connects, %lu losses, next retry %u ms, "
+			"%lu device lookups avoided",
+			FlowConnection_StateToString(flowStats.state), flowStats.attempts, flowStats.connects,
+			flowStats.losses, flowStats.backoffMs, GetFlowLookupsAvoided());
+	LOG(LOG_DBG, "Log: %lu messages dropped", Log_GetDrops());
+
+	for (i = 0; i < (int)registry.numEndpoints; i++)
+	{
+		RttStats rtt;
+		BreakerStats breaker;
+
+		Rtt_GetStats(&registry.endpoints[i].rtt, &timeoutConfig, &rtt);
+		Breaker_GetStats(&registry.endpoints[i].breaker, &breaker);
+		if (rtt.samples != 0 || rtt.timeouts != 0 || breaker.trips != 0)
+		{
+			LOG(LOG_DBG, "%s: rtt last %llu us, smoothed %llu us, variation %llu us, "
+					"timeout %u ms, %lu timeouts, breaker %s, %lu trips, %lu writes skipped",
+					registry.endpoints[i].name, (unsigned long long)rtt.lastUs,
+					(unsigned long long)rtt.srttUs, (unsigned long long)rtt.rttvarUs,
+					rtt.timeoutMs, rtt.timeouts, Breaker_StateToString(breaker.state),
+					breaker.trips, breaker.rejected);
+		}
+	}
+}
+
+/**
+ * @brief Add the round trip time and timeout metrics of every device an operation was performed
+ *        on.
+ * @param *buffer exposition to add to.
+ */
+static void AddDeviceRttMetrics(MetricsBuffer *buffer)
+{
+	const char *names[] =
+	{
+		"button_gateway_device_rtt_us",
+		"button_gateway_device_rtt_variation_us",
+		"button_gateway_device_timeout_ms",
+		"button_gateway_device_timeouts_total"
+	};
+	const char *help[] =
+	{
+		"Smoothed round trip time of operations on a constrained device.",
+		"Smoothed variation of the round trip time of a constrained device.",
+		"Timeout given to the next operation on a constrained device.",
+		"Operations on a constrained device that timed out."
+	};
+	uint64_t values[ARRAY_SIZE(names)];
+	RttStats stats;
+	unsigned int j;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(names); i++)
+	{
+		Metrics_AddFamily(buffer, names[i],
+				i == ARRAY_SIZE(names) - 1 ? MetricsType_Counter : MetricsType_Gauge, help[i]);
+		for (j = 0; j < registry.numEndpoints; j++)
+		{
+			Rtt_GetStats(&registry.endpoints[j].rtt, &timeoutConfig, &stats);
+			if (stats.samples == 0 && stats.timeouts == 0)
+			{
+				continue;
+			}
+			values[0] = stats.srttUs;
+			values[1] = stats.rttvarUs;
+			values[2] = stats.timeoutMs;
+			values[3] = stats.timeouts;
+			Metrics_AddSample(buffer, names[i], "device", registry.endpoints[j].name, values[i]);
+		}
+	}
+}
+
+/**
+ * @brief Count the devices whose circuit breaker is not closed.
+ * @return number of devices.
+ */
+static unsigned int CountUnreachableDevices(void)
+{
+	BreakerStats stats;
+	unsigned int i, count = 0;
+
+	for (i = 0; i < registry.numEndpoints; i++)
+	{
+		Breaker_GetStats(&registry.endpoints[i].breaker, &stats);
+		count += (stats.state != BreakerState_Closed);
+	}
+	return count;
+}
+
+/**
+ * @brief Add the circuit breaker metrics of every device whose breaker ever opened.
+ * @param *buffer exposition to add to.
+ */
+static void AddDeviceBreakerMetrics(MetricsBuffer *buffer)
+{
+	BreakerStats stats;
+	unsigned int i;
+
+	Metrics_AddFamily(buffer, "button_gateway_device_breaker_trips_total", MetricsType_Counter,
+			"Times led writes to a constrained device started failing fast.");
+	for (i = 0; i < registry.numEndpoints; i++)
+	{
+		Breaker_GetStats(&registry.endpoints[i].breaker, &stats);
+		if (stats.trips != 0)
+		{
+			Metrics_AddSample(buffer, "button_gateway_device_breaker_trips_total", "device",
+					registry.endpoints[i].name, stats.trips);
+		}
+	}
+	Metrics_AddFamily(buffer, "button_gateway_device_writes_skipped_total", MetricsType_Counter,
+			"Led writes failed fast because a constrained device was unreachable.");
+	for (i = 0; i < registry.numEndpoints; i++)
+	{
+		Breaker_GetStats(&registry.endpoints[i].breaker, &stats);
+		if (stats.trips != 0)
+		{
+			Metrics_AddSample(buffer, "button_gateway_device_writes_skipped_total", "device",
+					registry.endpoints[i].name, stats.rejected);
+		}
+	}
+}
+
+/**
+ * @brief Metrics collector, adds event, sink, heartbeat, Flow and registration metrics. Runs on
+ *        the event loop, so loop state is read directly and worker state through snapshots.
+ * @param *buffer exposition to add to.
+ * @param *context unused.
+ */
+static void CollectMetrics(MetricsBuffer *buffer, void *context)
+{
+	const struct
+	{
+		Worker *worker;
+		const char *label;
+		unsigned long *timeouts;
+	}sinks[] =
+	{
+		{&serverWriter, "server", &((SERVER_SINK_T *)serverWriter.context)->timeouts},
+		{&clientSetter, "client", &((CLIENT_SINK_T *)clientSetter.context)->timeouts},
+		{&flowSender, "flow", NULL}
+	};
+	const FlowState states[] = {FlowState_Disconnected, FlowState_Connecting, FlowState_Connected};
+	WorkerStats stats[ARRAY_SIZE(sinks)];
+	FlowConnectionStats flowStats;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sinks); i++)
+	{
+		Worker_GetStats(sinks[i].worker, &stats[i]);
+	}
+	FlowConnection_GetStats(&flowConnection, &flowStats);
+
+	Metrics_AddFamily(buffer, "button_gateway_events_received_total", MetricsType_Counter,
+			"Button notifications received.");
+	Metrics_AddSample(buffer, "button_gateway_events_received_total", NULL, NULL,
+			EventQueue_GetReceived(&buttonEvents));
+	Metrics_AddFamily(buffer, "button_gateway_events_coalesced_total", MetricsType_Counter,
+			"Button presses merged into a later notification by the device.");
+	Metrics_AddSample(buffer, "button_gateway_events_coalesced_total", NULL, NULL,
+			EventQueue_GetGaps(&buttonEvents));
+	Metrics_AddFamily(buffer, "button_gateway_events_dropped_total", MetricsType_Counter,
+			"Button notifications dropped because the event queue was full.");
+	Metrics_AddSample(buffer, "button_gateway_events_dropped_total", NULL, NULL,
+			EventQueue_GetDrops(&buttonEvents));
+	Metrics_AddFamily(buffer, "button_gateway_event_queue_depth", MetricsType_Gauge,
+			"Button notifications waiting to be handled.");
+	Metrics_AddSample(buffer, "button_gateway_event_queue_depth", NULL, NULL,
+			EventQueue_GetDepth(&buttonEvents));
+
+	Metrics_AddFamily(buffer, "button_gateway_sink_succeeded_total", MetricsType_Counter,
+			"Updates performed by a sink.");
+	for (i = 0; i < ARRAY_SIZE(sinks); i++)
+	{
+		Metrics_AddSample(buffer, "button_gateway_sink_succeeded_total", "sink", sinks[i].label,
+				stats[i].succeeded);
+	}
+	Metrics_AddFamily(buffer, "button_gateway_sink_failed_total", MetricsType_Counter,
+			"Updates a sink failed to perform, including timeouts.");
+	for (i = 0; i < ARRAY_SIZE(sinks); i++)
+	{
+		Metrics_AddSample(buffer, "button_gateway_sink_failed_total", "sink", sinks[i].label,
+				stats[i].failed);
+	}
+	Metrics_AddFamily(buffer, "button_gateway_sink_timeouts_total", MetricsType_Counter,
+			"Awa operations of a sink that timed out.");
+	for (i = 0; i < ARRAY_SIZE(sinks); i++)
+	{
+		if (sinks[i].timeouts != NULL)
+		{
+			Metrics_AddSample(buffer, "button_gateway_sink_timeouts_total", "sink",
+					sinks[i].label, __atomic_load_n(sinks[i].timeouts, __ATOMIC_RELAXED));
+		}
+	}
+	Metrics_AddFamily(buffer, "button_gateway_sink_dropped_total", MetricsType_Counter,
+			"Updates dropped because the sink's queue was full.");
+	for (i = 0; i < ARRAY_SIZE(sinks); i++)
+	{
+		Metrics_AddSample(buffer, "button_gateway_sink_dropped_total", "sink", sinks[i].label,
+				stats[i].dropped);
+	}
+	Metrics_AddFamily(buffer, "button_gateway_sink_coalesced_total", MetricsType_Counter,
+			"Led updates replaced by a newer state before the sink performed them.");
+	for (i = 0; i < ARRAY_SIZE(sinks); i++)
+	{
+		if (sinks[i].worker->numSlots != 0)
+		{
+			Metrics_AddSample(buffer, "button_gateway_sink_coalesced_total", "sink",
+					sinks[i].label, stats[i].coalesced);
+		}
+	}
+	Metrics_AddFamily(buffer, "button_gateway_sink_queue_depth", MetricsType_Gauge,
+			"Updates waiting in the sink's queue.");
+	for (i = 0; i < ARRAY_SIZE(sinks); i++)
+	{
+		Metrics_AddSample(buffer, "button_gateway_sink_queue_depth", "sink", sinks[i].label,
+				stats[i].depth);
+	}
+	Metrics_AddFamily(buffer, "button_gateway_sink_queue_max_depth", MetricsType_Gauge,
+			"High water mark of the sink's queue.");
+	for (i = 0; i < ARRAY_SIZE(sinks); i++)
+	{
+		Metrics_AddSample(buffer, "button_gateway_sink_queue_max_depth", "sink", sinks[i].label,
+				stats[i].maxDepth);
+	}
+
+	Metrics_AddFamily(buffer, "button_gateway_heartbeat_toggles_total", MetricsType_Counter,
+			"Heartbeat led toggles, stops increasing if the event loop stalls.");
+	Metrics_AddSample(buffer, "button_gateway_heartbeat_toggles_total", NULL, NULL,
+			heartbeatToggles);
+
+	Metrics_AddFamily(buffer, "button_gateway_flow_state", MetricsType_Gauge,
+			"Flow connection state, 1 for the current state.");
+	for (i = 0; i < ARRAY_SIZE(states); i++)
+	{
+		Metrics_AddSample(buffer, "button_gateway_flow_state", "state",
+				FlowConnection_StateToString(states[i]), flowStats.state == states[i]);
+	}
+	Metrics_AddFamily(buffer, "button_gateway_flow_connects_total", MetricsType_Counter,
+			"Successful Flow registrations.");
+	Metrics_AddSample(buffer, "button_gateway_flow_connects_total", NULL, NULL,
+			flowStats.connects);
+	Metrics_AddFamily(buffer, "button_gateway_flow_losses_total", MetricsType_Counter,
+			"Flow connections reported lost.");
+	Metrics_AddSample(buffer, "button_gateway_flow_losses_total", NULL, NULL, flowStats.losses);
+
+	Metrics_AddFamily(buffer, "button_gateway_devices", MetricsType_Gauge,
+			"Constrained devices used by bindings.");
+	Metrics_AddSample(buffer, "button_gateway_devices", NULL, NULL, registry.numEndpoints);
+	Metrics_AddFamily(buffer, "button_gateway_devices_registered", MetricsType_Gauge,
+			"Constrained devices registered with the server daemon.");
+	Metrics_AddSample(buffer, "button_gateway_devices_registered", NULL, NULL,
+			registry.numRegistered);
+	Metrics_AddFamily(buffer, "button_gateway_devices_unreachable", MetricsType_Gauge,
+			"Constrained devices whose led writes fail fast or are being probed.");
+	Metrics_AddSample(buffer, "button_gateway_devices_unreachable", NULL, NULL,
+			CountUnreachableDevices());
+
+	Metrics_AddFamily(buffer, "button_gateway_log_dropped_total", MetricsType_Counter,
+			"Log messages dropped because the log thread fell behind.");
+	Metrics_AddSample(buffer, "button_gateway_log_dropped_total", NULL, NULL, Log_GetDrops());
+
+	/* Device families come last, so on a large fleet only they are truncated */
+	AddDeviceRttMetrics(buffer);
+	AddDeviceBreakerMetrics(buffer);
+}
+
+/**
+ * @brief Disconnect and free a server session.
+ * @param **session session to free, set to NULL.
+ */
+static void Server_CloseSession(AwaServerSession **session)
+{
+	if (*session == NULL)
+	{
+		return;
+	}
+
+	if (AwaServerSession_Disconnect(*session) != AwaError_Success)
+	{
+		LOG(LOG_ERR, "Failed to disconnect server session");
+	}
+
+	if (AwaServerSession_Free(session) != AwaError_Success)
+	{
+		LOG(LOG_WARN, "Failed to free server session");
+	}
+}
+
+/**
+ * @brief Disconnect and free a client session.
+ * @param **session session to free, set to NULL.
+ */
+static void Client_CloseSession(AwaClientSession **session)
+{
+	if (*session == NULL)
+	{
+		return;
+	}
+
+	if (AwaClientSession_Disconnect(*session) != AwaError_Success)
+	{
+		LOG(LOG_ERR, "Failed to disconnect client session");
+	}
+
+	if (AwaClientSession_Free(session) != AwaError_Success)
+	{
+		LOG(LOG_WARN, "Failed to free client session");
+	}
+}
+
+/**
+ * @brief Flow access object change callback, the gateway may just have been provisioned.
+ *        Provisioning is checked from the event loop, as this runs while the client session is
+ *        dispatching callbacks.
+ * @param *changeSet changes of the flow access object.
+ * @param *context unused.
+ */
+static void FlowAccessCallback(const AwaChangeSet *changeSet, void *context)
+{
+	Reactor_Notify(provisioningNotifier);
+}
+
+/**
+ * @brief Subscribe to changes of the flow access object on client daemon, which provisioning
+ *        creates an instance of.
+ * @param *gateway holds client session.
+ * @return true if subscribed, else false.
+ */
+static bool SubscribeToProvisioning(GATEWAY_T *gateway)
+{
+	AwaClientSubscribeOperation *operation = NULL;
+	AwaClientChangeSubscription *subscription = NULL;
+	char objectPath[URL_PATH_SIZE] = {0};
+	AwaError error;
+
+	if (gateway->provisioningSubscription != NULL)
+	{
+		return true;
+	}
+
+	if (AwaAPI_MakeObjectPath(objectPath, URL_PATH_SIZE, FLOW_ACCESS_OBJECT_ID) != AwaError_Success)
+	{
+		return false;
+	}
+
+	operation = AwaClientSubscribeOperation_New(gateway->clientSession);
+	if (operation == NULL)
+	{
+		LOG(LOG_ERR, "AwaClientSubscribeOperation_New failed");
+		return false;
+	}
+
+	subscription = AwaClientChangeSubscription_New(objectPath, FlowAccessCallback, NULL);
+	if (subscription != NULL &&
+		AwaClientSubscribeOperation_AddChangeSubscription(operation,
+														subscription) == AwaError_Success)
+	{
+		if ((error = AwaClientSubscribeOperation_Perform(operation,
+														OPERATION_TIMEOUT)) == AwaError_Success)
+		{
+			gateway->provisioningSubscription = subscription;
+		}
+		else
+		{
+			LOG(LOG_WARN, "Subscribing to %s failed, error: %s", objectPath,
+					AwaError_ToString(error));
+		}
+	}
+	AwaClientSubscribeOperation_Free(&operation);
+
+	if (gateway->provisioningSubscription == NULL && subscription != NULL)
+	{
+		AwaClientChangeSubscription_Free(&subscription);
+	}
+	return (gateway->provisioningSubscription != NULL);
+}
+
+/**
+ * @brief Checks whether the gateway is provisioned. Runs at start, whenever the flow access
+ *        object changes, and on a retry timer only while client daemon can't be subscribed to.
+ *        Once provisioned, objects are defined on client daemon and led state held back
+ *        meanwhile is set. Until then the server side already serves button presses.
+ * @param fd notifier or retry timer.
+ * @param events epoll events.
+ * @param *context holds gateway state.
+ */
+static void CheckProvisioning(int fd, uint32_t events, void *context)
+{
+	GATEWAY_T *gateway = context;
+
+	if (isProvisioned)
+	{
+		return;
+	}
+
+	if (gateway->clientSession == NULL)
+	{
+		gateway->clientSession = Client_EstablishSession(IPC_CLIENT_PORT, IP_ADDRESS);
+		if (gateway->clientSession == NULL)
+		{
+			Reactor_ArmTimer(provisioningTimer, PROVISIONING_INTERVAL, 0);
+			return;
+		}
+
+		/* Other threads open sockets by now, so the session's own can't be told apart */
+		LOG(LOG_WARN, "Client session connected after startup, polling it");
+		Reactor_AddTimer(&reactor, SESSION_POLL_INTERVAL, SESSION_POLL_INTERVAL,
+				ClientSessionReadable, gateway->clientSession);
+	}
+
+	/* Subscribe before checking, so provisioning can't complete unnoticed in between */
+	Reactor_ArmTimer(provisioningTimer,
+			SubscribeToProvisioning(gateway) ? 0 : PROVISIONING_INTERVAL, 0);
+
+	if (!WaitForProvisioning(gateway->clientSession))
+	{
+		LOG(LOG_INFO, "Waiting...\n");
+		return;
+	}
+
+	Reactor_ArmTimer(provisioningTimer, 0, 0);
+	Startup_End(&startupReport, StartupPhase_Provisioning);
+
+	Startup_Begin(&startupReport, StartupPhase_ClientDefine);
+	if (!DefineClientObjects(gateway->clientSession))
+	{
+		LOG(LOG_FATAL, "Failed to define objects on client");
+		Reactor_Stop(&reactor);
+		return;
+	}
+	Startup_End(&startupReport, StartupPhase_ClientDefine);
+
+	__atomic_store_n(&isProvisioned, true, __ATOMIC_RELEASE);
+	ReplayLedState(&clientSetter);
+	Reactor_AddTimer(&reactor, HEARTBEAT_INTERVAL, HEARTBEAT_INTERVAL, HeartbeatTimeout, NULL);
+}
+
+/**
+ * @brief Flow configuration file watch callback, registers with Flow right away instead of
+ *        waiting for the connection manager's backoff.
+ * @param fd file watch.
+ * @param events epoll events.
+ * @param *context unused.
+ */
+static void FlowConfigWritten(int fd, uint32_t events, void *context)
+{
+	LOG(LOG_INFO, "%s written", FLOW_CONFIG_FILE);
+	FlowConnection_Retry(&flowConnection);
+}
+
+/**
+ * @brief Re-establish a worker's server session if it was dropped. Definitions resolved on the
+ *        previous session are invalidated by bumping the session generation.
+ * @param *sink worker's server session.
+ * @return true if sink has a session, else false.
+ */
+static bool Server_ConnectSink(SERVER_SINK_T *sink)
+{
+	if (sink->session == NULL)
+	{
+		sink->session = Server_EstablishSession(IPC_SERVER_PORT, IP_ADDRESS);
+		sink->generation++;
+		if (sink->session != NULL && !DefineServerObjects(sink->session))
+		{
+			Server_CloseSession(&sink->session);
+		}
+	}
+	return (sink->session != NULL);
+}
+
+/**
+ * @brief Re-establish a worker's client session if it was dropped.
+ * @param *sink worker's client session.
+ * @return true if sink has a session, else false.
+ */
+static bool Client_ConnectSink(CLIENT_SINK_T *sink)
+{
+	if (sink->session == NULL)
+	{
+		sink->session = Client_EstablishSession(IPC_CLIENT_PORT, IP_ADDRESS);
+		sink->generation++;
+		if (sink->session != NULL && !DefineClientObjects(sink->session))
+		{
+			Client_CloseSession(&sink->session);
+		}
+	}
+	return (sink->session != NULL);
+}
+
+/**
+ * @brief Server write worker handler, updates the led resources queued for one led constrained
+ *        device in one write operation.
+ * @param *items work items holding led state, all for the same device.
+ * @param count number of items.
+ * @param *results set to whether each write succeeded.
+ * @param *context holds the worker's server sink.
+ */
+static void ServerWriteHandler(const WorkItem *items, unsigned int count, bool *results,
+		void *context)
+{
+	struct timespec start;
+	unsigned int i;
+
+	/* Only this worker touches the led's resolved definition, bindings are not modified */
+	if (!Server_ConnectSink(context))
+	{
+		LOG(LOG_ERR, "Writing to LED resource on server failed.\n");
+		memset(results, 0, count * sizeof(*results));
+		return;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	WriteLedResources(context, items, count, results);
+	for (i = 0; i < count; i++)
+	{
+		if (!results[i])
+		{
+			LOG(LOG_ERR, "Writing to LED resource on server failed.\n");
+			continue;
+		}
+		Histogram_RecordSince(&writeLatency, &start);
+		Histogram_RecordSince(&totalLatency, &items[i].received);
+	}
+}
+
+/**
+ * @brief Client set worker handler, sets the gateway's own led resource.
+ * @param *item work item holding led state.
+ * @param *context holds the worker's client sink.
+ * @return true if set succeeded, else false.
+ */
+static bool ClientSetHandler(const WorkItem *item, void *context)
+{
+	struct timespec start;
+
+	if (!__atomic_load_n(&isProvisioned, __ATOMIC_ACQUIRE))
+	{
+		/* Led state is replayed once the gateway is provisioned */
+		LOG(LOG_DBG, "Gateway not provisioned yet, client set deferred");
+		return true;
+	}
+
+	/* Only this worker touches the led's instance existence, bindings are not modified */
+	if (!Client_ConnectSink(context))
+	{
+		LOG(LOG_ERR, "Setting to LED resource on client failed.\n");
+		return false;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (!SetLedResource(context, (LedTarget *)item->target, item->value))
+	{
+		LOG(LOG_ERR, "Setting to LED resource on client failed.\n");
+		return false;
+	}
+	Histogram_RecordSince(&setLatency, &start);
+	return true;
+}
+
+/**
+ * @brief Button gateway application to poll a button press on constrained device,
+ *        and set the led on another. Also send a flow message to user for change in LED state.
+ */
+int main(int argc, char **argv)
+{
+	int i, ret;
+	const char *fptr = NULL;
+	bool binaryLog = false;
+	const char *bindingsFile = BINDINGS_FILE;
+	const char *reportFile = NULL;
+	GpioConfig gpioConfig = {GpioBackend_Sysfs, HEARTBEAT_LED_PIN, GPIO_SYSFS_ROOT, NULL};
+	LogConfig logConfig;
+	unsigned int eventQueueSize;
+
+	ret = ParseCommandArgs(argc, argv, &fptr, &binaryLog, &gpioConfig, &bindingsFile,
+			&reportFile);
+	if (ret <= 0)
+	{
+		return ret;
+	}
+	Startup_Init(&startupReport, reportFile);
+
+	/* Log file is reopened on SIGHUP and latency reported on SIGUSR1, which no thread may take
+	   by default */
+	Reactor_BlockSignal(SIGHUP);
+	Reactor_BlockSignal(SIGUSR1);
+#ifdef TRACE_ENABLED
+	Reactor_BlockSignal(SIGUSR2);
+#endif
+	TRACE_NAME_THREAD("Event loop");
+	if (!Log_LoadConfig(&logConfig, bindingsFile))
+	{
+		LOG(LOG_WARN, "Log file rotation falls back to defaults");
+	}
+	logConfig.file = fptr;
+	logConfig.binary = binaryLog;
+
+	/* Queued messages are written out whenever main returns */
+	if (Log_Start(&logConfig))
+	{
+		atexit(Log_Stop);
+	}
+
+	AwaServerSession *serverSession = NULL;
+	CLIENT_SINK_T setterSink = {NULL, 0, 0};
+	SERVER_SINK_T writerSink = {NULL, 0, 0};
+	OutboxConfig outboxConfig;
+	MetricsConfig metricsConfig;
+	SocketSnapshot serverSockets;
+	SocketSnapshot clientSockets;
+	GATEWAY_T gateway = {0};
+
+	LOG(LOG_INFO, "Button Gateway Application");
+	LOG(LOG_INFO, "------------------------\n");
+
+	if (!Gpio_Open(&heartbeatGpio, &gpioConfig))
+	{
+		LOG(LOG_WARN, "Heartbeat led on gpio %u is not available", gpioConfig.pin);
+	}
+
+	if (!Bindings_Load(&bindings, bindingsFile))
+	{
+		LOG(LOG_FATAL, "Failed to load bindings from %s", bindingsFile);
+		return -1;
+	}
+
+	if (!Reactor_Init(&reactor))
+	{
+		LOG(LOG_FATAL, "Failed to create event loop");
+		return -1;
+	}
+
+	if (!Rtt_LoadConfig(&timeoutConfig, bindingsFile))
+	{
+		LOG(LOG_WARN, "Operation timeouts fall back to defaults");
+	}
+
+	if (!Registry_Init(&registry, &bindings))
+	{
+		LOG(LOG_FATAL, "Failed to create registration cache");
+		return -1;
+	}
+
+	/* Every notification is handled in order, so each button gets room for a burst of its own */
+	eventQueueSize = bindings.numBindings * EVENT_QUEUE_BUTTON_DEPTH;
+	if (!EventQueue_Init(&buttonEvents,
+			eventQueueSize > EVENT_QUEUE_MIN_SIZE ? eventQueueSize : EVENT_QUEUE_MIN_SIZE))
+	{
+		LOG(LOG_FATAL, "Failed to create button event queue");
+		return -1;
+	}
+
+	/*
+	 * Server side, Flow and provisioning don't depend on each other. Server side is brought up
+	 * first, as it is what serves button presses. Flow registers on its own thread and
+	 * provisioning is polled from the event loop.
+	 */
+	Startup_Begin(&startupReport, StartupPhase_ServerSession);
+	Reactor_SnapshotSockets(&serverSockets);
+	serverSession = Server_EstablishSession(IPC_SERVER_PORT, IP_ADDRESS);
+	if (serverSession == NULL)
+	{
+		LOG(LOG_ERR, "Failed to establish server session\n");
+	}
+	else
+	{
+		Startup_End(&startupReport, StartupPhase_ServerSession);
+		WatchSession(&serverSockets, ServerSessionReadable, serverSession);
+	}
+
+	/* Sessions' sockets are found by diffing the open sockets, so the client session is connected
+	   before any thread that opens sockets is started. If the client daemon isn't up yet, the
+	   provisioning check connects it later */
+	Reactor_SnapshotSockets(&clientSockets);
+	gateway.clientSession = Client_EstablishSession(IPC_CLIENT_PORT, IP_ADDRESS);
+	if (gateway.clientSession != NULL)
+	{
+		WatchSession(&clientSockets, ClientSessionReadable, gateway.clientSession);
+	}
+
+	Startup_Begin(&startupReport, StartupPhase_ServerDefine);
+	if (DefineServerObjects(serverSession))
+	{
+		Startup_End(&startupReport, StartupPhase_ServerDefine);
+
+		/* Each actuation worker has its own session, Awa sessions are not thread safe */
+		writerSink.session = Server_EstablishSession(IPC_SERVER_PORT, IP_ADDRESS);
+		writerSink.generation = 1;
+
+		/* Resolve led definitions now that objects are defined, so writes don't look them up */
+		for (i = 0; writerSink.session != NULL && i < bindings.numLeds; i++)
+		{
+			if (!ResolveLedResource(&writerSink, &bindings.leds[i]))
+			{
+				LOG(LOG_WARN, "LED resource %s is not defined on server", bindings.leds[i].path);
+			}
+		}
+
+		Histogram_Init(&dispatchLatency, "dispatch");
+		Histogram_Init(&writeLatency, "server write");
+		Histogram_Init(&setLatency, "client set");
+		Histogram_Init(&flowLatency, "flow send");
+		Histogram_Init(&totalLatency, "total");
+
+		/* Client set session is connected by its worker, once the gateway is provisioned. Led
+		   updates are coalesced per led and written a device at a time, Flow messages are all
+		   sent */
+		Worker_StartBatched(&serverWriter, "Server write", bindings.numLeds, ServerWriteHandler,
+				&writerSink);
+		Worker_Start(&clientSetter, "Client set", bindings.numLeds, ClientSetHandler, &setterSink);
+		if (!Outbox_LoadConfig(&outboxConfig, bindingsFile) ||
+			!Outbox_Open(&flowOutbox, &outboxConfig))
+		{
+			LOG(LOG_WARN, "Flow outbox not available, messages are sent without retry");
+		}
+		Worker_Start(&flowSender, "Flow send", 0, FlowSendHandler, NULL);
+
+		/* Flow registration may take long or fail for a while, it must not hold up actuation */
+		Startup_Begin(&startupReport, StartupPhase_FlowConnect);
+		FlowConnection_Start(&flowConnection, FlowConnected, NULL);
+		if (Reactor_AddFileWatch(&reactor, FLOW_CONFIG_FILE, FlowConfigWritten, NULL) < 0)
+		{
+			LOG(LOG_WARN, "Not watching %s, Flow registration relies on retries", FLOW_CONFIG_FILE);
+		}
+
+		gateway.serverSession = serverSession;
+		buttonEventsNotifier = Reactor_AddNotifier(&reactor, HandleButtonEvents, &gateway);
+		registrationNotifier = Reactor_AddNotifier(&reactor, SynchroniseEndpoints, &gateway);
+
+		/* Subscribe before listing clients, so no registration can fall in between */
+		AwaServerSession_SetClientRegisterEventCallback(serverSession, ClientRegisterCallback, NULL);
+		AwaServerSession_SetClientUpdateEventCallback(serverSession, ClientUpdateCallback, NULL);
+		AwaServerSession_SetClientDeregisterEventCallback(serverSession,
+				ClientDeregisterCallback, NULL);
+
+		Startup_Begin(&startupReport, StartupPhase_FirstObservation);
+		Startup_Begin(&startupReport, StartupPhase_AllObserved);
+		if (CheckConstrainedRegistered(serverSession))
+		{
+			for (i = 0; i < registry.numEndpoints; i++)
+			{
+				if (!registry.endpoints[i].registered)
+				{
+					LOG(LOG_INFO, "Waiting for constrained device '%s' to be up",
+							registry.endpoints[i].name);
+				}
+			}
+
+			LOG(LOG_INFO, "Wait until device is provisioned\n");
+			heartbeatState = true;
+			SetHeartbeatLed(heartbeatState);
+
+			Startup_Begin(&startupReport, StartupPhase_Provisioning);
+			provisioningNotifier = Reactor_AddNotifier(&reactor, CheckProvisioning, &gateway);
+			provisioningTimer = Reactor_AddTimer(&reactor, 0, 0, CheckProvisioning, &gateway);
+			Reactor_Notify(provisioningNotifier);
+
+			Reactor_AddTimer(&reactor, WORKER_STATS_INTERVAL, WORKER_STATS_INTERVAL,
+					WorkerStatsTimeout, NULL);
+			Reactor_AddTimer(&reactor, OUTBOX_DRAIN_INTERVAL, OUTBOX_DRAIN_INTERVAL,
+					OutboxDrainTimeout, NULL);
+			Reactor_AddTimer(&reactor, BREAKER_PROBE_INTERVAL, BREAKER_PROBE_INTERVAL,
+					ProbeUnreachableDevices, NULL);
+			Reactor_AddSignal(&reactor, SIGHUP, ReopenLog, NULL);
+			Reactor_AddSignal(&reactor, SIGUSR1, ReportLatency, NULL);
+#ifdef TRACE_ENABLED
+			Reactor_AddSignal(&reactor, SIGUSR2, DumpTrace, NULL);
+#endif
+			if (!Metrics_LoadConfig(&metricsConfig, bindingsFile) ||
+				!Metrics_Start(&metricsServer, &reactor, &metricsConfig, CollectMetrics, NULL))
+			{
+				LOG(LOG_WARN, "Metrics endpoint not available");
+			}
+
+			if (!Reactor_Run(&reactor))
+			{
+				LOG(LOG_ERR, "Event loop failed");
+			}
+		}
+		else
+		{
+			LOG(LOG_ERR, "Failed to list registered constrained devices");
+		}
+	}
+
+	/* Should never come here */
+	SetHeartbeatLed(false);
+	Gpio_Close(&heartbeatGpio);
+	Metrics_Stop(&metricsServer);
+	Reactor_Destroy(&reactor);
+
+	Worker_Stop(&serverWriter);
+	Worker_Stop(&clientSetter);
+	FlowConnection_Stop(&flowConnection);
+	Worker_Stop(&flowSender);
+	Outbox_Close(&flowOutbox);
+
+	Server_CloseSession(&writerSink.session);
+	Client_CloseSession(&setterSink.session);
+	Server_CloseSession(&serverSession);
+	if (gateway.provisioningSubscription != NULL)
+	{
+		AwaClientChangeSubscription_Free(&gateway.provisioningSubscription);
+	}
+	Client_CloseSession(&gateway.clientSession);
+
+	for (i = 0; i < bindings.numBindings; i++)
+	{
+		if (bindings.bindings[i].observation != NULL)
+		{
+			AwaServerObservation_Free(&bindings.bindings[i].observation);
+		}
 	}
+	EventQueue_Free(&buttonEvents);
+	Registry_Free(&registry);
+	Bindings_Free(&bindings);
 
 	LOG(LOG_INFO, "Button Gateway Application Failure");
 
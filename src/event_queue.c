@@ -0,0 +1,192 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file event_queue.c
+ * @brief Bounded ring buffer of button events. The observe callback and the main loop run on the
+ *        same thread, so no locking is done here.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "event_queue.h"
+#include "log.h"
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Allocate queue and reset its statistics.
+ * @param *queue queue to initialize.
+ * @param capacity number of events the queue holds.
+ * @return true on success, else false.
+ */
+bool EventQueue_Init(EventQueue *queue, unsigned int capacity)
+{
+	memset(queue, 0, sizeof(*queue));
+	queue->events = calloc(capacity, sizeof(*queue->events));
+	if (queue->events == NULL)
+	{
+		LOG(LOG_ERR, "Failed to allocate event queue of %u events", capacity);
+		return false;
+	}
+	queue->capacity = capacity;
+	return true;
+}
+
+/**
+ * @brief Free queue storage.
+ * @param *queue queue to free.
+ */
+void EventQueue_Free(EventQueue *queue)
+{
+	free(queue->events);
+	memset(queue, 0, sizeof(*queue));
+}
+
+/**
+ * @brief Queue a counter notification, stamping it with a sequence number and receive time.
+ *        If the queue is full the oldest event is dropped, so the latest state is never lost.
+ * @param *queue queue to add to.
+ * @param *source button the counter belongs to, used for gap detection.
+ * @param counter button counter value.
+ * @return true if no event had to be dropped, else false.
+ */
+bool EventQueue_Push(EventQueue *queue, EventSource *source, int64_t counter)
+{
+	ButtonEvent *event;
+	bool success = true;
+
+	if (source->hasLastCounter)
+	{
+		int64_t delta = counter - source->lastCounter;
+
+		if (delta > 1)
+		{
+			source->gaps += delta - 1;
+			queue->gaps += delta - 1;
+			LOG(LOG_WARN, "Missed %lld button events, %lu in total",
+					(long long)(delta - 1), queue->gaps);
+		}
+		else if (delta < 0)
+		{
+			LOG(LOG_DBG, "Button counter restarted from %lld", (long long)counter);
+		}
+	}
+	source->lastCounter = counter;
+	source->hasLastCounter = true;
+
+	if (queue->depth == queue->capacity)
+	{
+		queue->head = (queue->head + 1) % queue->capacity;
+		queue->depth--;
+		queue->drops++;
+		success = false;
+	}
+
+	event = &queue->events[(queue->head + queue->depth) % queue->capacity];
+	event->source = source;
+	event->counter = counter;
+	event->sequence = queue->nextSequence++;
+	queue->received++;
+	clock_gettime(CLOCK_MONOTONIC, &event->received);
+
+	queue->depth++;
+	if (queue->depth > queue->maxDepth)
+	{
+		queue->maxDepth = queue->depth;
+	}
+	return success;
+}
+
+/**
+ * @brief Remove the oldest event from queue.
+ * @param *queue queue to take from.
+ * @param *event filled with the removed event.
+ * @return true if an event was removed, false if queue is empty.
+ */
+bool EventQueue_Pop(EventQueue *queue, ButtonEvent *event)
+{
+	if (queue->depth == 0)
+	{
+		return false;
+	}
+
+	*event = queue->events[queue->head];
+	queue->head = (queue->head + 1) % queue->capacity;
+	queue->depth--;
+	return true;
+}
+
+/**
+ * @brief Get number of events waiting in queue.
+ * @param *queue queue to inspect.
+ * @return queue depth.
+ */
+unsigned int EventQueue_GetDepth(const EventQueue *queue)
+{
+	return queue->depth;
+}
+
+/**
+ * @brief Get number of events pushed since the queue was initialized.
+ * @param *queue queue to inspect.
+ * @return event count.
+ */
+unsigned long EventQueue_GetReceived(const EventQueue *queue)
+{
+	return queue->received;
+}
+
+/**
+ * @brief Get number of events dropped because the queue was full.
+ * @param *queue queue to inspect.
+ * @return drop count.
+ */
+unsigned long EventQueue_GetDrops(const EventQueue *queue)
+{
+	return queue->drops;
+}
+
+/**
+ * @brief Get number of button counter increments that were never notified.
+ * @param *queue queue to inspect.
+ * @return gap count.
+ */
+unsigned long EventQueue_GetGaps(const EventQueue *queue)
+{
+	return queue->gaps;
+}
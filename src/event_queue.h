@@ -0,0 +1,153 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file event_queue.h
+ * @brief Header file for the bounded queue of button events filled by the observe callback and
+ *        drained in order by the main loop.
+ */
+
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+//! @cond Doxygen_Suppress
+#define EVENT_QUEUE_MIN_SIZE		(64)
+#define EVENT_QUEUE_BUTTON_DEPTH	(8)
+//! @endcond
+
+/**
+ * A structure to contain counter tracking for one button resource.
+ */
+typedef struct
+{
+	/*@{*/
+	int64_t lastCounter; /**< last counter value seen */
+	bool hasLastCounter; /**< true once a counter value has been seen */
+	unsigned long gaps; /**< counter increments never notified for this button */
+	void *context; /**< owner of the source */
+	/*@}*/
+}EventSource;
+
+/**
+ * A structure to contain one button counter notification.
+ */
+typedef struct
+{
+	/*@{*/
+	EventSource *source; /**< button the event came from */
+	int64_t counter; /**< button counter value reported by the device */
+	uint32_t sequence; /**< gateway side sequence number, increments for every queued event */
+	struct timespec received; /**< monotonic time the notification was received */
+	/*@}*/
+}ButtonEvent;
+
+/**
+ * A structure to contain a ring buffer of button events and its statistics.
+ */
+typedef struct
+{
+	/*@{*/
+	ButtonEvent *events; /**< ring storage */
+	unsigned int capacity; /**< size of the ring */
+	unsigned int head; /**< index of the oldest event */
+	unsigned int depth; /**< number of queued events */
+	unsigned int maxDepth; /**< high water mark of depth */
+	uint32_t nextSequence; /**< sequence number for the next event */
+	unsigned long received; /**< events pushed */
+	unsigned long drops; /**< events overwritten because the queue was full */
+	unsigned long gaps; /**< counter increments never notified, over all sources */
+	/*@}*/
+}EventQueue;
+
+/**
+ * @brief Allocate queue and reset its statistics.
+ * @param *queue queue to initialize.
+ * @param capacity number of events the queue holds.
+ * @return true on success, else false.
+ */
+bool EventQueue_Init(EventQueue *queue, unsigned int capacity);
+
+/**
+ * @brief Free queue storage.
+ * @param *queue queue to free.
+ */
+void EventQueue_Free(EventQueue *queue);
+
+/**
+ * @brief Queue a counter notification, stamping it with a sequence number and receive time.
+ *        If the queue is full the oldest event is dropped, so the latest state is never lost.
+ * @param *queue queue to add to.
+ * @param *source button the counter belongs to, used for gap detection.
+ * @param counter button counter value.
+ * @return true if no event had to be dropped, else false.
+ */
+bool EventQueue_Push(EventQueue *queue, EventSource *source, int64_t counter);
+
+/**
+ * @brief Remove the oldest event from queue.
+ * @param *queue queue to take from.
+ * @param *event filled with the removed event.
+ * @return true if an event was removed, false if queue is empty.
+ */
+bool EventQueue_Pop(EventQueue *queue, ButtonEvent *event);
+
+/**
+ * @brief Get number of events waiting in queue.
+ * @param *queue queue to inspect.
+ * @return queue depth.
+ */
+unsigned int EventQueue_GetDepth(const EventQueue *queue);
+
+/**
+ * @brief Get number of events pushed since the queue was initialized.
+ * @param *queue queue to inspect.
+ * @return event count.
+ */
+unsigned long EventQueue_GetReceived(const EventQueue *queue);
+
+/**
+ * @brief Get number of events dropped because the queue was full.
+ * @param *queue queue to inspect.
+ * @return drop count.
+ */
+unsigned long EventQueue_GetDrops(const EventQueue *queue);
+
+/**
+ * @brief Get number of button counter increments that were never notified.
+ * @param *queue queue to inspect.
+ * @return gap count.
+ */
+unsigned long EventQueue_GetGaps(const EventQueue *queue);
+
+#endif	/* EVENT_QUEUE_H */
@@ -0,0 +1,314 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file flow_connection.c
+ * @brief Flow connection manager. Registration with Flow can take seconds, or fail for as long as
+ *        the network is down, so it runs on its own thread and the rest of the gateway only ever
+ *        reads the connection state.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <flow/flowmessaging.h>
+
+#include "flow_connection.h"
+#include "flow_interface.h"
+#include "log.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define MS_PER_SECOND	(1000)
+#define NS_PER_MS		(1000000)
+#define NS_PER_SECOND	(1000000000)
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Get printable name of a connection state.
+ * @param state connection state.
+ * @return state name.
+ */
+const char *FlowConnection_StateToString(FlowState state)
+{
+	switch (state)
+	{
+		case FlowState_Disconnected:
+			return "disconnected";
+		case FlowState_Connecting:
+			return "connecting";
+		case FlowState_Connected:
+			return "connected";
+	}
+	return "unknown";
+}
+
+/**
+ * @brief Change connection state. Caller holds the lock.
+ * @param *connection connection to change.
+ * @param state new state.
+ */
+static void SetState(FlowConnection *connection, FlowState state)
+{
+	__atomic_store_n(&connection->state, state, __ATOMIC_RELEASE);
+	connection->stats.state = state;
+}
+
+/**
+ * @brief Pick a delay in the upper half of the backoff, so gateways that lost Flow together don't
+ *        come back together.
+ * @param *connection connection holding the random state.
+ * @param backoff current backoff in milliseconds.
+ * @return delay in milliseconds.
+ */
+static unsigned int Jitter(FlowConnection *connection, unsigned int backoff)
+{
+	return backoff / 2 + rand_r(&connection->seed) % (backoff / 2 + 1);
+}
+
+/**
+ * @brief Sleep until a delay elapsed, a retry is requested or the manager is stopped. Caller
+ *        holds the lock.
+ * @param *connection connection to wait on.
+ * @param delay milliseconds to wait.
+ */
+static void Wait(FlowConnection *connection, unsigned int delay)
+{
+	struct timespec deadline;
+
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += delay / MS_PER_SECOND;
+	deadline.tv_nsec += (long)(delay % MS_PER_SECOND) * NS_PER_MS;
+	if (deadline.tv_nsec >= NS_PER_SECOND)
+	{
+		deadline.tv_sec++;
+		deadline.tv_nsec -= NS_PER_SECOND;
+	}
+
+	while (connection->running && !connection->retry &&
+		pthread_cond_timedwait(&connection->wakeup, &connection->lock, &deadline) != ETIMEDOUT)
+	{
+	}
+}
+
+/**
+ * @brief Connection manager thread, registers the device whenever it isn't connected.
+ * @param *arg connection.
+ * @return NULL.
+ */
+static void *ConnectionThread(void *arg)
+{
+	FlowConnection *connection = arg;
+	unsigned int backoff = FLOW_BACKOFF_MIN;
+	bool connected;
+
+	pthread_mutex_lock(&connection->lock);
+	while (connection->running)
+	{
+		if (connection->stats.state == FlowState_Connected)
+		{
+			pthread_cond_wait(&connection->wakeup, &connection->lock);
+			continue;
+		}
+
+		SetState(connection, FlowState_Connecting);
+		connection->stats.attempts++;
+		pthread_mutex_unlock(&connection->lock);
+
+		connected = InitializeAndRegisterFlowDevice();
+
+		pthread_mutex_lock(&connection->lock);
+		if (connected)
+		{
+			SetState(connection, FlowState_Connected);
+			connection->stats.connects++;
+			connection->stats.backoffMs = 0;
+			backoff = FLOW_BACKOFF_MIN;
+			LOG(LOG_INFO, "Connected to Flow");
+
+			if (connection->onConnected != NULL)
+			{
+				pthread_mutex_unlock(&connection->lock);
+				connection->onConnected(connection->context);
+				pthread_mutex_lock(&connection->lock);
+			}
+			continue;
+		}
+
+		SetState(connection, FlowState_Disconnected);
+		connection->stats.backoffMs = Jitter(connection, backoff);
+		LOG(LOG_WARN, "Flow registration failed, retrying in %u ms", connection->stats.backoffMs);
+		Wait(connection, connection->stats.backoffMs);
+		if (connection->retry)
+		{
+			connection->retry = false;
+			backoff = FLOW_BACKOFF_MIN;
+		}
+		else
+		{
+			backoff = backoff < FLOW_BACKOFF_MAX / 2 ? backoff * 2 : FLOW_BACKOFF_MAX;
+		}
+	}
+	pthread_mutex_unlock(&connection->lock);
+	return NULL;
+}
+
+/**
+ * @brief Start connection manager thread, which registers the device right away.
+ * @param *connection connection to start.
+ * @param onConnected called after each registration, may be NULL.
+ * @param *context passed to onConnected.
+ * @return true if thread started, else false.
+ */
+bool FlowConnection_Start(FlowConnection *connection, FlowConnectedCallback onConnected,
+		void *context)
+{
+	pthread_condattr_t attributes;
+
+	memset(connection, 0, sizeof(*connection));
+	connection->onConnected = onConnected;
+	connection->context = context;
+	connection->running = true;
+	connection->seed = time(NULL) ^ getpid();
+	SetState(connection, FlowState_Disconnected);
+
+	pthread_mutex_init(&connection->lock, NULL);
+	pthread_condattr_init(&attributes);
+	pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+	pthread_cond_init(&connection->wakeup, &attributes);
+	pthread_condattr_destroy(&attributes);
+
+	if (pthread_create(&connection->thread, NULL, ConnectionThread, connection) != 0)
+	{
+		LOG(LOG_ERR, "Failed to start Flow connection manager");
+		connection->running = false;
+		pthread_cond_destroy(&connection->wakeup);
+		pthread_mutex_destroy(&connection->lock);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Check whether the device is registered with Flow. Never blocks.
+ * @param *connection connection to check.
+ * @return true if connected, else false.
+ */
+bool FlowConnection_IsConnected(FlowConnection *connection)
+{
+	return (__atomic_load_n(&connection->state, __ATOMIC_ACQUIRE) == FlowState_Connected);
+}
+
+/**
+ * @brief Report a failed send. If the device is no longer logged in, the connection is marked
+ *        lost and the manager reconnects. Only call from the thread sending to Flow, after it
+ *        stopped using the connection.
+ * @param *connection connection used.
+ */
+void FlowConnection_ReportFailure(FlowConnection *connection)
+{
+	if (!FlowConnection_IsConnected(connection) || FlowClient_IsDeviceLoggedIn())
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&connection->lock);
+	if (connection->stats.state == FlowState_Connected)
+	{
+		LOG(LOG_WARN, "Lost connection to Flow");
+		SetState(connection, FlowState_Disconnected);
+		connection->stats.losses++;
+		pthread_cond_signal(&connection->wakeup);
+	}
+	pthread_mutex_unlock(&connection->lock);
+}
+
+/**
+ * @brief Retry registration right away with the backoff reset, e.g. because registration data
+ *        changed. Does nothing while connected. Safe to call from any thread.
+ * @param *connection connection to retry.
+ */
+void FlowConnection_Retry(FlowConnection *connection)
+{
+	pthread_mutex_lock(&connection->lock);
+	/* An attempt in progress may have read the old data, so it is retried as well */
+	if (connection->running && connection->stats.state != FlowState_Connected)
+	{
+		connection->retry = true;
+		pthread_cond_signal(&connection->wakeup);
+	}
+	pthread_mutex_unlock(&connection->lock);
+}
+
+/**
+ * @brief Get connection statistics.
+ * @param *connection connection to inspect.
+ * @param *stats filled with a snapshot of the statistics.
+ */
+void FlowConnection_GetStats(FlowConnection *connection, FlowConnectionStats *stats)
+{
+	pthread_mutex_lock(&connection->lock);
+	*stats = connection->stats;
+	pthread_mutex_unlock(&connection->lock);
+}
+
+/**
+ * @brief Stop connection manager thread, waiting for a registration attempt in progress.
+ * @param *connection connection to stop.
+ */
+void FlowConnection_Stop(FlowConnection *connection)
+{
+	pthread_mutex_lock(&connection->lock);
+	if (!connection->running)
+	{
+		pthread_mutex_unlock(&connection->lock);
+		return;
+	}
+	connection->running = false;
+	pthread_cond_signal(&connection->wakeup);
+	pthread_mutex_unlock(&connection->lock);
+
+	pthread_join(connection->thread, NULL);
+	pthread_cond_destroy(&connection->wakeup);
+	pthread_mutex_destroy(&connection->lock);
+}
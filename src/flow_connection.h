@@ -0,0 +1,150 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file flow_connection.h
+ * @brief Header file for the Flow connection manager, a thread which registers the device with
+ *        Flow in the background and reconnects with jittered exponential backoff.
+ */
+
+#ifndef FLOW_CONNECTION_H
+#define FLOW_CONNECTION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+//! @cond Doxygen_Suppress
+#define FLOW_BACKOFF_MIN	(1000)
+#define FLOW_BACKOFF_MAX	(300000)
+//! @endcond
+
+/**
+ * Flow connection state.
+ */
+typedef enum
+{
+	FlowState_Disconnected, /**< not registered, waiting for the next attempt */
+	FlowState_Connecting, /**< registration attempt in progress */
+	FlowState_Connected /**< device registered and logged in */
+}FlowState;
+
+/**
+ * @brief Called on the connection manager thread whenever the device got registered.
+ * @param *context pointer passed to FlowConnection_Start.
+ */
+typedef void (*FlowConnectedCallback)(void *context);
+
+/**
+ * A structure to contain a snapshot of connection statistics.
+ */
+typedef struct
+{
+	/*@{*/
+	FlowState state; /**< current state */
+	unsigned long attempts; /**< registration attempts */
+	unsigned long connects; /**< successful registrations */
+	unsigned long losses; /**< connections reported lost */
+	unsigned int backoffMs; /**< delay before the next attempt while disconnected */
+	/*@}*/
+}FlowConnectionStats;
+
+/**
+ * A structure to contain the connection manager thread and its state.
+ */
+typedef struct
+{
+	/*@{*/
+	pthread_t thread; /**< connection manager thread */
+	pthread_mutex_t lock; /**< protects everything below, except state */
+	pthread_cond_t wakeup; /**< signalled when connection is lost or manager is stopped */
+	bool running; /**< cleared by FlowConnection_Stop */
+	bool retry; /**< set by FlowConnection_Retry to cut the backoff short */
+	int state; /**< FlowState, accessed atomically so readers never take the lock */
+	unsigned int seed; /**< jitter random state */
+	FlowConnectedCallback onConnected; /**< called after each registration */
+	void *context; /**< passed to onConnected */
+	FlowConnectionStats stats; /**< statistics */
+	/*@}*/
+}FlowConnection;
+
+/**
+ * @brief Start connection manager thread, which registers the device right away.
+ * @param *connection connection to start.
+ * @param onConnected called after each registration, may be NULL.
+ * @param *context passed to onConnected.
+ * @return true if thread started, else false.
+ */
+bool FlowConnection_Start(FlowConnection *connection, FlowConnectedCallback onConnected,
+		void *context);
+
+/**
+ * @brief Check whether the device is registered with Flow. Never blocks.
+ * @param *connection connection to check.
+ * @return true if connected, else false.
+ */
+bool FlowConnection_IsConnected(FlowConnection *connection);
+
+/**
+ * @brief Report a failed send. If the device is no longer logged in, the connection is marked
+ *        lost and the manager reconnects. Only call from the thread sending to Flow, after it
+ *        stopped using the connection.
+ * @param *connection connection used.
+ */
+void FlowConnection_ReportFailure(FlowConnection *connection);
+
+/**
+ * @brief Retry registration right away with the backoff reset, e.g. because registration data
+ *        changed. Does nothing while connected. Safe to call from any thread.
+ * @param *connection connection to retry.
+ */
+void FlowConnection_Retry(FlowConnection *connection);
+
+/**
+ * @brief Get connection statistics.
+ * @param *connection connection to inspect.
+ * @param *stats filled with a snapshot of the statistics.
+ */
+void FlowConnection_GetStats(FlowConnection *connection, FlowConnectionStats *stats);
+
+/**
+ * @brief Stop connection manager thread, waiting for a registration attempt in progress.
+ * @param *connection connection to stop.
+ */
+void FlowConnection_Stop(FlowConnection *connection);
+
+/**
+ * @brief Get printable name of a connection state.
+ * @param state connection state.
+ * @return state name.
+ */
+const char *FlowConnection_StateToString(FlowState state);
+
+#endif	/* FLOW_CONNECTION_H */
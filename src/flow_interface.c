@@ -44,6 +44,7 @@
 #include <unistd.h>
 #include <flow/flowmessaging.h>
 #include <libconfig.h>
+#include "flow_interface.h"
 #include "log.h"
 
 /***************************************************************************************************
@@ -54,10 +55,6 @@
 #define MAX_SIZE (256)
 /** Message expiry timeout on flow cloud. */
 #define MESSAGE_EXPIRY_TIMEOUT (20)
-/** Configuration file to get registration data stored by provisioning app. */
-#define CONFIG_FILE "/etc/lwm2m/flow_access.cfg"
-/** Number of trials for reading configuration file */
-#define FILE_READ_TRIALS (5)
 
 /***************************************************************************************************
  * Typedef
@@ -76,6 +73,26 @@ typedef struct
 	/*@}*/
 }RegistrationData;
 
+/**
+ * A structure to contain the logged in device's identity, resolved once per login.
+ */
+typedef struct
+{
+	/*@{*/
+	bool resolved; /**< whether IDs below belong to the current login */
+	char userId[MAX_SIZE]; /**< ID of the user owning the device */
+	char deviceId[MAX_SIZE]; /**< ID of the device */
+	FlowMemoryManager memoryManager; /**< memory manager kept for the life of the login */
+	unsigned long lookupsAvoided; /**< logged in device lookups saved by the cached IDs */
+	/*@}*/
+}FlowSession;
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+/** Identity of the logged in device. */
+static FlowSession flowSession;
 
 /***************************************************************************************************
  * Implementation
@@ -102,8 +119,8 @@ static bool GetValueForKey(config_t *cfg, char *dest, const char *key)
 }
 
 /**
- * @brief Read device resgitration settings from configuration file.
- *        And if not found, ask user for settings.
+ * @brief Read device resgitration settings from configuration file. The file is only read once,
+ *        callers retry when it is written.
  * @param *regData pointer to device registration data.
  * @return true if configuration read successfuly, else false.
  */
@@ -111,40 +128,25 @@ static bool GetConfigData(RegistrationData *regData)
 {
 	config_t cfg;
 	bool success = false;
-	int i;
 
 	config_init(&cfg);
 
-	for (i = FILE_READ_TRIALS; i > 0; i--)
+	if (!config_read_file(&cfg, FLOW_CONFIG_FILE))
 	{
-		if (!config_read_file(&cfg, CONFIG_FILE))
-		{
-			LOG(LOG_INFO, "Waiting for config data");
-			sleep(1);
-		}
-		else
-		{
-			if (GetValueForKey(&cfg, regData->url, "URL") &&
-				GetValueForKey(&cfg, regData->key, "CustomerKey") &&
-				GetValueForKey(&cfg, regData->secret, "CustomerSecret") &&
-				GetValueForKey(&cfg, regData->rememberMeToken, "RememberMeToken"))
-			{
-				success = true;
-			}
-			else
-			{
-				LOG(LOG_ERR, "Failed to read config data");
-			}
-			config_destroy(&cfg);
-			break;
-		}
+		LOG(LOG_INFO, "Waiting for config data");
 	}
-
-	if (i == 0)
+	else if (GetValueForKey(&cfg, regData->url, "URL") &&
+		GetValueForKey(&cfg, regData->key, "CustomerKey") &&
+		GetValueForKey(&cfg, regData->secret, "CustomerSecret") &&
+		GetValueForKey(&cfg, regData->rememberMeToken, "RememberMeToken"))
+	{
+		success = true;
+	}
+	else
 	{
-		LOG(LOG_ERR, "Failed to read config file");
-		config_destroy(&cfg);
+		LOG(LOG_ERR, "Failed to read config data");
 	}
+	config_destroy(&cfg);
 	return success;
 }
 
@@ -205,65 +207,49 @@ static bool InitialiseLibFlow(const char *url,
 
 
 /**
- * @brief Get user id to which the device is registered.
- * @param *userId pointer to device's user Id.
- * @return true if user id is retrieved successfully, else false.
+ * @brief Release the cached identity of the logged in device.
  */
-static bool GetUserId(char *userId)
+static void ForgetSessionIds(void)
 {
-	FlowMemoryManager memoryManager = FlowMemoryManager_New();
-
-	if (memoryManager)
-	{
-		FlowDevice device = FlowClient_GetLoggedInDevice(memoryManager);
-		if (device)
-		{
-			FlowID temp;
-
-			temp = FlowUser_GetUserID(FlowDevice_RetrieveOwner(device));
-			strcpy(userId, temp);
-			FlowMemoryManager_Free(&memoryManager);
-			return true;
-		}
-		else
-		{
-			LOG(LOG_ERR, "Failed to get logged in device");
-		}
-		FlowMemoryManager_Free(&memoryManager);
-	}
-	else
+	flowSession.resolved = false;
+	if (flowSession.memoryManager)
 	{
-		LOG(LOG_ERR, "Failed to create memory manager");
+		FlowMemoryManager_Free(&flowSession.memoryManager);
 	}
-	return false;
 }
 
 /**
- * @brief Get ID of the device
- * @param *deviceId pointer to deviceId
- * @return true if deviceId is retrieved successfully, else false.
+ * @brief Look up the logged in device once, and cache its user and device IDs together with the
+ *        memory manager used by later sends.
+ * @return true if IDs are resolved, else false.
  */
-static bool GetDeviceId(char *deviceId)
+static bool ResolveSessionIds(void)
 {
-	FlowMemoryManager memoryManager = FlowMemoryManager_New();
+	ForgetSessionIds();
 
-	if (memoryManager)
+	flowSession.memoryManager = FlowMemoryManager_New();
+	if (flowSession.memoryManager)
 	{
-		FlowDevice device = FlowClient_GetLoggedInDevice(memoryManager);
+		FlowDevice device = FlowClient_GetLoggedInDevice(flowSession.memoryManager);
 		if (device)
 		{
 			FlowID temp;
 
+			temp = FlowUser_GetUserID(FlowDevice_RetrieveOwner(device));
+			strncpy(flowSession.userId, temp, MAX_SIZE - 1);
+			flowSession.userId[MAX_SIZE - 1] = '\0';
+
 			temp = FlowDevice_GetDeviceID(device);
-			strcpy(deviceId, temp);
-			FlowMemoryManager_Free(&memoryManager);
+			strncpy(flowSession.deviceId, temp, MAX_SIZE - 1);
+			flowSession.deviceId[MAX_SIZE - 1] = '\0';
+
+			flowSession.resolved = true;
 			return true;
 		}
 		else
 		{
 			LOG(LOG_ERR, "Failed to get logged in device");
 		}
-		FlowMemoryManager_Free(&memoryManager);
 	}
 	else
 	{
@@ -272,6 +258,21 @@ static bool GetDeviceId(char *deviceId)
 	return false;
 }
 
+/**
+ * @brief Make sure the logged in device's IDs are cached, counting the lookup saved when they
+ *        already are.
+ * @return true if IDs are available, else false.
+ */
+static bool UseSessionIds(void)
+{
+	if (flowSession.resolved)
+	{
+		__atomic_add_fetch(&flowSession.lookupsAvoided, 1, __ATOMIC_RELAXED);
+		return true;
+	}
+	return ResolveSessionIds();
+}
+
 /**
  * @brief Send a flow message to user.
  * @param *message pointer to a message for flow user.
@@ -279,33 +280,21 @@ static bool GetDeviceId(char *deviceId)
  */
 bool SendMessage(char *message)
 {
-	char userId[MAX_SIZE];
-
-	GetUserId(userId);
-
-	FlowMemoryManager memoryManager = FlowMemoryManager_New();
-
-	if (memoryManager)
+	if (UseSessionIds())
 	{
-		if (FlowMessaging_SendMessageToUser((FlowID)userId,
+		if (FlowMessaging_SendMessageToUser((FlowID)flowSession.userId,
 												"text/plain",
 												message,
 												strlen(message),
 												MESSAGE_EXPIRY_TIMEOUT))
 		{
 			LOG(LOG_INFO, "Message sent to user = %s",message);
-			FlowMemoryManager_Free(&memoryManager);
 			return true;
 		}
 		else
 		{
 			LOG(LOG_ERR, "Failed to send message to user");
 		}
-		FlowMemoryManager_Free(&memoryManager);
-	}
-	else
-	{
-		LOG(LOG_ERR, "Failed to create memory manager");
 	}
 	return false;
 }
@@ -317,46 +306,47 @@ bool SendMessage(char *message)
  */
 bool PublishStatus(char *message)
 {
-	char deviceId[MAX_SIZE];
-
-	GetDeviceId(deviceId);
-
-	FlowMemoryManager memoryManager = FlowMemoryManager_New();
-
-	if (memoryManager)
+	if (UseSessionIds())
 	{
 		if (FlowMessaging_PublishToDeviceTopic("DeviceStatus",
-												(FlowID)deviceId,
+												(FlowID)flowSession.deviceId,
 												"text/plain",
 												message,
 												strlen(message),
 												MESSAGE_EXPIRY_TIMEOUT))
 		{
 			LOG(LOG_INFO, "Status published = %s",message);
-			FlowMemoryManager_Free(&memoryManager);
 			return true;
 		}
 		else
 		{
 			LOG(LOG_ERR, "Failed to publish status");
 		}
-		FlowMemoryManager_Free(&memoryManager);
-	}
-	else
-	{
-		LOG(LOG_ERR, "Failed to create memory manager");
 	}
 	return false;
 }
 
 /**
- * @brief Initialize libflow and register as a device.
+ * @brief Number of logged in device lookups saved by caching the user and device IDs.
+ * @return lookups avoided since start.
+ */
+unsigned long GetFlowLookupsAvoided(void)
+{
+	return __atomic_load_n(&flowSession.lookupsAvoided, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Initialize libflow and register as a device. User and device IDs of the logged in
+ *        device are resolved here once, and reused by every send until the next login.
  * @return true if device registration is successful else false.
  */
 bool InitializeAndRegisterFlowDevice(void)
 {
 	RegistrationData regData;
 
+	/* A new login may be a different device or owner */
+	ForgetSessionIds();
+
 	if (GetConfigData(&regData))
 	{
 		if (InitialiseLibFlow(regData.url, regData.key, regData.secret, regData.rememberMeToken))
@@ -364,6 +354,10 @@ bool InitializeAndRegisterFlowDevice(void)
 			if (FlowClient_IsDeviceLoggedIn())
 			{
 				LOG(LOG_INFO, "Device registration successful");
+				if (!ResolveSessionIds())
+				{
+					LOG(LOG_WARN, "Device IDs not resolved, retrying on first send");
+				}
 				return true;
 			}
 			else
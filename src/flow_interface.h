@@ -36,8 +36,14 @@
 #ifndef FLOW_INTERFACE_H
 #define FLOW_INTERFACE_H
 
+#ifndef FLOW_CONFIG_FILE
+/** Configuration file to get registration data stored by provisioning app. */
+#define FLOW_CONFIG_FILE "/etc/lwm2m/flow_access.cfg"
+#endif
+
 /**
- * @brief Initialize libflow and register as a device.
+ * @brief Initialize libflow and register as a device. User and device IDs of the logged in
+ *        device are resolved here once, and reused by every send until the next login.
  * @return true if device registration is successful else false.
  */
 bool InitializeAndRegisterFlowDevice(void);
@@ -56,4 +62,10 @@ bool SendMessage(char *message);
  */
 bool PublishStatus(char *message);
 
+/**
+ * @brief Number of logged in device lookups saved by caching the user and device IDs.
+ * @return lookups avoided since start.
+ */
+unsigned long GetFlowLookupsAvoided(void);
+
 #endif	/* FLOW_INTERFACE_H*/
@@ -0,0 +1,264 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file gpio.c
+ * @brief In-process GPIO output driver. The line is exported and configured once when opened,
+ *        and its value handle is kept open so that each update costs a single write or ioctl.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/gpio.h>
+
+#include "gpio.h"
+#include "log.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define GPIO_CONSUMER_LABEL		"button_gateway"
+#define DIRECTION_OUT_STR		"out"
+#define DIRECTION_SIZE			(8)
+#define PIN_STR_SIZE			(16)
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Write a string to a sysfs attribute file.
+ * @param *path attribute path.
+ * @param *value string to write.
+ * @return true if the whole string was written, else false.
+ */
+static bool WriteAttribute(const char *path, const char *value)
+{
+	int fd;
+	ssize_t length = strlen(value);
+	bool success = false;
+
+	fd = open(path, O_WRONLY);
+	if (fd >= 0)
+	{
+		success = (write(fd, value, length) == length);
+		close(fd);
+	}
+	return success;
+}
+
+/**
+ * @brief Export the pin if needed, make it an output and open its value file.
+ * @param *gpio line to open.
+ * @param *config line configuration.
+ * @return true if value file is open, else false.
+ */
+static bool OpenSysfs(Gpio *gpio, const GpioConfig *config)
+{
+	char path[GPIO_PATH_SIZE];
+	char pinStr[PIN_STR_SIZE];
+	char direction[DIRECTION_SIZE] = {0};
+	const char *root = config->sysfsRoot ? config->sysfsRoot : GPIO_SYSFS_ROOT;
+	struct stat info;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/gpio%u", root, config->pin);
+	if (stat(path, &info) != 0)
+	{
+		snprintf(path, sizeof(path), "%s/export", root);
+		snprintf(pinStr, sizeof(pinStr), "%u", config->pin);
+		if (!WriteAttribute(path, pinStr))
+		{
+			LOG(LOG_ERR, "Failed to export gpio %u: %s", config->pin, strerror(errno));
+			return false;
+		}
+	}
+
+	snprintf(path, sizeof(path), "%s/gpio%u/direction", root, config->pin);
+	fd = open(path, O_RDONLY);
+	if (fd >= 0)
+	{
+		if (read(fd, direction, sizeof(direction) - 1) < 0)
+		{
+			direction[0] = '\0';
+		}
+		close(fd);
+	}
+
+	if (strncmp(direction, DIRECTION_OUT_STR, strlen(DIRECTION_OUT_STR)) != 0)
+	{
+		if (!WriteAttribute(path, DIRECTION_OUT_STR))
+		{
+			LOG(LOG_ERR, "Failed to set gpio %u direction: %s", config->pin, strerror(errno));
+			return false;
+		}
+	}
+
+	snprintf(path, sizeof(path), "%s/gpio%u/value", root, config->pin);
+	gpio->fd = open(path, O_WRONLY | O_CLOEXEC);
+	if (gpio->fd < 0)
+	{
+		LOG(LOG_ERR, "Failed to open %s: %s", path, strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Request the line as an output from the gpiochip character device.
+ * @param *gpio line to open.
+ * @param *config line configuration.
+ * @return true if line handle was granted, else false.
+ */
+static bool OpenCharDev(Gpio *gpio, const GpioConfig *config)
+{
+	struct gpiohandle_request request;
+	int chipFd;
+
+	if (config->chipPath == NULL)
+	{
+		LOG(LOG_ERR, "No gpiochip device given for gpio %u", config->pin);
+		return false;
+	}
+
+	chipFd = open(config->chipPath, O_RDONLY | O_CLOEXEC);
+	if (chipFd < 0)
+	{
+		LOG(LOG_ERR, "Failed to open %s: %s", config->chipPath, strerror(errno));
+		return false;
+	}
+
+	memset(&request, 0, sizeof(request));
+	request.lineoffsets[0] = config->pin;
+	request.lines = 1;
+	request.flags = GPIOHANDLE_REQUEST_OUTPUT;
+	strncpy(request.consumer_label, GPIO_CONSUMER_LABEL, sizeof(request.consumer_label) - 1);
+
+	if (ioctl(chipFd, GPIO_GET_LINEHANDLE_IOCTL, &request) < 0)
+	{
+		LOG(LOG_ERR, "Failed to request line %u on %s: %s",
+				config->pin, config->chipPath, strerror(errno));
+		close(chipFd);
+		return false;
+	}
+	close(chipFd);
+
+	gpio->fd = request.fd;
+	return true;
+}
+
+/**
+ * @brief Export and configure the line as an output once, and keep its value handle open.
+ * @param *gpio line to open.
+ * @param *config line configuration.
+ * @return true if the line is ready for writing, else false.
+ */
+bool Gpio_Open(Gpio *gpio, const GpioConfig *config)
+{
+	bool success;
+
+	gpio->backend = config->backend;
+	gpio->pin = config->pin;
+	gpio->fd = -1;
+	gpio->value = -1;
+
+	if (config->backend == GpioBackend_CharDev)
+	{
+		success = OpenCharDev(gpio, config);
+	}
+	else
+	{
+		success = OpenSysfs(gpio, config);
+	}
+	return success;
+}
+
+/**
+ * @brief Drive the line high or low. Writes are skipped if the line already holds the value.
+ * @param *gpio opened line.
+ * @param value level to drive.
+ * @return true if the line holds the requested value, else false.
+ */
+bool Gpio_Set(Gpio *gpio, bool value)
+{
+	bool success = false;
+
+	if (gpio->fd < 0)
+	{
+		return false;
+	}
+
+	if (gpio->value == (int)value)
+	{
+		return true;
+	}
+
+	if (gpio->backend == GpioBackend_CharDev)
+	{
+		struct gpiohandle_data data;
+
+		memset(&data, 0, sizeof(data));
+		data.values[0] = value;
+		success = (ioctl(gpio->fd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data) == 0);
+	}
+	else
+	{
+		success = (pwrite(gpio->fd, value ? "1" : "0", 1, 0) == 1);
+	}
+
+	gpio->value = success ? (int)value : -1;
+	return success;
+}
+
+/**
+ * @brief Release the line handle. The pin is left exported for other users.
+ * @param *gpio line to close.
+ */
+void Gpio_Close(Gpio *gpio)
+{
+	if (gpio->fd >= 0)
+	{
+		close(gpio->fd);
+		gpio->fd = -1;
+	}
+	gpio->value = -1;
+}
@@ -0,0 +1,104 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file gpio.h
+ * @brief Header file for driving a GPIO output line in-process, either through the sysfs
+ *        interface or through the gpiochip character device.
+ */
+
+#ifndef GPIO_H
+#define GPIO_H
+
+#include <stdbool.h>
+
+//! @cond Doxygen_Suppress
+#define GPIO_SYSFS_ROOT		"/sys/class/gpio"
+#define GPIO_PATH_SIZE		(128)
+//! @endcond
+
+/**
+ * Kernel interface used to drive the line.
+ */
+typedef enum
+{
+	GpioBackend_Sysfs, /**< /sys/class/gpio export, direction and value files */
+	GpioBackend_CharDev /**< /dev/gpiochipN line handle */
+}GpioBackend;
+
+/**
+ * A structure to contain GPIO line configuration.
+ */
+typedef struct
+{
+	/*@{*/
+	GpioBackend backend; /**< kernel interface to use */
+	unsigned int pin; /**< sysfs GPIO number, or line offset on the chip for the char device */
+	const char *sysfsRoot; /**< sysfs GPIO class directory, may point to a fake tree off-board */
+	const char *chipPath; /**< gpiochip device node, used by the char device backend */
+	/*@}*/
+}GpioConfig;
+
+/**
+ * A structure to contain an opened GPIO output line.
+ */
+typedef struct
+{
+	/*@{*/
+	GpioBackend backend; /**< kernel interface in use */
+	unsigned int pin; /**< configured pin */
+	int fd; /**< sysfs value file or char device line handle, -1 when closed */
+	int value; /**< last value written, -1 if unknown */
+	/*@}*/
+}Gpio;
+
+/**
+ * @brief Export and configure the line as an output once, and keep its value handle open.
+ * @param *gpio line to open.
+ * @param *config line configuration.
+ * @return true if the line is ready for writing, else false.
+ */
+bool Gpio_Open(Gpio *gpio, const GpioConfig *config);
+
+/**
+ * @brief Drive the line high or low. Writes are skipped if the line already holds the value.
+ * @param *gpio opened line.
+ * @param value level to drive.
+ * @return true if the line holds the requested value, else false.
+ */
+bool Gpio_Set(Gpio *gpio, bool value);
+
+/**
+ * @brief Release the line handle. The pin is left exported for other users.
+ * @param *gpio line to close.
+ */
+void Gpio_Close(Gpio *gpio);
+
+#endif	/* GPIO_H */
@@ -0,0 +1,265 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file hash_table.c
+ * @brief Chained hash table using FNV-1a over the endpoint name and path.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash_table.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define FNV_OFFSET_BASIS	(2166136261u)
+#define FNV_PRIME			(16777619u)
+#define MIN_BUCKETS			(16)
+#define MAX_LOAD_FACTOR		(2)
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Hash both key parts. The separator keeps ("ab", "c") and ("a", "bc") apart.
+ * @param *name first key part.
+ * @param *path second key part, or NULL.
+ * @return hash value.
+ */
+static unsigned int Hash(const char *name, const char *path)
+{
+	unsigned int hash = FNV_OFFSET_BASIS;
+
+	while (*name)
+	{
+		hash = (hash ^ (unsigned char)*name++) * FNV_PRIME;
+	}
+
+	if (path != NULL)
+	{
+		hash = (hash ^ '\n') * FNV_PRIME;
+		while (*path)
+		{
+			hash = (hash ^ (unsigned char)*path++) * FNV_PRIME;
+		}
+	}
+	return hash;
+}
+
+/**
+ * @brief Find the link pointing at the entry for a key.
+ * @param *table table to search.
+ * @param *name first key part.
+ * @param *path second key part, or NULL.
+ * @param hash hash of the key.
+ * @return link to the entry, or to the bucket's terminating NULL if not found.
+ */
+static HashEntry **FindLink(const HashTable *table, const char *name, const char *path,
+		unsigned int hash)
+{
+	HashEntry **link = &table->buckets[hash & (table->numBuckets - 1)];
+
+	while (*link != NULL)
+	{
+		HashEntry *entry = *link;
+
+		if (entry->hash == hash && strcmp(entry->name, name) == 0 &&
+			((path == NULL && entry->path == NULL) ||
+			 (path != NULL && entry->path != NULL && strcmp(entry->path, path) == 0)))
+		{
+			break;
+		}
+		link = &entry->next;
+	}
+	return link;
+}
+
+/**
+ * @brief Double the number of buckets and redistribute entries.
+ * @param *table table to grow.
+ * @return true on success, else false.
+ */
+static bool Grow(HashTable *table)
+{
+	unsigned int i, numBuckets = table->numBuckets * 2;
+	HashEntry **buckets = calloc(numBuckets, sizeof(*buckets));
+
+	if (buckets == NULL)
+	{
+		return false;
+	}
+
+	for (i = 0; i < table->numBuckets; i++)
+	{
+		HashEntry *entry = table->buckets[i];
+
+		while (entry != NULL)
+		{
+			HashEntry *next = entry->next;
+
+			entry->next = buckets[entry->hash & (numBuckets - 1)];
+			buckets[entry->hash & (numBuckets - 1)] = entry;
+			entry = next;
+		}
+	}
+
+	free(table->buckets);
+	table->buckets = buckets;
+	table->numBuckets = numBuckets;
+	return true;
+}
+
+/**
+ * @brief Allocate an empty table.
+ * @param *table table to initialize.
+ * @param sizeHint expected number of entries.
+ * @return true on success, else false.
+ */
+bool HashTable_Init(HashTable *table, unsigned int sizeHint)
+{
+	table->numBuckets = MIN_BUCKETS;
+	while (table->numBuckets < sizeHint)
+	{
+		table->numBuckets *= 2;
+	}
+	table->count = 0;
+	table->buckets = calloc(table->numBuckets, sizeof(*table->buckets));
+	return table->buckets != NULL;
+}
+
+/**
+ * @brief Free all entries and buckets. Stored values are not freed.
+ * @param *table table to destroy.
+ */
+void HashTable_Destroy(HashTable *table)
+{
+	unsigned int i;
+
+	if (table->buckets == NULL)
+	{
+		return;
+	}
+
+	for (i = 0; i < table->numBuckets; i++)
+	{
+		HashEntry *entry = table->buckets[i];
+
+		while (entry != NULL)
+		{
+			HashEntry *next = entry->next;
+
+			free(entry->name);
+			free(entry->path);
+			free(entry);
+			entry = next;
+		}
+	}
+	free(table->buckets);
+	table->buckets = NULL;
+	table->count = 0;
+}
+
+/**
+ * @brief Look up a value.
+ * @param *table table to search.
+ * @param *name first key part.
+ * @param *path second key part, or NULL.
+ * @return stored value, or NULL if not found.
+ */
+void *HashTable_Get(const HashTable *table, const char *name, const char *path)
+{
+	HashEntry *entry;
+
+	if (table->buckets == NULL || name == NULL)
+	{
+		return NULL;
+	}
+
+	entry = *FindLink(table, name, path, Hash(name, path));
+	return entry ? entry->value : NULL;
+}
+
+/**
+ * @brief Insert or replace a value. The table grows as needed.
+ * @param *table table to modify.
+ * @param *name first key part, copied.
+ * @param *path second key part, copied, or NULL.
+ * @param *value pointer to store.
+ * @return true on success, else false.
+ */
+bool HashTable_Put(HashTable *table, const char *name, const char *path, void *value)
+{
+	unsigned int hash = Hash(name, path);
+	HashEntry **link = FindLink(table, name, path, hash);
+	HashEntry *entry;
+
+	if (*link != NULL)
+	{
+		(*link)->value = value;
+		return true;
+	}
+
+	if (table->count >= table->numBuckets * MAX_LOAD_FACTOR && Grow(table))
+	{
+		link = FindLink(table, name, path, hash);
+	}
+
+	entry = calloc(1, sizeof(*entry));
+	if (entry == NULL)
+	{
+		return false;
+	}
+
+	entry->name = strdup(name);
+	entry->path = path ? strdup(path) : NULL;
+	if (entry->name == NULL || (path != NULL && entry->path == NULL))
+	{
+		free(entry->name);
+		free(entry->path);
+		free(entry);
+		return false;
+	}
+
+	entry->hash = hash;
+	entry->value = value;
+	*link = entry;
+	table->count++;
+	return true;
+}
@@ -0,0 +1,100 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file hash_table.h
+ * @brief Header file for a chained hash table keyed by an endpoint name and an optional path.
+ */
+
+#ifndef HASH_TABLE_H
+#define HASH_TABLE_H
+
+#include <stdbool.h>
+
+/**
+ * A structure to contain one key and its value.
+ */
+typedef struct HashEntry
+{
+	/*@{*/
+	char *name; /**< first key part, e.g. client ID */
+	char *path; /**< second key part, e.g. resource path, NULL if unused */
+	unsigned int hash; /**< cached hash of both parts */
+	void *value; /**< stored pointer, not owned by the table */
+	struct HashEntry *next; /**< next entry in the same bucket */
+	/*@}*/
+}HashEntry;
+
+/**
+ * A structure to contain the table.
+ */
+typedef struct
+{
+	/*@{*/
+	HashEntry **buckets; /**< bucket heads */
+	unsigned int numBuckets; /**< always a power of two */
+	unsigned int count; /**< number of entries */
+	/*@}*/
+}HashTable;
+
+/**
+ * @brief Allocate an empty table.
+ * @param *table table to initialize.
+ * @param sizeHint expected number of entries.
+ * @return true on success, else false.
+ */
+bool HashTable_Init(HashTable *table, unsigned int sizeHint);
+
+/**
+ * @brief Free all entries and buckets. Stored values are not freed.
+ * @param *table table to destroy.
+ */
+void HashTable_Destroy(HashTable *table);
+
+/**
+ * @brief Look up a value.
+ * @param *table table to search.
+ * @param *name first key part.
+ * @param *path second key part, or NULL.
+ * @return stored value, or NULL if not found.
+ */
+void *HashTable_Get(const HashTable *table, const char *name, const char *path);
+
+/**
+ * @brief Insert or replace a value. The table grows as needed.
+ * @param *table table to modify.
+ * @param *name first key part, copied.
+ * @param *path second key part, copied, or NULL.
+ * @param *value pointer to store.
+ * @return true on success, else false.
+ */
+bool HashTable_Put(HashTable *table, const char *name, const char *path, void *value);
+
+#endif	/* HASH_TABLE_H */
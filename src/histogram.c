@@ -0,0 +1,218 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file histogram.c
+ * @brief Log-bucketed latency histograms.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <string.h>
+
+#include "histogram.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define US_PER_SECOND	(1000000)
+#define NS_PER_US		(1000)
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Get the bucket holding a value. Values below HISTOGRAM_SUB_BUCKETS have a bucket each,
+ *        above that every power of two is split in HISTOGRAM_HALF_BUCKETS linear buckets.
+ * @param value value in us.
+ * @return bucket index.
+ */
+static unsigned int GetBucket(uint32_t value)
+{
+	unsigned int shift;
+
+	if (value < HISTOGRAM_SUB_BUCKETS)
+	{
+		return value;
+	}
+
+	/* Shift so the value lands in [HISTOGRAM_HALF_BUCKETS, HISTOGRAM_SUB_BUCKETS) */
+	shift = (31 - __builtin_clz(value)) - (HISTOGRAM_SUB_BUCKET_BITS - 1);
+	return HISTOGRAM_SUB_BUCKETS + (shift - 1) * HISTOGRAM_HALF_BUCKETS +
+			((value >> shift) - HISTOGRAM_HALF_BUCKETS);
+}
+
+/**
+ * @brief Get the lowest value a bucket holds.
+ * @param index bucket index.
+ * @return lowest value in us.
+ */
+uint32_t Histogram_GetBucketStart(unsigned int index)
+{
+	unsigned int shift;
+
+	if (index < HISTOGRAM_SUB_BUCKETS)
+	{
+		return index;
+	}
+
+	shift = (index - HISTOGRAM_SUB_BUCKETS) / HISTOGRAM_HALF_BUCKETS + 1;
+	return (uint32_t)(HISTOGRAM_HALF_BUCKETS +
+			(index - HISTOGRAM_SUB_BUCKETS) % HISTOGRAM_HALF_BUCKETS) << shift;
+}
+
+/**
+ * @brief Get the highest value a bucket holds.
+ * @param index bucket index.
+ * @return highest value in us.
+ */
+static uint32_t GetBucketEnd(unsigned int index)
+{
+	if (index + 1 >= HISTOGRAM_BUCKETS)
+	{
+		return UINT32_MAX;
+	}
+	return Histogram_GetBucketStart(index + 1) - 1;
+}
+
+/**
+ * @brief Reset histogram.
+ * @param *histogram histogram to initialize.
+ * @param *name histogram name for reports.
+ */
+void Histogram_Init(Histogram *histogram, const char *name)
+{
+	memset(histogram, 0, sizeof(*histogram));
+	histogram->name = name;
+}
+
+/**
+ * @brief Record a value. Safe to call from any thread.
+ * @param *histogram histogram to record to.
+ * @param valueUs value in microseconds.
+ */
+void Histogram_Record(Histogram *histogram, uint32_t valueUs)
+{
+	uint32_t max = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+
+	__atomic_add_fetch(&histogram->counts[GetBucket(valueUs)], 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&histogram->total, 1, __ATOMIC_RELAXED);
+	while (valueUs > max && !__atomic_compare_exchange_n(&histogram->max, &max, valueUs, true,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+	{
+		/* max was reloaded, retry while still larger */
+	}
+}
+
+/**
+ * @brief Record the time elapsed since a monotonic time. Safe to call from any thread.
+ * @param *histogram histogram to record to.
+ * @param *since start time, nothing is recorded if it is zero.
+ */
+void Histogram_RecordSince(Histogram *histogram, const struct timespec *since)
+{
+	struct timespec now;
+	int64_t elapsed;
+
+	if (since->tv_sec == 0 && since->tv_nsec == 0)
+	{
+		return;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = (int64_t)(now.tv_sec - since->tv_sec) * US_PER_SECOND +
+			(now.tv_nsec - since->tv_nsec) / NS_PER_US;
+	if (elapsed < 0)
+	{
+		elapsed = 0;
+	}
+	Histogram_Record(histogram, (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed);
+}
+
+/**
+ * @brief Get the value below which a fraction of the recorded values fall.
+ * @param *histogram histogram to inspect.
+ * @param fraction fraction of values, e.g. 0.99.
+ * @return upper bound of the bucket holding that value, in us, 0 if nothing was recorded.
+ */
+uint32_t Histogram_GetPercentile(const Histogram *histogram, double fraction)
+{
+	unsigned long total = 0;
+	unsigned long rank, seen = 0;
+	uint32_t max = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+	unsigned int i;
+
+	/* Counts may move while recording goes on, sum what is there now */
+	for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		total += __atomic_load_n(&histogram->counts[i], __ATOMIC_RELAXED);
+	}
+	if (total == 0)
+	{
+		return 0;
+	}
+
+	rank = (unsigned long)(fraction * total + 0.5);
+	if (rank == 0)
+	{
+		rank = 1;
+	}
+
+	for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		seen += __atomic_load_n(&histogram->counts[i], __ATOMIC_RELAXED);
+		if (seen >= rank)
+		{
+			/* The true value is no larger than the largest value recorded */
+			return (GetBucketEnd(i) < max) ? GetBucketEnd(i) : max;
+		}
+	}
+	return max;
+}
+
+/**
+ * @brief Get the usual percentiles of a histogram.
+ * @param *histogram histogram to inspect.
+ * @param *summary filled with percentiles.
+ */
+void Histogram_GetSummary(const Histogram *histogram, HistogramSummary *summary)
+{
+	summary->count = __atomic_load_n(&histogram->total, __ATOMIC_RELAXED);
+	summary->p50 = Histogram_GetPercentile(histogram, 0.5);
+	summary->p99 = Histogram_GetPercentile(histogram, 0.99);
+	summary->p999 = Histogram_GetPercentile(histogram, 0.999);
+	summary->max = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+}
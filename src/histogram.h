@@ -0,0 +1,123 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file histogram.h
+ * @brief Header file for log-bucketed latency histograms. Buckets are linear within each power
+ *        of two, so every recorded value is kept to within about 6 percent, and recording is a
+ *        single atomic increment, cheap enough to stay on in production.
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+//! @cond Doxygen_Suppress
+#define HISTOGRAM_SUB_BUCKET_BITS	(5)
+#define HISTOGRAM_SUB_BUCKETS		(1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_HALF_BUCKETS		(HISTOGRAM_SUB_BUCKETS / 2)
+#define HISTOGRAM_BUCKETS			\
+		(HISTOGRAM_SUB_BUCKETS + (32 - HISTOGRAM_SUB_BUCKET_BITS) * HISTOGRAM_HALF_BUCKETS)
+//! @endcond
+
+/**
+ * A structure to contain a histogram of latencies in microseconds.
+ */
+typedef struct
+{
+	/*@{*/
+	const char *name; /**< histogram name for reports */
+	unsigned long counts[HISTOGRAM_BUCKETS]; /**< values recorded in each bucket */
+	unsigned long total; /**< values recorded */
+	uint32_t max; /**< largest value recorded */
+	/*@}*/
+}Histogram;
+
+/**
+ * A structure to contain the percentiles of a histogram.
+ */
+typedef struct
+{
+	/*@{*/
+	unsigned long count; /**< values recorded */
+	uint32_t p50; /**< median, in us */
+	uint32_t p99; /**< 99th percentile, in us */
+	uint32_t p999; /**< 99.9th percentile, in us */
+	uint32_t max; /**< largest value, in us */
+	/*@}*/
+}HistogramSummary;
+
+/**
+ * @brief Reset histogram.
+ * @param *histogram histogram to initialize.
+ * @param *name histogram name for reports.
+ */
+void Histogram_Init(Histogram *histogram, const char *name);
+
+/**
+ * @brief Record a value. Safe to call from any thread.
+ * @param *histogram histogram to record to.
+ * @param valueUs value in microseconds.
+ */
+void Histogram_Record(Histogram *histogram, uint32_t valueUs);
+
+/**
+ * @brief Record the time elapsed since a monotonic time. Safe to call from any thread.
+ * @param *histogram histogram to record to.
+ * @param *since start time, nothing is recorded if it is zero.
+ */
+void Histogram_RecordSince(Histogram *histogram, const struct timespec *since);
+
+/**
+ * @brief Get the value below which a fraction of the recorded values fall.
+ * @param *histogram histogram to inspect.
+ * @param fraction fraction of values, e.g. 0.99.
+ * @return upper bound of the bucket holding that value, in us, 0 if nothing was recorded.
+ */
+uint32_t Histogram_GetPercentile(const Histogram *histogram, double fraction);
+
+/**
+ * @brief Get the usual percentiles of a histogram.
+ * @param *histogram histogram to inspect.
+ * @param *summary filled with percentiles.
+ */
+void Histogram_GetSummary(const Histogram *histogram, HistogramSummary *summary);
+
+/**
+ * @brief Get the lowest value a bucket holds.
+ * @param index bucket index.
+ * @return lowest value in us.
+ */
+uint32_t Histogram_GetBucketStart(unsigned int index);
+
+#endif	/* HISTOGRAM_H */
@@ -0,0 +1,887 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file log.c
+ * @brief Asynchronous logging backend. Each logging thread owns a single producer ring, into
+ *        which LOG copies the format, its arguments and string contents without taking a lock.
+ *        The log thread merges the rings in logging order and writes the messages, either
+ *        formatted as text or in the binary log format, which leaves formatting to
+ *        button_gateway_logdecode. Writes are flushed in batches and the log file is rotated by
+ *        size and age.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <libconfig.h>
+
+#include "log.h"
+#include "log_format.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define LOG_RING_SIZE		(128)
+#define LOG_WAKEUP_DEPTH	(LOG_RING_SIZE / 2)
+#define LOG_MAX_RINGS		(16)
+#define LOG_MESSAGE_SIZE	(1024)
+#define LOG_PATH_SIZE		(256)
+#define NS_PER_SECOND		(1000000000ULL)
+#define NS_PER_MS			(1000000)
+//! @endcond
+
+/***************************************************************************************************
+ * Typedef
+ **************************************************************************************************/
+
+/**
+ * A structure to contain one queued log message.
+ */
+typedef struct
+{
+	/*@{*/
+	uint64_t sequence; /**< logging order over all threads */
+	uint64_t monotonicNs; /**< monotonic time the message was logged */
+	time_t time; /**< wall clock time the message was logged */
+	LogSite *site; /**< call site */
+	const char *file; /**< source file */
+	const char *format; /**< printf format */
+	int line; /**< source line */
+	int level; /**< message level */
+	LogArguments arguments; /**< packed arguments */
+	/*@}*/
+}LogRecord;
+
+/**
+ * A structure to contain the ring of one logging thread.
+ */
+typedef struct
+{
+	/*@{*/
+	LogRecord records[LOG_RING_SIZE]; /**< ring storage */
+	unsigned int head; /**< next record to format, written by the log thread */
+	unsigned int tail; /**< next record to fill, written by the owning thread */
+	unsigned long drops; /**< messages dropped because the ring was full */
+	/*@}*/
+}LogRing;
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+/** Rings of every thread that logged. */
+static LogRing *rings[LOG_MAX_RINGS];
+/** Number of rings in use. */
+static unsigned int numRings;
+/** Protects ring registration, the log file and everything written to debugStream. */
+static pthread_mutex_t logLock = PTHREAD_MUTEX_INITIALIZER;
+/** Ring of the calling thread, NULL until it first logs. */
+static __thread LogRing *threadRing;
+/** Next message sequence number. */
+static uint64_t nextSequence;
+/** Whether the log thread is running. */
+static bool logRunning;
+/** Log thread. */
+static pthread_t logThread;
+/** Wakes the log thread when it is idle. */
+static int logWakeup = -1;
+/** Set by the log thread before it waits, producers wake it only then. */
+static int logSleeping;
+/** Drops already reported in the log. */
+static unsigned long reportedDrops;
+/** Whether debugStream is written in the binary log format. */
+static bool logBinary;
+/** Binary log file generation, call sites define their format again in each new file. */
+static unsigned int logGeneration;
+/** Last format ID handed out to a call site. */
+static unsigned int lastSiteId;
+/** Log file configuration. */
+static LogConfig logConfig = {NULL, false, 0, 0, 0, LOG_FLUSH_INTERVAL, LOG_FLUSH_SIZE};
+/** Whether debugStream is the configured log file. */
+static bool logFileOpen;
+/** Bytes in the log file. */
+static unsigned long logSize;
+/** Time the log file was started. */
+static time_t logStarted;
+/** Bytes written since the last flush. */
+static size_t logUnflushed;
+/** Monotonic time the oldest unflushed message was logged. */
+static uint64_t logUnflushedSinceNs;
+/** Set when an error was written, so it reaches the file right away. */
+static bool logFlushNow;
+/** Stream buffer of the log file, sized so a batch reaches the file in one write. */
+static char *logBuffer;
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Get the current time of a clock in nanoseconds.
+ * @param clock clock to read.
+ * @return time in ns.
+ */
+static uint64_t GetTimeNs(clockid_t clock)
+{
+	struct timespec now;
+
+	clock_gettime(clock, &now);
+	return (uint64_t)now.tv_sec * NS_PER_SECOND + now.tv_nsec;
+}
+
+/**
+ * @brief Fill a log configuration with defaults.
+ * @param *config configuration to fill.
+ */
+static void SetDefaultConfig(LogConfig *config)
+{
+	memset(config, 0, sizeof(*config));
+	config->maxSize = LOG_MAX_SIZE;
+	config->maxAge = LOG_MAX_AGE;
+	config->generations = LOG_GENERATIONS;
+	config->flushInterval = LOG_FLUSH_INTERVAL;
+	config->flushSize = LOG_FLUSH_SIZE;
+}
+
+/**
+ * @brief Read the optional log group of the configuration file, other fields get defaults.
+ * @param *config filled with configuration, file and binary are left to the caller.
+ * @param *file configuration file, may not exist.
+ * @return true if configuration is usable, else false and config holds the defaults.
+ */
+bool Log_LoadConfig(LogConfig *config, const char *file)
+{
+	config_t cfg;
+	config_setting_t *group;
+	int value;
+	bool success = true;
+
+	SetDefaultConfig(config);
+	if (access(file, F_OK) != 0)
+	{
+		return true;
+	}
+
+	config_init(&cfg);
+	if (!config_read_file(&cfg, file))
+	{
+		LOG(LOG_ERR, "Failed to parse %s:%d: %s",
+				file, config_error_line(&cfg), config_error_text(&cfg));
+		success = false;
+	}
+	else if ((group = config_lookup(&cfg, "log")) != NULL)
+	{
+		if (config_setting_lookup_int(group, "max_size", &value))
+		{
+			if (value < 0)
+			{
+				LOG(LOG_ERR, "Log max_size can't be negative");
+				success = false;
+			}
+			config->maxSize = value;
+		}
+
+		if (config_setting_lookup_int(group, "max_age", &value))
+		{
+			if (value < 0)
+			{
+				LOG(LOG_ERR, "Log max_age can't be negative");
+				success = false;
+			}
+			config->maxAge = value;
+		}
+
+		if (config_setting_lookup_int(group, "generations", &value))
+		{
+			if (value < 0 || value > 99)
+			{
+				LOG(LOG_ERR, "Log generations must be 0 to 99");
+				success = false;
+			}
+			config->generations = value;
+		}
+
+		if (config_setting_lookup_int(group, "flush_interval", &value))
+		{
+			if (value <= 0)
+			{
+				LOG(LOG_ERR, "Log flush_interval must be positive");
+				success = false;
+			}
+			config->flushInterval = value;
+		}
+
+		if (config_setting_lookup_int(group, "flush_size", &value))
+		{
+			if (value <= 0)
+			{
+				LOG(LOG_ERR, "Log flush_size must be positive");
+				success = false;
+			}
+			config->flushSize = value;
+		}
+	}
+	config_destroy(&cfg);
+
+	if (!success)
+	{
+		/* Keep the gateway logging with defaults rather than not at all */
+		SetDefaultConfig(config);
+	}
+	return success;
+}
+
+/**
+ * @brief Account for bytes written to debugStream. Must be called with logLock held.
+ * @param bytes bytes written.
+ * @param loggedNs monotonic time the message was logged.
+ */
+static void Account(size_t bytes, uint64_t loggedNs)
+{
+	if (logUnflushed == 0)
+	{
+		logUnflushedSinceNs = loggedNs;
+	}
+	logUnflushed += bytes;
+	logSize += bytes;
+}
+
+/**
+ * @brief Write the header of a binary log file. Must be called with logLock held.
+ */
+static void WriteHeader(void)
+{
+	LogBinaryHeader header = {0};
+
+	header.magic = LOG_BINARY_MAGIC;
+	header.version = LOG_BINARY_VERSION;
+	header.wallNs = GetTimeNs(CLOCK_REALTIME);
+	header.monotonicNs = GetTimeNs(CLOCK_MONOTONIC);
+	header.debugLevel = debugLevel;
+	fwrite(&header, sizeof(header), 1, debugStream);
+	Account(sizeof(header), header.monotonicNs);
+}
+
+/**
+ * @brief Write the header of a binary log entry, its payload follows. Must be called with
+ *        logLock held.
+ * @param type entry type.
+ * @param level message level.
+ * @param truncated whether message arguments were truncated.
+ * @param id format ID.
+ * @param length payload length.
+ * @return bytes written, including the payload.
+ */
+static size_t WriteEntry(LogEntryType type, int level, bool truncated, unsigned int id,
+		size_t length)
+{
+	LogBinaryEntry entry = {0};
+
+	entry.type = type;
+	entry.level = level;
+	entry.truncated = truncated;
+	entry.id = id;
+	entry.length = length;
+	fwrite(&entry, sizeof(entry), 1, debugStream);
+	return sizeof(entry) + length;
+}
+
+/**
+ * @brief Write a record to debugStream. Must be called with logLock held.
+ * @param *record record to write.
+ */
+static void WriteRecord(const LogRecord *record)
+{
+	char message[LOG_MESSAGE_SIZE];
+	LogSite *site = record->site;
+	size_t written = 0;
+
+	if (record->level <= LOG_ERR)
+	{
+		logFlushNow = true;
+	}
+
+	if (!logBinary)
+	{
+		written = LogFormat_WriteMessage(debugStream, debugLevel == LOG_DBG, record->time,
+				record->file, record->line, message,
+				LogFormat_Print(record->format, &record->arguments, message, sizeof(message)));
+		Account(written, record->monotonicNs);
+		return;
+	}
+
+	if (site->id == 0)
+	{
+		site->id = ++lastSiteId;
+	}
+	if (site->generation != logGeneration)
+	{
+		/* Line, then file and format with their terminators */
+		uint32_t line = record->line;
+		size_t fileLength = strlen(record->file) + 1;
+		size_t formatLength = strlen(record->format) + 1;
+
+		written += WriteEntry(LogEntry_Format, record->level, false, site->id,
+				sizeof(line) + fileLength + formatLength);
+		fwrite(&line, sizeof(line), 1, debugStream);
+		fwrite(record->file, 1, fileLength, debugStream);
+		fwrite(record->format, 1, formatLength, debugStream);
+		site->generation = logGeneration;
+	}
+
+	written += WriteEntry(LogEntry_Message, record->level, record->arguments.truncated, site->id,
+			sizeof(record->monotonicNs) + record->arguments.length);
+	fwrite(&record->monotonicNs, sizeof(record->monotonicNs), 1, debugStream);
+	fwrite(record->arguments.data, 1, record->arguments.length, debugStream);
+	Account(written, record->monotonicNs);
+}
+
+/**
+ * @brief Report messages dropped since the last report. Must be called with logLock held.
+ * @param drops messages dropped so far.
+ */
+static void WriteDrops(unsigned long drops)
+{
+	uint64_t count = drops - reportedDrops;
+	int written;
+
+	if (logBinary)
+	{
+		Account(WriteEntry(LogEntry_Drops, LOG_WARN, false, 0, sizeof(count)),
+				GetTimeNs(CLOCK_MONOTONIC));
+		fwrite(&count, sizeof(count), 1, debugStream);
+	}
+	else
+	{
+		written = fprintf(debugStream, "\n%llu log messages dropped, log rings full\n",
+				(unsigned long long)count);
+		Account(written > 0 ? written : 0, GetTimeNs(CLOCK_MONOTONIC));
+	}
+	reportedDrops = drops;
+}
+
+/**
+ * @brief Flush debugStream. Must be called with logLock held.
+ */
+static void Flush(void)
+{
+	fflush(debugStream);
+	logUnflushed = 0;
+	logFlushNow = false;
+}
+
+/**
+ * @brief Flush debugStream if an error was written, enough bytes were written, or the oldest
+ *        unflushed message is flushInterval old. Must be called with logLock held.
+ * @return ms until a flush is due, -1 if nothing is waiting.
+ */
+static int FlushIfDue(void)
+{
+	uint64_t elapsedMs;
+
+	if (logUnflushed == 0)
+	{
+		return -1;
+	}
+
+	elapsedMs = (GetTimeNs(CLOCK_MONOTONIC) - logUnflushedSinceNs) / NS_PER_MS;
+	if (logFlushNow || logUnflushed >= logConfig.flushSize || elapsedMs >= logConfig.flushInterval)
+	{
+		Flush();
+		return -1;
+	}
+	return logConfig.flushInterval - elapsedMs;
+}
+
+/**
+ * @brief Open the configured log file as debugStream, falling back to stdout. Must be called with
+ *        logLock held.
+ * @param *mode fopen mode.
+ * @return true if log file is open, else false.
+ */
+static bool OpenFile(const char *mode)
+{
+	struct stat status;
+	FILE *file = fopen(logConfig.file, mode);
+
+	logUnflushed = 0;
+	logFlushNow = false;
+	if (file == NULL)
+	{
+		debugStream = stdout;
+		logFileOpen = false;
+		return false;
+	}
+
+	if (logBuffer != NULL)
+	{
+		setvbuf(file, logBuffer, _IOFBF, logConfig.flushSize);
+	}
+	debugStream = file;
+	logFileOpen = true;
+	logSize = (fstat(fileno(file), &status) == 0) ? status.st_size : 0;
+	logStarted = time(NULL);
+
+	if (logBinary)
+	{
+		if (logSize == 0)
+		{
+			WriteHeader();
+		}
+		logGeneration++;
+	}
+	return true;
+}
+
+/**
+ * @brief Close debugStream if it is the log file. Must be called with logLock held.
+ */
+static void CloseFile(void)
+{
+	if (logFileOpen)
+	{
+		fclose(debugStream);
+		debugStream = stdout;
+		logFileOpen = false;
+	}
+	logUnflushed = 0;
+}
+
+/**
+ * @brief Rename the log file to file.1, file.1 to file.2 and so on, dropping the oldest.
+ */
+static void ShiftGenerations(void)
+{
+	char from[LOG_PATH_SIZE];
+	char to[LOG_PATH_SIZE];
+	unsigned int i;
+
+	for (i = logConfig.generations; i > 0; i--)
+	{
+		if (i > 1)
+		{
+			snprintf(from, sizeof(from), "%s.%u", logConfig.file, i - 1);
+		}
+		else
+		{
+			snprintf(from, sizeof(from), "%s", logConfig.file);
+		}
+		snprintf(to, sizeof(to), "%s.%u", logConfig.file, i);
+
+		if (rename(from, to) != 0 && errno != ENOENT)
+		{
+			fprintf(stderr, "Failed to rotate %s: %s\n", from, strerror(errno));
+		}
+	}
+}
+
+/**
+ * @brief Rotate the log file once it is too large or too old. Must be called with logLock held.
+ * @param now current time.
+ */
+static void RotateIfDue(time_t now)
+{
+	if (!logFileOpen ||
+		!((logConfig.maxSize != 0 && logSize >= logConfig.maxSize) ||
+		(logConfig.maxAge != 0 && now - logStarted >= (time_t)logConfig.maxAge)))
+	{
+		return;
+	}
+
+	CloseFile();
+	ShiftGenerations();
+	if (!OpenFile("w"))
+	{
+		fprintf(stderr, "Failed to open %s after rotation: %s\n", logConfig.file, strerror(errno));
+	}
+}
+
+/**
+ * @brief Get the calling thread's ring, creating it on first use.
+ * @return ring, or NULL if no more rings can be created.
+ */
+static LogRing *GetThreadRing(void)
+{
+	LogRing *ring;
+
+	if (threadRing != NULL)
+	{
+		return threadRing;
+	}
+
+	pthread_mutex_lock(&logLock);
+	if (numRings < LOG_MAX_RINGS && (ring = calloc(1, sizeof(LogRing))) != NULL)
+	{
+		rings[numRings] = ring;
+		__atomic_store_n(&numRings, numRings + 1, __ATOMIC_RELEASE);
+		threadRing = ring;
+	}
+	pthread_mutex_unlock(&logLock);
+	return threadRing;
+}
+
+/**
+ * @brief Fill a record for a message.
+ * @param *record record to fill.
+ * @param *site call site.
+ * @param level message level.
+ * @param *file source file.
+ * @param line source line.
+ * @param *format printf format.
+ * @param *args argument list matching format.
+ */
+static void FillRecord(LogRecord *record, LogSite *site, int level, const char *file, int line,
+		const char *format, va_list *args)
+{
+	record->sequence = __atomic_fetch_add(&nextSequence, 1, __ATOMIC_RELAXED);
+	record->monotonicNs = GetTimeNs(CLOCK_MONOTONIC);
+	record->time = time(NULL);
+	record->site = site;
+	record->file = file;
+	record->format = format;
+	record->line = line;
+	record->level = level;
+	LogFormat_Pack(&record->arguments, format, args);
+}
+
+/**
+ * @brief Queue a log message without blocking. Before Log_Start, or after Log_Stop, the message
+ *        is written right away. If the calling thread's ring is full the message is dropped.
+ * @param *site call site, must be static.
+ * @param level message level.
+ * @param *file source file, must be a string literal.
+ * @param line source line.
+ * @param *format printf format, must be a string literal.
+ */
+void Log_Write(LogSite *site, int level, const char *file, int line, const char *format, ...)
+{
+	LogRing *ring = NULL;
+	va_list args;
+
+	if (__atomic_load_n(&logRunning, __ATOMIC_ACQUIRE))
+	{
+		ring = GetThreadRing();
+	}
+
+	va_start(args, format);
+	if (ring != NULL)
+	{
+		unsigned int tail = ring->tail;
+		unsigned int depth = tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+		if (depth == LOG_RING_SIZE)
+		{
+			__atomic_add_fetch(&ring->drops, 1, __ATOMIC_RELAXED);
+		}
+		else
+		{
+			FillRecord(&ring->records[tail % LOG_RING_SIZE], site, level, file, line, format,
+					&args);
+			__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+			/* Otherwise the log thread picks the message up within flushInterval */
+			if ((level <= LOG_ERR || depth + 1 >= LOG_WAKEUP_DEPTH) &&
+				__atomic_exchange_n(&logSleeping, 0, __ATOMIC_ACQ_REL))
+			{
+				uint64_t one = 1;
+
+				if (write(logWakeup, &one, sizeof(one)) < 0)
+				{
+					/* Log thread wakes up on its flush timeout anyway */
+				}
+			}
+		}
+	}
+	else
+	{
+		LogRecord record;
+
+		FillRecord(&record, site, level, file, line, format, &args);
+		pthread_mutex_lock(&logLock);
+		if (debugStream == NULL)
+		{
+			debugStream = stdout;
+		}
+		WriteRecord(&record);
+		Flush();
+		RotateIfDue(record.time);
+		pthread_mutex_unlock(&logLock);
+	}
+	va_end(args);
+}
+
+/**
+ * @brief Write every queued message, oldest first over all rings, and flush if due.
+ * @param *flushMs set to ms until a flush is due, -1 if nothing is waiting.
+ * @return number of messages written.
+ */
+static unsigned int DrainRings(int *flushMs)
+{
+	unsigned int count = __atomic_load_n(&numRings, __ATOMIC_ACQUIRE);
+	unsigned int written = 0;
+	unsigned long drops = 0;
+	unsigned int i;
+
+	pthread_mutex_lock(&logLock);
+	if (debugStream == NULL)
+	{
+		debugStream = stdout;
+	}
+
+	for (;;)
+	{
+		LogRing *oldest = NULL;
+		const LogRecord *record;
+
+		for (i = 0; i < count; i++)
+		{
+			LogRing *ring = rings[i];
+
+			if (ring->head != __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) &&
+				(oldest == NULL || ring->records[ring->head % LOG_RING_SIZE].sequence <
+					oldest->records[oldest->head % LOG_RING_SIZE].sequence))
+			{
+				oldest = ring;
+			}
+		}
+
+		if (oldest == NULL)
+		{
+			break;
+		}
+
+		record = &oldest->records[oldest->head % LOG_RING_SIZE];
+		WriteRecord(record);
+		RotateIfDue(record->time);
+		__atomic_store_n(&oldest->head, oldest->head + 1, __ATOMIC_RELEASE);
+		written++;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		drops += __atomic_load_n(&rings[i]->drops, __ATOMIC_RELAXED);
+	}
+	if (drops != reportedDrops)
+	{
+		WriteDrops(drops);
+		written++;
+	}
+
+	*flushMs = FlushIfDue();
+	pthread_mutex_unlock(&logLock);
+	return written;
+}
+
+/**
+ * @brief Log thread, writes queued messages and sleeps while there are none, or until the
+ *        written messages are due to be flushed.
+ * @param *arg unused.
+ * @return NULL.
+ */
+static void *LogThread(void *arg)
+{
+	struct pollfd wakeup = {logWakeup, POLLIN, 0};
+	uint64_t value;
+	int flushMs;
+
+	while (__atomic_load_n(&logRunning, __ATOMIC_ACQUIRE))
+	{
+		if (DrainRings(&flushMs) > 0)
+		{
+			continue;
+		}
+
+		/* Announce sleep, then look once more so no error is left behind */
+		__atomic_store_n(&logSleeping, 1, __ATOMIC_SEQ_CST);
+		if (DrainRings(&flushMs) > 0)
+		{
+			__atomic_store_n(&logSleeping, 0, __ATOMIC_RELAXED);
+			continue;
+		}
+
+		if (poll(&wakeup, 1, (flushMs >= 0) ? flushMs : (int)logConfig.flushInterval) > 0 &&
+			read(logWakeup, &value, sizeof(value)) < 0)
+		{
+			/* Nothing to do, eventfd is cleared on the next wakeup */
+		}
+		__atomic_store_n(&logSleeping, 0, __ATOMIC_RELAXED);
+	}
+	return NULL;
+}
+
+/**
+ * @brief Open the log file and start the log thread. Messages logged from then on are written
+ *        asynchronously, and flushed in batches, right away for errors.
+ * @param *config log file configuration.
+ * @return true if log thread started, else false and logging stays synchronous.
+ */
+bool Log_Start(const LogConfig *config)
+{
+	struct stat status;
+	bool opened = true;
+
+	if (logRunning)
+	{
+		return true;
+	}
+
+	pthread_mutex_lock(&logLock);
+	logConfig = *config;
+	logBinary = (config->binary && config->file != NULL);
+	if (config->file != NULL)
+	{
+		logBuffer = malloc(config->flushSize);
+
+		/* Keep the log of the previous run as the newest generation */
+		if (config->generations > 0 && stat(config->file, &status) == 0 && status.st_size > 0)
+		{
+			ShiftGenerations();
+		}
+		opened = OpenFile("w");
+		logBinary = (logBinary && opened);
+	}
+	else if (debugStream == NULL)
+	{
+		debugStream = stdout;
+	}
+	pthread_mutex_unlock(&logLock);
+
+	if (!opened)
+	{
+		LOG(LOG_ERR, "Failed to create or open %s file", config->file);
+	}
+	if (config->binary && !logBinary)
+	{
+		LOG(LOG_WARN, "Binary log needs a log file, logging text");
+	}
+
+	logWakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (logWakeup < 0)
+	{
+		LOG(LOG_ERR, "Failed to create log wakeup: %s", strerror(errno));
+		return false;
+	}
+
+	__atomic_store_n(&logRunning, true, __ATOMIC_RELEASE);
+	if (pthread_create(&logThread, NULL, LogThread, NULL) != 0)
+	{
+		__atomic_store_n(&logRunning, false, __ATOMIC_RELEASE);
+		close(logWakeup);
+		logWakeup = -1;
+		LOG(LOG_ERR, "Failed to start log thread");
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Close and open the log file again, for rotation by another program.
+ */
+void Log_Reopen(void)
+{
+	bool opened;
+
+	if (logConfig.file == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&logLock);
+	CloseFile();
+	opened = OpenFile("a");
+	pthread_mutex_unlock(&logLock);
+
+	if (opened)
+	{
+		LOG(LOG_INFO, "Reopened log file %s", logConfig.file);
+	}
+	else
+	{
+		LOG(LOG_ERR, "Failed to reopen %s file", logConfig.file);
+	}
+}
+
+/**
+ * @brief Write every queued message and stop the log thread.
+ */
+void Log_Stop(void)
+{
+	uint64_t one = 1;
+	int flushMs;
+
+	if (!logRunning)
+	{
+		return;
+	}
+
+	__atomic_store_n(&logRunning, false, __ATOMIC_RELEASE);
+	if (write(logWakeup, &one, sizeof(one)) < 0)
+	{
+		/* Log thread wakes up on its flush timeout anyway */
+	}
+	pthread_join(logThread, NULL);
+
+	/* Messages queued while the thread was stopping */
+	DrainRings(&flushMs);
+	pthread_mutex_lock(&logLock);
+	Flush();
+	pthread_mutex_unlock(&logLock);
+	close(logWakeup);
+	logWakeup = -1;
+}
+
+/**
+ * @brief Get number of messages dropped because a thread's ring was full.
+ * @return drop count.
+ */
+unsigned long Log_GetDrops(void)
+{
+	unsigned int count = __atomic_load_n(&numRings, __ATOMIC_ACQUIRE);
+	unsigned long drops = 0;
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+	{
+		drops += __atomic_load_n(&rings[i]->drops, __ATOMIC_RELAXED);
+	}
+	return drops;
+}
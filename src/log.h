@@ -36,6 +36,7 @@
 #ifndef LOG_H
 #define LOG_H
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
@@ -51,31 +52,60 @@
 #define TIME_BUFFER_SIZE  (32)
 //! \}
 
-/** Macro for printing logging message with current time, function and line no. */
-#define DEBUG_PRINT                                                           \
-	do {                                                                      \
-		time_t currentTime = time(NULL);                                      \
-		char buffer[TIME_BUFFER_SIZE] = {0};                                  \
-		strftime(buffer, TIME_BUFFER_SIZE, "%x %X", localtime(&currentTime)); \
-		fprintf(debugStream,"[%s] %s:%d: ", buffer, __FILENAME__, __LINE__);  \
-	} while (0)
+//! @cond Doxygen_Suppress
+#define LOG_MAX_SIZE		(1024 * 1024)
+#define LOG_MAX_AGE			(7 * 24 * 60 * 60)
+#define LOG_GENERATIONS		(3)
+#define LOG_FLUSH_INTERVAL	(1000)
+#define LOG_FLUSH_SIZE		(4096)
+//! @endcond
+
+/**
+ * Least severe level kept in the build, LOG calls for less severe levels compile away. Set with
+ * the LOG_MIN_LEVEL cmake option.
+ */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_DBG
+#endif
 
-/** Macro for logging message at the specified level. */
-#define LOG(level, ...)                         \
-	do {                                        \
-		if (level <= debugLevel)                \
-		{                                       \
-			if (debugStream == NULL)            \
-				debugStream = stdout;           \
-			fprintf(debugStream, "\n");         \
-			if (debugLevel == LOG_DBG)          \
-			{                                   \
-				DEBUG_PRINT;                    \
-			}                                   \
-			fprintf(debugStream, __VA_ARGS__);  \
-			fprintf(debugStream, "\n");         \
-			fflush(debugStream);                \
-		}                                       \
+/**
+ * A structure to contain the format ID of one LOG call site, used by the binary log format.
+ */
+typedef struct
+{
+	/*@{*/
+	unsigned int id; /**< format ID, 0 until the call site first logs */
+	unsigned int generation; /**< binary log file the format was last defined in */
+	/*@}*/
+}LogSite;
+
+/**
+ * A structure to contain log file configuration.
+ */
+typedef struct
+{
+	/*@{*/
+	const char *file; /**< log file, NULL to log to stdout */
+	bool binary; /**< write the binary log format, see button_gateway_logdecode */
+	unsigned long maxSize; /**< rotate the file once it has this many bytes, 0 for no limit */
+	unsigned int maxAge; /**< rotate the file once it is this many seconds old, 0 for no limit */
+	unsigned int generations; /**< rotated files kept as file.1 (newest) to file.N */
+	unsigned int flushInterval; /**< ms a written message is held at most before flushing */
+	unsigned int flushSize; /**< bytes held at most before flushing */
+	/*@}*/
+}LogConfig;
+
+/**
+ * Macro for logging message at the specified level. Arguments are copied into a per-thread ring
+ * and formatted and written by the log thread, once Log_Start has been called.
+ */
+#define LOG(level, ...)                                                 \
+	do {                                                                \
+		if (level <= LOG_MIN_LEVEL && level <= debugLevel)              \
+		{                                                               \
+			static LogSite logSite;                                     \
+			Log_Write(&logSite, level, __FILE__, __LINE__, __VA_ARGS__); \
+		}                                                               \
 	} while (0)
 
 /** Output stream to dump logs. */
@@ -83,5 +113,48 @@ extern FILE *debugStream;
 /** Debug level for logs. */
 extern int debugLevel;
 
+/**
+ * @brief Queue a log message without blocking. Before Log_Start, or after Log_Stop, the message
+ *        is written right away. If the calling thread's ring is full the message is dropped.
+ * @param *site call site, must be static.
+ * @param level message level.
+ * @param *file source file, must be a string literal.
+ * @param line source line.
+ * @param *format printf format, must be a string literal.
+ */
+void Log_Write(LogSite *site, int level, const char *file, int line, const char *format, ...)
+		__attribute__((format(printf, 5, 6)));
+
+/**
+ * @brief Read the optional log group of the configuration file, other fields get defaults.
+ * @param *config filled with configuration, file and binary are left to the caller.
+ * @param *file configuration file, may not exist.
+ * @return true if configuration is usable, else false and config holds the defaults.
+ */
+bool Log_LoadConfig(LogConfig *config, const char *file);
+
+/**
+ * @brief Open the log file and start the log thread. Messages logged from then on are written
+ *        asynchronously, and flushed in batches, right away for errors.
+ * @param *config log file configuration.
+ * @return true if log thread started, else false and logging stays synchronous.
+ */
+bool Log_Start(const LogConfig *config);
+
+/**
+ * @brief Close and open the log file again, for rotation by another program.
+ */
+void Log_Reopen(void);
+
+/**
+ * @brief Write every queued message and stop the log thread.
+ */
+void Log_Stop(void);
+
+/**
+ * @brief Get number of messages dropped because a thread's ring was full.
+ * @return drop count.
+ */
+unsigned long Log_GetDrops(void);
 
 #endif	/* LOG_H */
@@ -0,0 +1,585 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file log_format.c
+ * @brief Packs log message arguments so they can be formatted later, on the log thread or by the
+ *        binary log decoder, and formats them back into text.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <string.h>
+
+#include "log.h"
+#include "log_format.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define LOG_SPEC_SIZE		(32)
+//! @endcond
+
+/***************************************************************************************************
+ * Typedef
+ **************************************************************************************************/
+
+/**
+ * Conversion specifier parsed from a format.
+ */
+typedef struct
+{
+	/*@{*/
+	const char *start; /**< '%' of the specifier */
+	const char *end; /**< character after the conversion */
+	int stars; /**< number of '*' width and precision arguments */
+	int length; /**< length modifier: 0 none, 'h', 'H' (hh), 'l', 'q' (ll), 'j', 'z', 't', 'L' */
+	char conversion; /**< conversion character */
+	/*@}*/
+}LogSpec;
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Parse the conversion specifier starting at a '%'.
+ * @param *start '%' of the specifier.
+ * @param *spec filled with the parsed specifier.
+ */
+static void ParseSpec(const char *start, LogSpec *spec)
+{
+	const char *p = start + 1;
+
+	memset(spec, 0, sizeof(*spec));
+	spec->start = start;
+
+	while (*p && strchr("-+ #0'", *p))
+	{
+		p++;
+	}
+	for (; *p == '*' || (*p >= '0' && *p <= '9') || *p == '.'; p++)
+	{
+		if (*p == '*')
+		{
+			spec->stars++;
+		}
+	}
+
+	switch (*p)
+	{
+		case 'h':
+			spec->length = (p[1] == 'h') ? 'H' : 'h';
+			p += (p[1] == 'h') ? 2 : 1;
+			break;
+		case 'l':
+			spec->length = (p[1] == 'l') ? 'q' : 'l';
+			p += (p[1] == 'l') ? 2 : 1;
+			break;
+		case 'j':
+		case 'z':
+		case 't':
+		case 'L':
+			spec->length = *p++;
+			break;
+	}
+
+	spec->conversion = *p;
+	spec->end = *p ? p + 1 : p;
+}
+
+/**
+ * @brief Check whether a conversion takes an integer argument.
+ * @param conversion conversion character.
+ * @return true for integer conversions, else false.
+ */
+static bool IsIntegerConversion(char conversion)
+{
+	return (conversion != '\0' && strchr("diouxXc", conversion) != NULL);
+}
+
+/**
+ * @brief Check whether a conversion takes a floating point argument.
+ * @param conversion conversion character.
+ * @return true for floating point conversions, else false.
+ */
+static bool IsFloatConversion(char conversion)
+{
+	return (conversion != '\0' && strchr("fFeEgGaA", conversion) != NULL);
+}
+
+/**
+ * @brief Read an integer argument of the size given by the length modifier.
+ * @param *spec conversion specifier.
+ * @param *args argument list.
+ * @return argument, widened.
+ */
+static long long ReadInteger(const LogSpec *spec, va_list *args)
+{
+	bool isSigned = (spec->conversion == 'd' || spec->conversion == 'i');
+
+	switch (spec->length)
+	{
+		case 'l':
+			return isSigned ? va_arg(*args, long) : (long long)va_arg(*args, unsigned long);
+		case 'q':
+			return va_arg(*args, long long);
+		case 'j':
+			return (long long)va_arg(*args, intmax_t);
+		case 'z':
+			return (long long)va_arg(*args, size_t);
+		case 't':
+			return (long long)va_arg(*args, ptrdiff_t);
+		default:
+			return isSigned ? va_arg(*args, int) : (long long)va_arg(*args, unsigned int);
+	}
+}
+
+/**
+ * @brief Pack the arguments of a message. Strings are copied, because they may not outlive the
+ *        call.
+ * @param *arguments filled with the packed arguments.
+ * @param *format printf format.
+ * @param *args argument list matching format.
+ */
+void LogFormat_Pack(LogArguments *arguments, const char *format, va_list *args)
+{
+	unsigned char *out = arguments->data;
+	unsigned char *end = arguments->data + LOG_ARGS_SIZE;
+	const char *p;
+	LogSpec spec;
+	int i;
+
+	arguments->truncated = false;
+	for (p = strchr(format, '%'); p != NULL; p = strchr(spec.end, '%'))
+	{
+		ParseSpec(p, &spec);
+		if (spec.conversion == '%' || spec.conversion == '\0')
+		{
+			if (spec.conversion == '\0')
+			{
+				break;
+			}
+			continue;
+		}
+
+		for (i = 0; i < spec.stars; i++)
+		{
+			int star = va_arg(*args, int);
+
+			if (out + sizeof(star) > end)
+			{
+				arguments->truncated = true;
+				goto done;
+			}
+			memcpy(out, &star, sizeof(star));
+			out += sizeof(star);
+		}
+
+		if (IsIntegerConversion(spec.conversion))
+		{
+			long long value = ReadInteger(&spec, args);
+
+			if (out + sizeof(value) > end)
+			{
+				arguments->truncated = true;
+				break;
+			}
+			memcpy(out, &value, sizeof(value));
+			out += sizeof(value);
+		}
+		else if (IsFloatConversion(spec.conversion))
+		{
+			double value = (spec.length == 'L') ? (double)va_arg(*args, long double) :
+					va_arg(*args, double);
+
+			if (out + sizeof(value) > end)
+			{
+				arguments->truncated = true;
+				break;
+			}
+			memcpy(out, &value, sizeof(value));
+			out += sizeof(value);
+		}
+		else if (spec.conversion == 's')
+		{
+			const char *value = va_arg(*args, const char *);
+			size_t length, room = end - out;
+
+			if (value == NULL)
+			{
+				value = "(null)";
+			}
+			length = strlen(value);
+			if (room == 0)
+			{
+				arguments->truncated = true;
+				break;
+			}
+			if (length >= room)
+			{
+				length = room - 1;
+				arguments->truncated = true;
+			}
+			memcpy(out, value, length);
+			out[length] = '\0';
+			out += length + 1;
+		}
+		else
+		{
+			/* %p, and anything else takes a pointer sized argument */
+			uint64_t value = (uintptr_t)va_arg(*args, void *);
+
+			if (out + sizeof(value) > end)
+			{
+				arguments->truncated = true;
+				break;
+			}
+			memcpy(out, &value, sizeof(value));
+			out += sizeof(value);
+		}
+	}
+done:
+	arguments->length = out - arguments->data;
+}
+
+/**
+ * @brief Append formatted text to a message buffer.
+ * @param *buffer message buffer.
+ * @param *used bytes used in buffer, updated.
+ * @param size buffer size.
+ * @param *format printf format.
+ */
+static void Append(char *buffer, size_t *used, size_t size, const char *format, ...)
+{
+	va_list args;
+	int written;
+
+	if (*used >= size - 1)
+	{
+		return;
+	}
+
+	va_start(args, format);
+	written = vsnprintf(buffer + *used, size - *used, format, args);
+	va_end(args);
+
+	if (written > 0)
+	{
+		*used += ((size_t)written < size - *used) ? (size_t)written : size - *used - 1;
+	}
+}
+
+/**
+ * @brief Format a message from its packed arguments. Each specifier is formatted on its own,
+ *        with its length modifier replaced to match the widened argument.
+ * @param *format printf format the arguments were packed with.
+ * @param *arguments packed arguments.
+ * @param *buffer filled with the formatted message.
+ * @param size buffer size.
+ * @return message length.
+ */
+size_t LogFormat_Print(const char *format, const LogArguments *arguments, char *buffer,
+		size_t size)
+{
+	const unsigned char *in = arguments->data;
+	const unsigned char *end = arguments->data + arguments->length;
+	const char *p = format;
+	const char *percent;
+	char specText[LOG_SPEC_SIZE];
+	size_t used = 0;
+	LogSpec spec;
+
+	buffer[0] = '\0';
+	while ((percent = strchr(p, '%')) != NULL)
+	{
+		Append(buffer, &used, size, "%.*s", (int)(percent - p), p);
+		ParseSpec(percent, &spec);
+		p = spec.end;
+
+		if (spec.conversion == '%')
+		{
+			Append(buffer, &used, size, "%%");
+			continue;
+		}
+
+		/* Flags, width and precision, without length modifier */
+		size_t prefix = strspn(spec.start + 1, "-+ #0'*.0123456789") + 1;
+		int stars[2] = {0, 0};
+		int i;
+
+		if (spec.conversion == '\0' || prefix + 4 > LOG_SPEC_SIZE)
+		{
+			break;
+		}
+
+		for (i = 0; i < spec.stars && i < 2; i++)
+		{
+			if (in + sizeof(int) > end)
+			{
+				goto truncated;
+			}
+			memcpy(&stars[i], in, sizeof(int));
+			in += sizeof(int);
+		}
+
+		memcpy(specText, spec.start, prefix);
+		if (spec.conversion == 'c')
+		{
+			long long value;
+
+			if (in + sizeof(value) > end)
+			{
+				goto truncated;
+			}
+			memcpy(&value, in, sizeof(value));
+			in += sizeof(value);
+			Append(buffer, &used, size, "%c", (int)value);
+		}
+		else if (IsIntegerConversion(spec.conversion))
+		{
+			long long value;
+
+			if (in + sizeof(value) > end)
+			{
+				goto truncated;
+			}
+			memcpy(&value, in, sizeof(value));
+			in += sizeof(value);
+			memcpy(specText + prefix, "ll", 2);
+			specText[prefix + 2] = spec.conversion;
+			specText[prefix + 3] = '\0';
+
+			if (spec.stars == 2)
+			{
+				Append(buffer, &used, size, specText, stars[0], stars[1], value);
+			}
+			else if (spec.stars == 1)
+			{
+				Append(buffer, &used, size, specText, stars[0], value);
+			}
+			else
+			{
+				Append(buffer, &used, size, specText, value);
+			}
+		}
+		else if (IsFloatConversion(spec.conversion))
+		{
+			double value;
+
+			if (in + sizeof(value) > end)
+			{
+				goto truncated;
+			}
+			memcpy(&value, in, sizeof(value));
+			in += sizeof(value);
+			specText[prefix] = spec.conversion;
+			specText[prefix + 1] = '\0';
+
+			if (spec.stars == 2)
+			{
+				Append(buffer, &used, size, specText, stars[0], stars[1], value);
+			}
+			else if (spec.stars == 1)
+			{
+				Append(buffer, &used, size, specText, stars[0], value);
+			}
+			else
+			{
+				Append(buffer, &used, size, specText, value);
+			}
+		}
+		else if (spec.conversion == 's')
+		{
+			const char *value = (const char *)in;
+
+			if (in >= end || memchr(in, '\0', end - in) == NULL)
+			{
+				goto truncated;
+			}
+			in += strlen(value) + 1;
+			specText[prefix] = 's';
+			specText[prefix + 1] = '\0';
+
+			if (spec.stars == 2)
+			{
+				Append(buffer, &used, size, specText, stars[0], stars[1], value);
+			}
+			else if (spec.stars == 1)
+			{
+				Append(buffer, &used, size, specText, stars[0], value);
+			}
+			else
+			{
+				Append(buffer, &used, size, specText, value);
+			}
+		}
+		else
+		{
+			uint64_t value;
+
+			if (in + sizeof(value) > end)
+			{
+				goto truncated;
+			}
+			memcpy(&value, in, sizeof(value));
+			in += sizeof(value);
+			if (value != 0)
+			{
+				Append(buffer, &used, size, "0x%llx", (unsigned long long)value);
+			}
+			else
+			{
+				Append(buffer, &used, size, "(nil)");
+			}
+		}
+	}
+	Append(buffer, &used, size, "%s", p);
+	if (arguments->truncated)
+	{
+		Append(buffer, &used, size, " [truncated]");
+	}
+	return used;
+
+truncated:
+	Append(buffer, &used, size, "... [truncated]");
+	return used;
+}
+
+
+/**
+ * @brief Reverse the byte order of a value in place.
+ * @param *value value to swap.
+ * @param size value size.
+ */
+static void SwapBytes(unsigned char *value, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size / 2; i++)
+	{
+		unsigned char tmp = value[i];
+
+		value[i] = value[size - 1 - i];
+		value[size - 1 - i] = tmp;
+	}
+}
+
+/**
+ * @brief Swap the byte order of packed arguments, for files written on a machine of the other
+ *        endianness.
+ * @param *format printf format the arguments were packed with.
+ * @param *arguments packed arguments to swap in place.
+ */
+void LogFormat_Swap(const char *format, LogArguments *arguments)
+{
+	unsigned char *in = arguments->data;
+	unsigned char *end = arguments->data + arguments->length;
+	const char *p;
+	LogSpec spec;
+	int i;
+
+	for (p = strchr(format, '%'); p != NULL; p = strchr(spec.end, '%'))
+	{
+		ParseSpec(p, &spec);
+		if (spec.conversion == '\0')
+		{
+			break;
+		}
+		if (spec.conversion == '%')
+		{
+			continue;
+		}
+
+		for (i = 0; i < spec.stars; i++)
+		{
+			if (in + sizeof(int) > end)
+			{
+				return;
+			}
+			SwapBytes(in, sizeof(int));
+			in += sizeof(int);
+		}
+
+		if (spec.conversion == 's')
+		{
+			in += strnlen((const char *)in, end - in) + 1;
+		}
+		else
+		{
+			/* Everything else is widened to 64 bits */
+			if (in + sizeof(uint64_t) > end)
+			{
+				return;
+			}
+			SwapBytes(in, sizeof(uint64_t));
+			in += sizeof(uint64_t);
+		}
+	}
+}
+
+/**
+ * @brief Write a formatted message with the decoration LOG always had: a blank line before it,
+ *        and at debug level the time, file and line.
+ * @param *stream output stream.
+ * @param decorate whether to write time, file and line.
+ * @param when time the message was logged.
+ * @param *file source file.
+ * @param line source line.
+ * @param *message formatted message.
+ * @param length message length.
+ * @return bytes written.
+ */
+size_t LogFormat_WriteMessage(FILE *stream, bool decorate, time_t when, const char *file, int line,
+		const char *message, size_t length)
+{
+	const char *name = strrchr(file, '/');
+	size_t written = 2;
+	int prefix;
+
+	fputc('\n', stream);
+	if (decorate)
+	{
+		char buffer[TIME_BUFFER_SIZE] = {0};
+		struct tm local;
+
+		localtime_r(&when, &local);
+		strftime(buffer, TIME_BUFFER_SIZE, "%x %X", &local);
+		prefix = fprintf(stream, "[%s] %s:%d: ", buffer, name ? name + 1 : file, line);
+		written += (prefix > 0) ? prefix : 0;
+	}
+	written += fwrite(message, 1, length, stream);
+	fputc('\n', stream);
+	return written;
+}
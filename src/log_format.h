@@ -0,0 +1,150 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file log_format.h
+ * @brief Header file for log message packing and formatting, shared by the gateway and the
+ *        binary log decoder, and for the binary log file layout.
+ */
+
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+//! @cond Doxygen_Suppress
+#define LOG_ARGS_SIZE			(216)
+#define LOG_BINARY_MAGIC		(0x42474c47)
+#define LOG_BINARY_VERSION		(1)
+//! @endcond
+
+/**
+ * A structure to contain the arguments of one message, packed by LogFormat_Pack. Integers are
+ * widened to 64 bits, floating point values to double and pointers to 64 bits. Strings are
+ * copied with their terminator, '*' width and precision are 32 bit ints.
+ */
+typedef struct
+{
+	/*@{*/
+	uint16_t length; /**< bytes used in data */
+	bool truncated; /**< arguments didn't fit */
+	unsigned char data[LOG_ARGS_SIZE]; /**< packed arguments */
+	/*@}*/
+}LogArguments;
+
+/**
+ * Binary log entry types.
+ */
+typedef enum
+{
+	LogEntry_Format = 1, /**< defines a format ID, payload is LogFormatEntry, file and format */
+	LogEntry_Message, /**< message, payload is the monotonic time in ns and packed arguments */
+	LogEntry_Drops /**< messages dropped, payload is the count as uint64_t */
+}LogEntryType;
+
+/**
+ * A structure to contain the header at the start of a binary log file. Fields are written in
+ * the byte order of the gateway, magic tells the decoder whether to swap them.
+ */
+typedef struct
+{
+	/*@{*/
+	uint32_t magic; /**< LOG_BINARY_MAGIC */
+	uint32_t version; /**< LOG_BINARY_VERSION */
+	uint64_t wallNs; /**< wall clock time when the file was started */
+	uint64_t monotonicNs; /**< monotonic time when the file was started */
+	uint32_t debugLevel; /**< debug level of the gateway, decides the text decoration */
+	uint32_t reserved; /**< zero */
+	/*@}*/
+}LogBinaryHeader;
+
+/**
+ * A structure to contain the header of each binary log entry.
+ */
+typedef struct
+{
+	/*@{*/
+	uint8_t type; /**< LogEntryType */
+	uint8_t level; /**< message level */
+	uint8_t truncated; /**< message arguments were truncated */
+	uint8_t reserved; /**< zero */
+	uint32_t id; /**< format ID of a format or message entry */
+	uint32_t length; /**< payload bytes following the entry header */
+	/*@}*/
+}LogBinaryEntry;
+
+/**
+ * @brief Pack the arguments of a message.
+ * @param *arguments filled with the packed arguments.
+ * @param *format printf format.
+ * @param *args argument list matching format.
+ */
+void LogFormat_Pack(LogArguments *arguments, const char *format, va_list *args);
+
+/**
+ * @brief Format a message from its packed arguments.
+ * @param *format printf format the arguments were packed with.
+ * @param *arguments packed arguments.
+ * @param *buffer filled with the formatted message.
+ * @param size buffer size.
+ * @return message length.
+ */
+size_t LogFormat_Print(const char *format, const LogArguments *arguments, char *buffer,
+		size_t size);
+
+/**
+ * @brief Swap the byte order of packed arguments, for files written on a machine of the other
+ *        endianness.
+ * @param *format printf format the arguments were packed with.
+ * @param *arguments packed arguments to swap in place.
+ */
+void LogFormat_Swap(const char *format, LogArguments *arguments);
+
+/**
+ * @brief Write a formatted message with the decoration LOG always had: a blank line before it,
+ *        and at debug level the time, file and line.
+ * @param *stream output stream.
+ * @param decorate whether to write time, file and line.
+ * @param when time the message was logged.
+ * @param *file source file.
+ * @param line source line.
+ * @param *message formatted message.
+ * @param length message length.
+ * @return bytes written.
+ */
+size_t LogFormat_WriteMessage(FILE *stream, bool decorate, time_t when, const char *file, int line,
+		const char *message, size_t length);
+
+#endif	/* LOG_FORMAT_H */
@@ -0,0 +1,316 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file metrics.c
+ * @brief Local metrics endpoint. The listening socket is watched by the event loop and every
+ *        accepted client is sent a complete exposition without blocking, then disconnected. The
+ *        exposition is a few KiB, which always fits the socket's send buffer; if a client doesn't
+ *        read it, the rest is dropped rather than holding up the loop.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <libconfig.h>
+
+#include "metrics.h"
+#include "log.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define METRICS_BACKLOG		(4)
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Fill configuration with defaults, then override them from the "metrics" group of a
+ *        libconfig file if there is one.
+ * @param *config configuration to fill.
+ * @param *file configuration file, may not exist.
+ * @return true if configuration is usable, else false.
+ */
+bool Metrics_LoadConfig(MetricsConfig *config, const char *file)
+{
+	config_t cfg;
+	config_setting_t *group;
+	const char *string;
+	bool success = true;
+
+	memset(config, 0, sizeof(*config));
+	strncpy(config->socket, METRICS_SOCKET, METRICS_PATH_SIZE - 1);
+
+	if (access(file, F_OK) != 0)
+	{
+		return true;
+	}
+
+	config_init(&cfg);
+	if (!config_read_file(&cfg, file))
+	{
+		LOG(LOG_ERR, "Failed to parse %s:%d: %s",
+				file, config_error_line(&cfg), config_error_text(&cfg));
+		success = false;
+	}
+	else if ((group = config_lookup(&cfg, "metrics")) != NULL)
+	{
+		if (config_setting_lookup_string(group, "socket", &string))
+		{
+			if (strlen(string) >= METRICS_PATH_SIZE)
+			{
+				LOG(LOG_ERR, "Metrics socket path must be shorter than %d", METRICS_PATH_SIZE);
+				success = false;
+			}
+			else
+			{
+				snprintf(config->socket, METRICS_PATH_SIZE, "%s", string);
+			}
+		}
+	}
+	config_destroy(&cfg);
+	return success;
+}
+
+/**
+ * @brief Append formatted text to an exposition, marking it truncated if it doesn't fit.
+ * @param *buffer exposition to add to.
+ * @param *format printf style format.
+ */
+static void Append(MetricsBuffer *buffer, const char *format, ...)
+{
+	va_list args;
+	size_t space = METRICS_BUFFER_SIZE - buffer->length;
+	int length;
+
+	if (buffer->truncated)
+	{
+		return;
+	}
+
+	va_start(args, format);
+	length = vsnprintf(buffer->data + buffer->length, space, format, args);
+	va_end(args);
+
+	if (length < 0 || (size_t)length >= space)
+	{
+		buffer->truncated = true;
+		return;
+	}
+	buffer->length += length;
+}
+
+/**
+ * @brief Add the HELP and TYPE lines of a metric family. Must be followed by its samples.
+ * @param *buffer exposition to add to.
+ * @param *name metric name.
+ * @param type metric type.
+ * @param *help one line description.
+ */
+void Metrics_AddFamily(MetricsBuffer *buffer, const char *name, MetricsType type,
+		const char *help)
+{
+	Append(buffer, "# HELP %s %s\n# TYPE %s %s\n", name, help, name,
+			type == MetricsType_Counter ? "counter" : "gauge");
+}
+
+/**
+ * @brief Add a sample of the last added family.
+ * @param *buffer exposition to add to.
+ * @param *name metric name.
+ * @param *label label name, NULL for a sample without labels.
+ * @param *labelValue label value, escaped as needed.
+ * @param value sample value.
+ */
+void Metrics_AddSample(MetricsBuffer *buffer, const char *name, const char *label,
+		const char *labelValue, uint64_t value)
+{
+	const char *c;
+
+	if (label == NULL)
+	{
+		Append(buffer, "%s %llu\n", name, (unsigned long long)value);
+		return;
+	}
+
+	Append(buffer, "%s{%s=\"", name, label);
+	for (c = labelValue; *c != '\0'; c++)
+	{
+		if (*c == '\\' || *c == '"')
+		{
+			Append(buffer, "\\%c", *c);
+		}
+		else if (*c == '\n')
+		{
+			Append(buffer, "\\n");
+		}
+		else
+		{
+			Append(buffer, "%c", *c);
+		}
+	}
+	Append(buffer, "\"} %llu\n", (unsigned long long)value);
+}
+
+/**
+ * @brief Reactor callback of the listening socket, sends an exposition to every waiting client.
+ * @param fd listening socket.
+ * @param events epoll events.
+ * @param *context metrics server.
+ */
+static void AcceptClients(int fd, uint32_t events, void *context)
+{
+	MetricsServer *server = context;
+	bool collected = false;
+	ssize_t sent;
+	int client;
+
+	while ((client = accept(fd, NULL, NULL)) >= 0)
+	{
+		/* Clients connecting together get the same exposition */
+		if (!collected)
+		{
+			server->buffer.length = 0;
+			server->buffer.truncated = false;
+			server->collect(&server->buffer, server->context);
+			if (server->buffer.truncated)
+			{
+				LOG(LOG_WARN, "Metrics exposition truncated to %u bytes",
+						(unsigned int)server->buffer.length);
+			}
+			collected = true;
+		}
+
+		sent = send(client, server->buffer.data, server->buffer.length,
+				MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (sent < (ssize_t)server->buffer.length)
+		{
+			LOG(LOG_DBG, "Metrics client took %d of %u bytes", (int)sent,
+					(unsigned int)server->buffer.length);
+		}
+		close(client);
+	}
+
+	if (errno != EAGAIN && errno != EWOULDBLOCK)
+	{
+		LOG(LOG_WARN, "accept() failed on metrics socket: %s", strerror(errno));
+	}
+}
+
+/**
+ * @brief Listen on the configured socket. A stale socket left by an earlier run is replaced.
+ *        Every client that connects is sent one exposition, then the connection is closed.
+ * @param *server endpoint to start.
+ * @param *reactor loop that serves the socket.
+ * @param *config endpoint configuration.
+ * @param collect adds the metrics to each scrape.
+ * @param *context passed to collect.
+ * @return true if listening, or if the endpoint is disabled, else false.
+ */
+bool Metrics_Start(MetricsServer *server, Reactor *reactor, const MetricsConfig *config,
+		MetricsCollector collect, void *context)
+{
+	struct sockaddr_un address;
+
+	server->config = *config;
+	server->fd = -1;
+	server->reactor = reactor;
+	server->collect = collect;
+	server->context = context;
+
+	if (config->socket[0] == '\0')
+	{
+		return true;
+	}
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (snprintf(address.sun_path, sizeof(address.sun_path), "%s", config->socket) >=
+		(int)sizeof(address.sun_path))
+	{
+		LOG(LOG_ERR, "Metrics socket path %s is too long", config->socket);
+		return false;
+	}
+
+	server->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (server->fd < 0)
+	{
+		LOG(LOG_ERR, "Failed to create metrics socket: %s", strerror(errno));
+		return false;
+	}
+
+	unlink(config->socket);
+	if (bind(server->fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+		listen(server->fd, METRICS_BACKLOG) != 0)
+	{
+		LOG(LOG_ERR, "Failed to listen on %s: %s", config->socket, strerror(errno));
+		close(server->fd);
+		server->fd = -1;
+		return false;
+	}
+
+	if (!Reactor_AddFd(reactor, server->fd, AcceptClients, server))
+	{
+		Metrics_Stop(server);
+		return false;
+	}
+	LOG(LOG_INFO, "Serving metrics on %s", config->socket);
+	return true;
+}
+
+/**
+ * @brief Stop listening and remove the socket.
+ * @param *server endpoint to stop.
+ */
+void Metrics_Stop(MetricsServer *server)
+{
+	if (server->fd < 0)
+	{
+		return;
+	}
+
+	Reactor_RemoveFd(server->reactor, server->fd);
+	close(server->fd);
+	unlink(server->config.socket);
+	server->fd = -1;
+}
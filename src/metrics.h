@@ -0,0 +1,155 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file metrics.h
+ * @brief Header file for the local metrics endpoint. Counters and gauges are served in the
+ *        Prometheus text exposition format on a UNIX domain socket, so a scraper on the board can
+ *        collect them without any network exposure.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "reactor.h"
+
+//! @cond Doxygen_Suppress
+#define METRICS_SOCKET			"/var/run/button_gateway_metrics.sock"
+#define METRICS_PATH_SIZE		(108)
+#define METRICS_BUFFER_SIZE		(65536)
+//! @endcond
+
+/**
+ * Prometheus metric type.
+ */
+typedef enum
+{
+	MetricsType_Counter, /**< monotonically increasing count */
+	MetricsType_Gauge /**< value that can go up and down */
+}MetricsType;
+
+/**
+ * A structure to contain metrics endpoint configuration.
+ */
+typedef struct
+{
+	/*@{*/
+	char socket[METRICS_PATH_SIZE]; /**< socket path, empty to disable the endpoint */
+	/*@}*/
+}MetricsConfig;
+
+/**
+ * A structure to contain one exposition being written.
+ */
+typedef struct
+{
+	/*@{*/
+	char data[METRICS_BUFFER_SIZE]; /**< exposition text */
+	size_t length; /**< bytes used in data */
+	bool truncated; /**< set when something didn't fit */
+	/*@}*/
+}MetricsBuffer;
+
+/**
+ * @brief Called from the event loop for every scrape to add the current metrics.
+ * @param *buffer exposition to add to with Metrics_AddFamily and Metrics_AddSample.
+ * @param *context pointer passed to Metrics_Start.
+ */
+typedef void (*MetricsCollector)(MetricsBuffer *buffer, void *context);
+
+/**
+ * A structure to contain the listening socket of the endpoint.
+ */
+typedef struct
+{
+	/*@{*/
+	MetricsConfig config; /**< configuration the endpoint was started with */
+	int fd; /**< listening socket, -1 when stopped */
+	Reactor *reactor; /**< loop the socket is watched by */
+	MetricsCollector collect; /**< adds the metrics to each scrape */
+	void *context; /**< passed to collect */
+	MetricsBuffer buffer; /**< exposition of the current scrape */
+	/*@}*/
+}MetricsServer;
+
+/**
+ * @brief Fill configuration with defaults, then override them from the "metrics" group of a
+ *        libconfig file if there is one.
+ * @param *config configuration to fill.
+ * @param *file configuration file, may not exist.
+ * @return true if configuration is usable, else false.
+ */
+bool Metrics_LoadConfig(MetricsConfig *config, const char *file);
+
+/**
+ * @brief Listen on the configured socket. A stale socket left by an earlier run is replaced.
+ *        Every client that connects is sent one exposition, then the connection is closed.
+ * @param *server endpoint to start.
+ * @param *reactor loop that serves the socket.
+ * @param *config endpoint configuration.
+ * @param collect adds the metrics to each scrape.
+ * @param *context passed to collect.
+ * @return true if listening, or if the endpoint is disabled, else false.
+ */
+bool Metrics_Start(MetricsServer *server, Reactor *reactor, const MetricsConfig *config,
+		MetricsCollector collect, void *context);
+
+/**
+ * @brief Stop listening and remove the socket.
+ * @param *server endpoint to stop.
+ */
+void Metrics_Stop(MetricsServer *server);
+
+/**
+ * @brief Add the HELP and TYPE lines of a metric family. Must be followed by its samples.
+ * @param *buffer exposition to add to.
+ * @param *name metric name.
+ * @param type metric type.
+ * @param *help one line description.
+ */
+void Metrics_AddFamily(MetricsBuffer *buffer, const char *name, MetricsType type,
+		const char *help);
+
+/**
+ * @brief Add a sample of the last added family.
+ * @param *buffer exposition to add to.
+ * @param *name metric name.
+ * @param *label label name, NULL for a sample without labels.
+ * @param *labelValue label value, escaped as needed.
+ * @param value sample value.
+ */
+void Metrics_AddSample(MetricsBuffer *buffer, const char *name, const char *label,
+		const char *labelValue, uint64_t value);
+
+#endif	/* METRICS_H */
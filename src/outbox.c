@@ -0,0 +1,388 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file outbox.c
+ * @brief Store-and-forward outbox of Flow payloads. Payloads live in fixed-size slots of a ring
+ *        file which is mapped shared, so a restarted daemon finds whatever its predecessor left
+ *        pending. There is no fsync per payload: the page cache already survives a daemon crash,
+ *        and the mapping is written back asynchronously after every drained batch.
+ *
+ *        The outbox is used from a single thread.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <libconfig.h>
+
+#include "outbox.h"
+#include "log.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define OUTBOX_MAGIC		(0x4f425831)
+#define OUTBOX_VERSION		(1)
+#define OVERFLOW_OLDEST_STR	"drop-oldest"
+#define OVERFLOW_NEWEST_STR	"drop-newest"
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Fill configuration with defaults, then override them from the "outbox" group of a
+ *        libconfig file if there is one.
+ * @param *config configuration to fill.
+ * @param *file configuration file, may not exist.
+ * @return true if configuration is usable, else false.
+ */
+bool Outbox_LoadConfig(OutboxConfig *config, const char *file)
+{
+	config_t cfg;
+	config_setting_t *group;
+	const char *string;
+	int value;
+	bool success = true;
+
+	memset(config, 0, sizeof(*config));
+	strncpy(config->file, OUTBOX_FILE, OUTBOX_PATH_SIZE - 1);
+	config->capacity = OUTBOX_CAPACITY;
+	config->overflow = OutboxOverflow_DropOldest;
+	config->retention = OUTBOX_RETENTION;
+
+	if (access(file, F_OK) != 0)
+	{
+		return true;
+	}
+
+	config_init(&cfg);
+	if (!config_read_file(&cfg, file))
+	{
+		LOG(LOG_ERR, "Failed to parse %s:%d: %s",
+				file, config_error_line(&cfg), config_error_text(&cfg));
+		success = false;
+	}
+	else if ((group = config_lookup(&cfg, "outbox")) != NULL)
+	{
+		if (config_setting_lookup_string(group, "file", &string))
+		{
+			strncpy(config->file, string, OUTBOX_PATH_SIZE - 1);
+		}
+
+		if (config_setting_lookup_int(group, "capacity", &value))
+		{
+			if (value <= 0 || value > OUTBOX_MAX_CAPACITY)
+			{
+				LOG(LOG_ERR, "Outbox capacity must be 1 to %d", OUTBOX_MAX_CAPACITY);
+				success = false;
+			}
+			config->capacity = value;
+		}
+
+		if (config_setting_lookup_int(group, "retention", &value))
+		{
+			if (value < 0)
+			{
+				LOG(LOG_ERR, "Outbox retention can't be negative");
+				success = false;
+			}
+			config->retention = value;
+		}
+
+		if (config_setting_lookup_string(group, "overflow", &string))
+		{
+			if (strcmp(string, OVERFLOW_OLDEST_STR) == 0)
+			{
+				config->overflow = OutboxOverflow_DropOldest;
+			}
+			else if (strcmp(string, OVERFLOW_NEWEST_STR) == 0)
+			{
+				config->overflow = OutboxOverflow_DropNewest;
+			}
+			else
+			{
+				LOG(LOG_ERR, "Outbox overflow must be %s or %s",
+						OVERFLOW_OLDEST_STR, OVERFLOW_NEWEST_STR);
+				success = false;
+			}
+		}
+	}
+	config_destroy(&cfg);
+	return success;
+}
+
+/**
+ * @brief Create every missing parent directory of a file.
+ * @param *file file path.
+ */
+static void MakeParentDirs(const char *file)
+{
+	char path[OUTBOX_PATH_SIZE];
+	char *slash;
+
+	strncpy(path, file, OUTBOX_PATH_SIZE - 1);
+	path[OUTBOX_PATH_SIZE - 1] = '\0';
+
+	for (slash = strchr(path + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/'))
+	{
+		*slash = '\0';
+		if (mkdir(path, 0755) != 0 && errno != EEXIST)
+		{
+			LOG(LOG_WARN, "Failed to create %s: %s", path, strerror(errno));
+		}
+		*slash = '/';
+	}
+}
+
+/**
+ * @brief Check that a mapped header describes a ring this outbox can use as is.
+ * @param *header mapped header.
+ * @param capacity configured capacity.
+ * @return true if the file holds a consistent ring of the configured shape, else false.
+ */
+static bool IsHeaderValid(const OutboxHeader *header, unsigned int capacity)
+{
+	return (header->magic == OUTBOX_MAGIC &&
+			header->version == OUTBOX_VERSION &&
+			header->capacity == capacity &&
+			header->slotSize == sizeof(OutboxSlot) &&
+			header->head <= header->tail &&
+			header->tail - header->head <= capacity);
+}
+
+/**
+ * @brief Map the ring file, creating it if it doesn't exist or doesn't match the configured
+ *        capacity. Pending payloads of a matching file are kept.
+ * @param *outbox outbox to open.
+ * @param *config outbox configuration.
+ * @return true if outbox is ready, else false.
+ */
+bool Outbox_Open(Outbox *outbox, const OutboxConfig *config)
+{
+	struct stat status;
+	void *map;
+
+	memset(outbox, 0, sizeof(*outbox));
+	outbox->config = *config;
+	outbox->fd = -1;
+	outbox->mapSize = sizeof(OutboxHeader) + (size_t)config->capacity * sizeof(OutboxSlot);
+
+	MakeParentDirs(config->file);
+	outbox->fd = open(config->file, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if (outbox->fd < 0)
+	{
+		LOG(LOG_ERR, "Failed to open outbox %s: %s", config->file, strerror(errno));
+		return false;
+	}
+
+	if (fstat(outbox->fd, &status) != 0 ||
+		((size_t)status.st_size != outbox->mapSize && ftruncate(outbox->fd, outbox->mapSize) != 0))
+	{
+		LOG(LOG_ERR, "Failed to size outbox %s: %s", config->file, strerror(errno));
+		close(outbox->fd);
+		outbox->fd = -1;
+		return false;
+	}
+
+	map = mmap(NULL, outbox->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, outbox->fd, 0);
+	if (map == MAP_FAILED)
+	{
+		LOG(LOG_ERR, "Failed to map outbox %s: %s", config->file, strerror(errno));
+		close(outbox->fd);
+		outbox->fd = -1;
+		return false;
+	}
+	outbox->header = map;
+	outbox->slots = (OutboxSlot *)(outbox->header + 1);
+
+	if (IsHeaderValid(outbox->header, config->capacity))
+	{
+		LOG(LOG_INFO, "Outbox %s has %u pending payloads", config->file, Outbox_GetDepth(outbox));
+	}
+	else
+	{
+		if (outbox->header->magic == OUTBOX_MAGIC)
+		{
+			LOG(LOG_WARN, "Outbox %s doesn't match configuration, pending payloads discarded",
+					config->file);
+		}
+		memset(map, 0, outbox->mapSize);
+		outbox->header->magic = OUTBOX_MAGIC;
+		outbox->header->version = OUTBOX_VERSION;
+		outbox->header->capacity = config->capacity;
+		outbox->header->slotSize = sizeof(OutboxSlot);
+		msync(map, outbox->mapSize, MS_ASYNC);
+	}
+	return true;
+}
+
+/**
+ * @brief Queue a payload. Nothing is flushed to disk here, the mapping is written back by the
+ *        kernel and on every drained batch.
+ * @param *outbox opened outbox.
+ * @param *payload nul terminated payload, truncated to OUTBOX_PAYLOAD_SIZE - 1.
+ * @param pending OUTBOX_MESSAGE and OUTBOX_STATUS sends to do.
+ * @return true if queued without discarding anything, else false.
+ */
+bool Outbox_Push(Outbox *outbox, const char *payload, uint32_t pending)
+{
+	OutboxHeader *header = outbox->header;
+	OutboxSlot *slot;
+	bool success = true;
+	size_t length;
+
+	if (header == NULL)
+	{
+		return false;
+	}
+
+	if (header->tail - header->head == header->capacity)
+	{
+		header->dropped++;
+		success = false;
+		if (outbox->config.overflow == OutboxOverflow_DropNewest)
+		{
+			return false;
+		}
+		header->head++;
+	}
+
+	length = strlen(payload);
+	if (length >= OUTBOX_PAYLOAD_SIZE)
+	{
+		length = OUTBOX_PAYLOAD_SIZE - 1;
+	}
+
+	/* Fill the slot before publishing it through tail */
+	slot = &outbox->slots[header->tail % header->capacity];
+	memcpy(slot->payload, payload, length);
+	slot->payload[length] = '\0';
+	slot->length = length;
+	slot->created = time(NULL);
+	slot->pending = pending;
+	header->tail++;
+	return success;
+}
+
+/**
+ * @brief Send pending payloads oldest first, stopping at the first one which can't be fully sent.
+ *        Payloads past retention are discarded unsent.
+ * @param *outbox opened outbox.
+ * @param send callback doing the sends.
+ * @param *context passed to send.
+ * @param maxBatch maximum number of payloads to send.
+ * @return number of payloads fully sent.
+ */
+unsigned int Outbox_Drain(Outbox *outbox, OutboxSender send, void *context, unsigned int maxBatch)
+{
+	OutboxHeader *header = outbox->header;
+	unsigned int sent = 0;
+	bool changed = false;
+	time_t now = time(NULL);
+
+	if (header == NULL)
+	{
+		return 0;
+	}
+
+	while (header->head != header->tail && sent < maxBatch)
+	{
+		OutboxSlot *slot = &outbox->slots[header->head % header->capacity];
+
+		if (outbox->config.retention != 0 && now - slot->created > outbox->config.retention)
+		{
+			header->expired++;
+		}
+		else
+		{
+			/* Remember partial progress, so a later drain doesn't repeat what was sent */
+			slot->pending = send(slot->payload, slot->pending, context);
+			changed = true;
+			if (slot->pending != 0)
+			{
+				break;
+			}
+			sent++;
+		}
+		header->head++;
+		changed = true;
+	}
+
+	if (changed)
+	{
+		msync(outbox->header, outbox->mapSize, MS_ASYNC);
+	}
+	return sent;
+}
+
+/**
+ * @brief Get number of pending payloads.
+ * @param *outbox opened outbox.
+ * @return outbox depth.
+ */
+unsigned int Outbox_GetDepth(const Outbox *outbox)
+{
+	return outbox->header != NULL ? outbox->header->tail - outbox->header->head : 0;
+}
+
+/**
+ * @brief Write the mapping back to disk and unmap it.
+ * @param *outbox outbox to close.
+ */
+void Outbox_Close(Outbox *outbox)
+{
+	if (outbox->header != NULL)
+	{
+		msync(outbox->header, outbox->mapSize, MS_SYNC);
+		munmap(outbox->header, outbox->mapSize);
+		outbox->header = NULL;
+		outbox->slots = NULL;
+	}
+
+	if (outbox->fd >= 0)
+	{
+		close(outbox->fd);
+		outbox->fd = -1;
+	}
+}
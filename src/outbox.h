@@ -0,0 +1,184 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file outbox.h
+ * @brief Header file for the store-and-forward outbox of Flow payloads, kept in a fixed-size ring
+ *        file mapped into memory so pending payloads survive a daemon restart.
+ */
+
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! @cond Doxygen_Suppress
+#define OUTBOX_FILE				"/var/lib/button_gateway/flow_outbox"
+#define OUTBOX_CAPACITY			(256)
+#define OUTBOX_MAX_CAPACITY		(65536)
+#define OUTBOX_RETENTION		(86400)
+#define OUTBOX_PAYLOAD_SIZE		(120)
+#define OUTBOX_PATH_SIZE		(128)
+//! @endcond
+
+/** Payload has to be sent to the user with SendMessage. */
+#define OUTBOX_MESSAGE		(1u << 0)
+/** Payload has to be published to the device topic with PublishStatus. */
+#define OUTBOX_STATUS		(1u << 1)
+
+/**
+ * What to do with a new payload when the ring is full.
+ */
+typedef enum
+{
+	OutboxOverflow_DropOldest, /**< discard the oldest pending payload to make room */
+	OutboxOverflow_DropNewest /**< keep the ring as is and discard the new payload */
+}OutboxOverflow;
+
+/**
+ * A structure to contain outbox configuration.
+ */
+typedef struct
+{
+	/*@{*/
+	char file[OUTBOX_PATH_SIZE]; /**< ring file */
+	unsigned int capacity; /**< number of payloads the ring holds */
+	OutboxOverflow overflow; /**< overflow policy */
+	unsigned int retention; /**< seconds a payload is kept before it is discarded, 0 for ever */
+	/*@}*/
+}OutboxConfig;
+
+/**
+ * Ring file header, followed by capacity slots.
+ */
+typedef struct
+{
+	/*@{*/
+	uint32_t magic; /**< identifies an outbox file */
+	uint32_t version; /**< file layout version */
+	uint32_t capacity; /**< number of slots */
+	uint32_t slotSize; /**< size of one slot */
+	uint64_t head; /**< sequence of the oldest pending slot */
+	uint64_t tail; /**< sequence of the next slot to fill */
+	uint64_t dropped; /**< payloads discarded by the overflow policy */
+	uint64_t expired; /**< payloads discarded by retention */
+	/*@}*/
+}OutboxHeader;
+
+/**
+ * One pending payload.
+ */
+typedef struct
+{
+	/*@{*/
+	uint32_t pending; /**< OUTBOX_MESSAGE and OUTBOX_STATUS sends still to do */
+	uint32_t length; /**< payload length, without terminator */
+	int64_t created; /**< wall clock time the payload was queued */
+	char payload[OUTBOX_PAYLOAD_SIZE]; /**< nul terminated payload */
+	/*@}*/
+}OutboxSlot;
+
+/**
+ * A structure to contain an opened outbox.
+ */
+typedef struct
+{
+	/*@{*/
+	OutboxConfig config; /**< configuration the outbox was opened with */
+	int fd; /**< ring file, -1 when closed */
+	OutboxHeader *header; /**< mapped file header */
+	OutboxSlot *slots; /**< mapped slots */
+	size_t mapSize; /**< size of the mapping */
+	/*@}*/
+}Outbox;
+
+/**
+ * @brief Send callback used when draining, performs the sends flagged in pending.
+ * @param *payload nul terminated payload.
+ * @param pending OUTBOX_MESSAGE and OUTBOX_STATUS sends to do.
+ * @param *context context given to Outbox_Drain.
+ * @return sends which still have to be done, 0 if all succeeded.
+ */
+typedef uint32_t (*OutboxSender)(const char *payload, uint32_t pending, void *context);
+
+/**
+ * @brief Fill configuration with defaults, then override them from the "outbox" group of a
+ *        libconfig file if there is one.
+ * @param *config configuration to fill.
+ * @param *file configuration file, may not exist.
+ * @return true if configuration is usable, else false.
+ */
+bool Outbox_LoadConfig(OutboxConfig *config, const char *file);
+
+/**
+ * @brief Map the ring file, creating it if it doesn't exist or doesn't match the configured
+ *        capacity. Pending payloads of a matching file are kept.
+ * @param *outbox outbox to open.
+ * @param *config outbox configuration.
+ * @return true if outbox is ready, else false.
+ */
+bool Outbox_Open(Outbox *outbox, const OutboxConfig *config);
+
+/**
+ * @brief Queue a payload. Nothing is flushed to disk here, the mapping is written back by the
+ *        kernel and on every drained batch.
+ * @param *outbox opened outbox.
+ * @param *payload nul terminated payload, truncated to OUTBOX_PAYLOAD_SIZE - 1.
+ * @param pending OUTBOX_MESSAGE and OUTBOX_STATUS sends to do.
+ * @return true if queued without discarding anything, else false.
+ */
+bool Outbox_Push(Outbox *outbox, const char *payload, uint32_t pending);
+
+/**
+ * @brief Send pending payloads oldest first, stopping at the first one which can't be fully sent.
+ *        Payloads past retention are discarded unsent.
+ * @param *outbox opened outbox.
+ * @param send callback doing the sends.
+ * @param *context passed to send.
+ * @param maxBatch maximum number of payloads to send.
+ * @return number of payloads fully sent.
+ */
+unsigned int Outbox_Drain(Outbox *outbox, OutboxSender send, void *context, unsigned int maxBatch);
+
+/**
+ * @brief Get number of pending payloads.
+ * @param *outbox opened outbox.
+ * @return outbox depth.
+ */
+unsigned int Outbox_GetDepth(const Outbox *outbox);
+
+/**
+ * @brief Write the mapping back to disk and unmap it.
+ * @param *outbox outbox to close.
+ */
+void Outbox_Close(Outbox *outbox);
+
+#endif	/* OUTBOX_H */
@@ -0,0 +1,619 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file reactor.c
+ * @brief Event loop built on epoll, timerfd and eventfd.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <limits.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+
+#include "reactor.h"
+#include "log.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define PROC_SELF_FD		"/proc/self/fd"
+#define MS_PER_SECOND		(1000)
+#define NS_PER_MS			(1000000)
+#define DIRECTORY_SIZE		(256)
+#define INOTIFY_BUFFER_SIZE	(sizeof(struct inotify_event) + NAME_MAX + 1)
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Find the slot watching fd.
+ * @param *reactor event loop.
+ * @param fd descriptor to look for, -1 finds a free slot.
+ * @return slot, or NULL if not found.
+ */
+static ReactorSource *FindSource(Reactor *reactor, int fd)
+{
+	int i;
+
+	for (i = 0; i < REACTOR_MAX_SOURCES; i++)
+	{
+		if (reactor->sources[i].fd == fd)
+		{
+			return &reactor->sources[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Register a descriptor of the given kind with epoll.
+ * @param *reactor event loop.
+ * @param fd descriptor to watch.
+ * @param type kind of descriptor.
+ * @param callback called when descriptor is ready.
+ * @param *context passed to callback.
+ * @return true on success, else false.
+ */
+static bool AddSource(Reactor *reactor, int fd, ReactorSourceType type,
+		ReactorCallback callback, void *context)
+{
+	struct epoll_event event;
+	ReactorSource *source = FindSource(reactor, -1);
+
+	if (source == NULL)
+	{
+		LOG(LOG_ERR, "Too many reactor sources");
+		return false;
+	}
+
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.ptr = source;
+
+	if (epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+	{
+		LOG(LOG_ERR, "epoll_ctl() failed for fd %d: %s", fd, strerror(errno));
+		return false;
+	}
+
+	source->fd = fd;
+	source->type = type;
+	source->callback = callback;
+	source->context = context;
+	source->name = NULL;
+	return true;
+}
+
+/**
+ * @brief Create the epoll instance.
+ * @param *reactor loop to initialize.
+ * @return true on success, else false.
+ */
+bool Reactor_Init(Reactor *reactor)
+{
+	int i;
+
+	memset(reactor, 0, sizeof(*reactor));
+	for (i = 0; i < REACTOR_MAX_SOURCES; i++)
+	{
+		reactor->sources[i].fd = -1;
+	}
+
+	reactor->epollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (reactor->epollFd < 0)
+	{
+		LOG(LOG_ERR, "epoll_create1() failed: %s", strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Close the epoll instance and every timer and notifier created by the reactor.
+ * @param *reactor loop to destroy.
+ */
+void Reactor_Destroy(Reactor *reactor)
+{
+	int i;
+
+	for (i = 0; i < REACTOR_MAX_SOURCES; i++)
+	{
+		if (reactor->sources[i].fd >= 0 && reactor->sources[i].type != ReactorSource_Fd)
+		{
+			close(reactor->sources[i].fd);
+		}
+		reactor->sources[i].fd = -1;
+	}
+
+	if (reactor->epollFd >= 0)
+	{
+		close(reactor->epollFd);
+		reactor->epollFd = -1;
+	}
+}
+
+/**
+ * @brief Watch a descriptor for input.
+ * @param *reactor event loop.
+ * @param fd descriptor to watch.
+ * @param callback called when descriptor is readable.
+ * @param *context passed to callback.
+ * @return true on success, else false.
+ */
+bool Reactor_AddFd(Reactor *reactor, int fd, ReactorCallback callback, void *context)
+{
+	return AddSource(reactor, fd, ReactorSource_Fd, callback, context);
+}
+
+/**
+ * @brief Stop watching a descriptor. The descriptor is not closed.
+ * @param *reactor event loop.
+ * @param fd descriptor to remove.
+ */
+void Reactor_RemoveFd(Reactor *reactor, int fd)
+{
+	ReactorSource *source = FindSource(reactor, fd);
+
+	if (source != NULL && fd >= 0)
+	{
+		epoll_ctl(reactor->epollFd, EPOLL_CTL_DEL, fd, NULL);
+		source->fd = -1;
+	}
+}
+
+/**
+ * @brief Re-arm or disarm a timer created by Reactor_AddTimer.
+ * @param timerFd timer descriptor.
+ * @param initialMs delay before first expiry in milliseconds, 0 disarms timer.
+ * @param intervalMs period in milliseconds, 0 for one shot.
+ * @return true on success, else false.
+ */
+bool Reactor_ArmTimer(int timerFd, unsigned int initialMs, unsigned int intervalMs)
+{
+	struct itimerspec spec;
+
+	spec.it_value.tv_sec = initialMs / MS_PER_SECOND;
+	spec.it_value.tv_nsec = (initialMs % MS_PER_SECOND) * NS_PER_MS;
+	spec.it_interval.tv_sec = intervalMs / MS_PER_SECOND;
+	spec.it_interval.tv_nsec = (intervalMs % MS_PER_SECOND) * NS_PER_MS;
+
+	if (timerfd_settime(timerFd, 0, &spec, NULL) != 0)
+	{
+		LOG(LOG_ERR, "timerfd_settime() failed: %s", strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Create a timer owned by the reactor.
+ * @param *reactor event loop.
+ * @param initialMs delay before first expiry in milliseconds, 0 leaves timer disarmed.
+ * @param intervalMs period in milliseconds, 0 for one shot.
+ * @param callback called on expiry.
+ * @param *context passed to callback.
+ * @return timer descriptor, or -1 on failure.
+ */
+int Reactor_AddTimer(Reactor *reactor, unsigned int initialMs, unsigned int intervalMs,
+		ReactorCallback callback, void *context)
+{
+	int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+	if (fd < 0)
+	{
+		LOG(LOG_ERR, "timerfd_create() failed: %s", strerror(errno));
+		return -1;
+	}
+
+	if (!Reactor_ArmTimer(fd, initialMs, intervalMs) ||
+		!AddSource(reactor, fd, ReactorSource_Timer, callback, context))
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/**
+ * @brief Create a notifier used to wake the loop when an internal queue gets work.
+ * @param *reactor event loop.
+ * @param callback called after Reactor_Notify.
+ * @param *context passed to callback.
+ * @return notifier descriptor, or -1 on failure.
+ */
+int Reactor_AddNotifier(Reactor *reactor, ReactorCallback callback, void *context)
+{
+	int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+	if (fd < 0)
+	{
+		LOG(LOG_ERR, "eventfd() failed: %s", strerror(errno));
+		return -1;
+	}
+
+	if (!AddSource(reactor, fd, ReactorSource_Notifier, callback, context))
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/**
+ * @brief Wake the loop for a notifier. Safe to call from any thread.
+ * @param notifierFd notifier descriptor.
+ */
+void Reactor_Notify(int notifierFd)
+{
+	uint64_t one = 1;
+
+	if (notifierFd >= 0 && write(notifierFd, &one, sizeof(one)) != sizeof(one) && errno != EAGAIN)
+	{
+		LOG(LOG_WARN, "Failed to notify reactor: %s", strerror(errno));
+	}
+}
+
+/**
+ * @brief Watch a file for being written or moved into place. The file's directory is watched,
+ *        so the file doesn't need to exist yet.
+ * @param *reactor event loop.
+ * @param *file path of the file, must stay valid while watched.
+ * @param callback called after the file was written or replaced.
+ * @param *context passed to callback.
+ * @return inotify descriptor, or -1 on failure.
+ */
+int Reactor_AddFileWatch(Reactor *reactor, const char *file, ReactorCallback callback,
+		void *context)
+{
+	char directory[DIRECTORY_SIZE];
+	const char *name = strrchr(file, '/');
+	int fd;
+
+	if (name == NULL || (size_t)(name - file) >= sizeof(directory))
+	{
+		LOG(LOG_ERR, "Can't watch %s, an absolute path is needed", file);
+		return -1;
+	}
+	memcpy(directory, file, name - file);
+	directory[name - file] = '\0';
+
+	fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd < 0)
+	{
+		LOG(LOG_ERR, "inotify_init1() failed: %s", strerror(errno));
+		return -1;
+	}
+
+	if (inotify_add_watch(fd, directory[0] ? directory : "/", IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		LOG(LOG_ERR, "Failed to watch %s: %s", directory, strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	if (!AddSource(reactor, fd, ReactorSource_FileWatch, callback, context))
+	{
+		close(fd);
+		return -1;
+	}
+	FindSource(reactor, fd)->name = name + 1;
+	return fd;
+}
+
+/**
+ * @brief Read every pending inotify event of a file watch.
+ * @param *source file watch.
+ * @return true if any event was about the watched file, else false.
+ */
+static bool ReadFileWatch(const ReactorSource *source)
+{
+	char buffer[INOTIFY_BUFFER_SIZE * 4]
+			__attribute__((aligned(__alignof__(struct inotify_event))));
+	bool matched = false;
+	ssize_t length;
+
+	while ((length = read(source->fd, buffer, sizeof(buffer))) > 0)
+	{
+		char *next = buffer;
+
+		while (next < buffer + length)
+		{
+			const struct inotify_event *event = (const struct inotify_event *)next;
+
+			if (event->len > 0 && strcmp(event->name, source->name) == 0)
+			{
+				matched = true;
+			}
+			next += sizeof(struct inotify_event) + event->len;
+		}
+	}
+	return matched;
+}
+
+/**
+ * @brief Block a signal in the calling thread, so it is only delivered through
+ *        Reactor_AddSignal. Threads started afterwards inherit the blocked signal, so this must be
+ *        called before any other thread is started.
+ * @param signal signal to block.
+ * @return true on success, else false.
+ */
+bool Reactor_BlockSignal(int signal)
+{
+	sigset_t mask;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, signal);
+	if (pthread_sigmask(SIG_BLOCK, &mask, NULL) != 0)
+	{
+		LOG(LOG_ERR, "Failed to block signal %d", signal);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Handle a signal in the loop rather than in a signal handler. The signal must be blocked
+ *        with Reactor_BlockSignal.
+ * @param *reactor event loop.
+ * @param signal signal to handle.
+ * @param callback called after the signal was received.
+ * @param *context passed to callback.
+ * @return signal descriptor, or -1 on failure.
+ */
+int Reactor_AddSignal(Reactor *reactor, int signal, ReactorCallback callback, void *context)
+{
+	sigset_t mask;
+	int fd;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, signal);
+	fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (fd < 0)
+	{
+		LOG(LOG_ERR, "signalfd() failed: %s", strerror(errno));
+		return -1;
+	}
+
+	if (!AddSource(reactor, fd, ReactorSource_Signal, callback, context))
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/**
+ * @brief Read every pending signal of a signal source.
+ * @param *source signal source.
+ * @return true if a signal was pending, else false.
+ */
+static bool ReadSignals(const ReactorSource *source)
+{
+	struct signalfd_siginfo info;
+	bool received = false;
+
+	while (read(source->fd, &info, sizeof(info)) == sizeof(info))
+	{
+		received = true;
+	}
+	return received;
+}
+
+/**
+ * @brief Wait for ready sources and run their callbacks once.
+ * @param *reactor event loop.
+ * @param timeoutMs maximum wait in milliseconds, -1 to wait forever.
+ * @return number of callbacks run, or -1 on failure.
+ */
+int Reactor_RunOnce(Reactor *reactor, int timeoutMs)
+{
+	struct epoll_event events[REACTOR_MAX_EVENTS];
+	int count, i;
+
+	count = epoll_wait(reactor->epollFd, events, REACTOR_MAX_EVENTS, timeoutMs);
+	if (count < 0)
+	{
+		if (errno == EINTR)
+		{
+			return 0;
+		}
+		LOG(LOG_ERR, "epoll_wait() failed: %s", strerror(errno));
+		return -1;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		ReactorSource *source = events[i].data.ptr;
+		uint64_t value;
+
+		/* Source may have been removed by an earlier callback in this pass */
+		if (source->fd < 0)
+		{
+			continue;
+		}
+
+		if (source->type == ReactorSource_FileWatch)
+		{
+			if (!ReadFileWatch(source))
+			{
+				continue;
+			}
+		}
+		else if (source->type == ReactorSource_Signal)
+		{
+			if (!ReadSignals(source))
+			{
+				continue;
+			}
+		}
+		else if (source->type != ReactorSource_Fd)
+		{
+			if (read(source->fd, &value, sizeof(value)) != sizeof(value))
+			{
+				continue;
+			}
+		}
+		source->callback(source->fd, events[i].events, source->context);
+	}
+	return count;
+}
+
+/**
+ * @brief Run the loop until Reactor_Stop is called or waiting fails.
+ * @param *reactor event loop.
+ * @return true if stopped by Reactor_Stop, false on failure.
+ */
+bool Reactor_Run(Reactor *reactor)
+{
+	reactor->running = true;
+
+	while (reactor->running)
+	{
+		if (Reactor_RunOnce(reactor, -1) < 0)
+		{
+			reactor->running = false;
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Make Reactor_Run return after the current pass.
+ * @param *reactor event loop.
+ */
+void Reactor_Stop(Reactor *reactor)
+{
+	reactor->running = false;
+}
+
+/**
+ * @brief Record the UDP sockets currently open in the process.
+ * @param *snapshot filled with socket descriptors.
+ */
+void Reactor_SnapshotSockets(SocketSnapshot *snapshot)
+{
+	DIR *dir;
+	struct dirent *entry;
+
+	snapshot->count = 0;
+
+	dir = opendir(PROC_SELF_FD);
+	if (dir == NULL)
+	{
+		LOG(LOG_ERR, "Failed to open %s: %s", PROC_SELF_FD, strerror(errno));
+		return;
+	}
+
+	while ((entry = readdir(dir)) != NULL && snapshot->count < SOCKET_SNAPSHOT_SIZE)
+	{
+		struct stat info;
+		int fd, type;
+		socklen_t length = sizeof(type);
+
+		if (entry->d_name[0] == '.')
+		{
+			continue;
+		}
+
+		fd = atoi(entry->d_name);
+		if (fd == dirfd(dir) || fstat(fd, &info) != 0 || !S_ISSOCK(info.st_mode))
+		{
+			continue;
+		}
+
+		/* Awa IPC runs over UDP, this keeps Flow's TCP connections out of the set */
+		if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &length) == 0 && type == SOCK_DGRAM)
+		{
+			snapshot->fds[snapshot->count++] = fd;
+		}
+	}
+	closedir(dir);
+}
+
+/**
+ * @brief Watch every UDP socket opened since snapshot was taken. The Awa API does not expose
+ *        its IPC sockets, so a session's sockets are found by taking a snapshot just before
+ *        connecting it. The snapshot is updated with the added sockets.
+ * @param *reactor event loop.
+ * @param *snapshot sockets open before the session was connected.
+ * @param callback called when any of the new sockets is readable.
+ * @param *context passed to callback.
+ * @return number of sockets added.
+ */
+unsigned int Reactor_AddNewSockets(Reactor *reactor, SocketSnapshot *snapshot,
+		ReactorCallback callback, void *context)
+{
+	SocketSnapshot current;
+	unsigned int i, j, added = 0;
+
+	Reactor_SnapshotSockets(&current);
+
+	for (i = 0; i < current.count; i++)
+	{
+		for (j = 0; j < snapshot->count; j++)
+		{
+			if (snapshot->fds[j] == current.fds[i])
+			{
+				break;
+			}
+		}
+
+		if (j == snapshot->count && FindSource(reactor, current.fds[i]) == NULL)
+		{
+			if (Reactor_AddFd(reactor, current.fds[i], callback, context))
+			{
+				added++;
+			}
+		}
+	}
+
+	*snapshot = current;
+	return added;
+}
@@ -0,0 +1,245 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file reactor.h
+ * @brief Header file for the epoll based event loop. It multiplexes Awa IPC sockets, timers and
+ *        internal queues so the gateway only wakes when there is work to do.
+ */
+
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! @cond Doxygen_Suppress
+#define REACTOR_MAX_SOURCES		(64)
+#define REACTOR_MAX_EVENTS		(16)
+#define SOCKET_SNAPSHOT_SIZE	(64)
+//! @endcond
+
+/**
+ * @brief Called from the loop when a source becomes ready. Timers and notifiers are already
+ *        cleared when this is called.
+ * @param fd ready file descriptor.
+ * @param events epoll events reported for the descriptor.
+ * @param *context pointer passed when the source was added.
+ */
+typedef void (*ReactorCallback)(int fd, uint32_t events, void *context);
+
+/**
+ * Kind of file descriptor watched by the reactor.
+ */
+typedef enum
+{
+	ReactorSource_Fd, /**< plain descriptor, drained by the callback */
+	ReactorSource_Timer, /**< timerfd, expirations read before callback */
+	ReactorSource_Notifier, /**< eventfd, counter read before callback */
+	ReactorSource_FileWatch, /**< inotify on a file's directory, events read before callback */
+	ReactorSource_Signal /**< signalfd, pending signals read before callback */
+}ReactorSourceType;
+
+/**
+ * A structure to contain one watched descriptor.
+ */
+typedef struct
+{
+	/*@{*/
+	int fd; /**< watched descriptor, -1 if slot is free */
+	ReactorSourceType type; /**< kind of descriptor */
+	ReactorCallback callback; /**< called when descriptor is ready */
+	void *context; /**< passed to callback */
+	const char *name; /**< file name within the watched directory, for file watches */
+	/*@}*/
+}ReactorSource;
+
+/**
+ * A structure to contain the event loop.
+ */
+typedef struct
+{
+	/*@{*/
+	int epollFd; /**< epoll instance */
+	ReactorSource sources[REACTOR_MAX_SOURCES]; /**< watched descriptors */
+	bool running; /**< cleared by Reactor_Stop */
+	/*@}*/
+}Reactor;
+
+/**
+ * A structure to contain the set of UDP sockets open in the process at a given time.
+ */
+typedef struct
+{
+	/*@{*/
+	int fds[SOCKET_SNAPSHOT_SIZE]; /**< socket descriptors */
+	unsigned int count; /**< number of descriptors */
+	/*@}*/
+}SocketSnapshot;
+
+/**
+ * @brief Create the epoll instance.
+ * @param *reactor loop to initialize.
+ * @return true on success, else false.
+ */
+bool Reactor_Init(Reactor *reactor);
+
+/**
+ * @brief Close the epoll instance and every timer and notifier created by the reactor.
+ * @param *reactor loop to destroy.
+ */
+void Reactor_Destroy(Reactor *reactor);
+
+/**
+ * @brief Watch a descriptor for input.
+ * @param *reactor event loop.
+ * @param fd descriptor to watch.
+ * @param callback called when descriptor is readable.
+ * @param *context passed to callback.
+ * @return true on success, else false.
+ */
+bool Reactor_AddFd(Reactor *reactor, int fd, ReactorCallback callback, void *context);
+
+/**
+ * @brief Stop watching a descriptor. The descriptor is not closed.
+ * @param *reactor event loop.
+ * @param fd descriptor to remove.
+ */
+void Reactor_RemoveFd(Reactor *reactor, int fd);
+
+/**
+ * @brief Create a timer owned by the reactor.
+ * @param *reactor event loop.
+ * @param initialMs delay before first expiry in milliseconds, 0 leaves timer disarmed.
+ * @param intervalMs period in milliseconds, 0 for one shot.
+ * @param callback called on expiry.
+ * @param *context passed to callback.
+ * @return timer descriptor, or -1 on failure.
+ */
+int Reactor_AddTimer(Reactor *reactor, unsigned int initialMs, unsigned int intervalMs,
+		ReactorCallback callback, void *context);
+
+/**
+ * @brief Re-arm or disarm a timer created by Reactor_AddTimer.
+ * @param timerFd timer descriptor.
+ * @param initialMs delay before first expiry in milliseconds, 0 disarms timer.
+ * @param intervalMs period in milliseconds, 0 for one shot.
+ * @return true on success, else false.
+ */
+bool Reactor_ArmTimer(int timerFd, unsigned int initialMs, unsigned int intervalMs);
+
+/**
+ * @brief Create a notifier used to wake the loop when an internal queue gets work.
+ * @param *reactor event loop.
+ * @param callback called after Reactor_Notify.
+ * @param *context passed to callback.
+ * @return notifier descriptor, or -1 on failure.
+ */
+int Reactor_AddNotifier(Reactor *reactor, ReactorCallback callback, void *context);
+
+/**
+ * @brief Wake the loop for a notifier. Safe to call from any thread.
+ * @param notifierFd notifier descriptor.
+ */
+void Reactor_Notify(int notifierFd);
+
+/**
+ * @brief Watch a file for being written or moved into place. The file's directory is watched,
+ *        so the file doesn't need to exist yet.
+ * @param *reactor event loop.
+ * @param *file path of the file, must stay valid while watched.
+ * @param callback called after the file was written or replaced.
+ * @param *context passed to callback.
+ * @return inotify descriptor, or -1 on failure.
+ */
+int Reactor_AddFileWatch(Reactor *reactor, const char *file, ReactorCallback callback,
+		void *context);
+
+/**
+ * @brief Block a signal in the calling thread, so it is only delivered through
+ *        Reactor_AddSignal. Threads started afterwards inherit the blocked signal, so this must be
+ *        called before any other thread is started.
+ * @param signal signal to block.
+ * @return true on success, else false.
+ */
+bool Reactor_BlockSignal(int signal);
+
+/**
+ * @brief Handle a signal in the loop rather than in a signal handler. The signal must be blocked
+ *        with Reactor_BlockSignal.
+ * @param *reactor event loop.
+ * @param signal signal to handle.
+ * @param callback called after the signal was received.
+ * @param *context passed to callback.
+ * @return signal descriptor, or -1 on failure.
+ */
+int Reactor_AddSignal(Reactor *reactor, int signal, ReactorCallback callback, void *context);
+
+/**
+ * @brief Wait for ready sources and run their callbacks once.
+ * @param *reactor event loop.
+ * @param timeoutMs maximum wait in milliseconds, -1 to wait forever.
+ * @return number of callbacks run, or -1 on failure.
+ */
+int Reactor_RunOnce(Reactor *reactor, int timeoutMs);
+
+/**
+ * @brief Run the loop until Reactor_Stop is called or waiting fails.
+ * @param *reactor event loop.
+ * @return true if stopped by Reactor_Stop, false on failure.
+ */
+bool Reactor_Run(Reactor *reactor);
+
+/**
+ * @brief Make Reactor_Run return after the current pass.
+ * @param *reactor event loop.
+ */
+void Reactor_Stop(Reactor *reactor);
+
+/**
+ * @brief Record the UDP sockets currently open in the process.
+ * @param *snapshot filled with socket descriptors.
+ */
+void Reactor_SnapshotSockets(SocketSnapshot *snapshot);
+
+/**
+ * @brief Watch every UDP socket opened since snapshot was taken. The Awa API does not expose
+ *        its IPC sockets, so a session's sockets are found by taking a snapshot just before
+ *        connecting it. The snapshot is updated with the added sockets.
+ * @param *reactor event loop.
+ * @param *snapshot sockets open before the session was connected.
+ * @param callback called when any of the new sockets is readable.
+ * @param *context passed to callback.
+ * @return number of sockets added.
+ */
+unsigned int Reactor_AddNewSockets(Reactor *reactor, SocketSnapshot *snapshot,
+		ReactorCallback callback, void *context);
+
+#endif	/* REACTOR_H */
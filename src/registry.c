@@ -0,0 +1,239 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file registry.c
+ * @brief Registration cache of the constrained devices used by bindings.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "registry.h"
+#include "log.h"
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Create an unregistered endpoint for every device used by bindings.
+ * @param *registry registry to initialize.
+ * @param *table bindings, must outlive the registry.
+ * @return true on success, else false.
+ */
+bool Registry_Init(Registry *registry, const BindingTable *table)
+{
+	unsigned int i, buttonsUsed = 0, ledsUsed = 0;
+	Endpoint *endpoint;
+
+	memset(registry, 0, sizeof(*registry));
+
+	registry->endpoints = calloc(table->numEndpoints, sizeof(*registry->endpoints));
+	registry->buttonPool = calloc(table->numBindings, sizeof(*registry->buttonPool));
+	registry->ledPool = calloc(table->numLeds, sizeof(*registry->ledPool));
+	registry->pendingList = calloc(table->numEndpoints, sizeof(*registry->pendingList));
+	if (registry->endpoints == NULL || registry->buttonPool == NULL || registry->ledPool == NULL ||
+		registry->pendingList == NULL || !HashTable_Init(&registry->index, table->numEndpoints))
+	{
+		LOG(LOG_ERR, "Failed to allocate registry");
+		Registry_Free(registry);
+		return false;
+	}
+
+	for (i = 0; i < table->numEndpoints; i++)
+	{
+		endpoint = &registry->endpoints[i];
+		endpoint->name = table->endpoints[i];
+		Rtt_Init(&endpoint->rtt);
+		Breaker_Init(&endpoint->breaker);
+		if (!HashTable_Put(&registry->index, endpoint->name, NULL, endpoint))
+		{
+			Registry_Free(registry);
+			return false;
+		}
+	}
+	registry->numEndpoints = table->numEndpoints;
+
+	/* Count first so each endpoint gets a contiguous slice of the pools */
+	for (i = 0; i < table->numBindings; i++)
+	{
+		Registry_Find(registry, table->bindings[i].clientID)->numButtons++;
+	}
+	for (i = 0; i < table->numLeds; i++)
+	{
+		Registry_Find(registry, table->leds[i].clientID)->numLeds++;
+	}
+
+	for (i = 0; i < registry->numEndpoints; i++)
+	{
+		endpoint = &registry->endpoints[i];
+		endpoint->buttons = &registry->buttonPool[buttonsUsed];
+		endpoint->leds = &registry->ledPool[ledsUsed];
+		buttonsUsed += endpoint->numButtons;
+		ledsUsed += endpoint->numLeds;
+		endpoint->numButtons = 0;
+		endpoint->numLeds = 0;
+	}
+
+	for (i = 0; i < table->numBindings; i++)
+	{
+		endpoint = Registry_Find(registry, table->bindings[i].clientID);
+		endpoint->buttons[endpoint->numButtons++] = &table->bindings[i];
+	}
+	for (i = 0; i < table->numLeds; i++)
+	{
+		endpoint = Registry_Find(registry, table->leds[i].clientID);
+		endpoint->leds[endpoint->numLeds++] = &table->leds[i];
+	}
+	return true;
+}
+
+/**
+ * @brief Find a tracked endpoint.
+ * @param *registry registry.
+ * @param *name endpoint name.
+ * @return endpoint, or NULL if no binding uses it.
+ */
+Endpoint *Registry_Find(const Registry *registry, const char *name)
+{
+	return HashTable_Get(&registry->index, name, NULL);
+}
+
+/**
+ * @brief Record a register or update. A registration, or an update from a device that was not
+ *        known to be registered, marks the endpoint pending, since its observations and led
+ *        state must be restored.
+ * @param *registry registry.
+ * @param *name endpoint name.
+ * @param isRegister true for a register event, false for an update or a listed client.
+ * @return endpoint if it became pending, else NULL.
+ */
+Endpoint *Registry_SetRegistered(Registry *registry, const char *name, bool isRegister)
+{
+	Endpoint *endpoint = Registry_Find(registry, name);
+
+	if (endpoint == NULL)
+	{
+		return NULL;
+	}
+
+	if (!endpoint->registered || isRegister)
+	{
+		LOG(LOG_INFO, "Constrained device %s registered", name);
+		if (!endpoint->registered)
+		{
+			endpoint->registered = true;
+			registry->numRegistered++;
+		}
+		/* A device registering again has lost any observation made before */
+		endpoint->observed = false;
+		endpoint->registrations++;
+		if (!endpoint->pending)
+		{
+			endpoint->pending = true;
+			registry->pendingList[registry->numPending++] = endpoint;
+		}
+		return endpoint;
+	}
+
+	/* An update from a device whose observations failed earlier is another chance */
+	if (!endpoint->observed && endpoint->numButtons > 0 && !endpoint->pending)
+	{
+		endpoint->pending = true;
+		registry->pendingList[registry->numPending++] = endpoint;
+		return endpoint;
+	}
+	return NULL;
+}
+
+/**
+ * @brief Record a deregistration. Observations of the device are lost with it.
+ * @param *registry registry.
+ * @param *name endpoint name.
+ * @return endpoint, or NULL if not tracked.
+ */
+Endpoint *Registry_SetDeregistered(Registry *registry, const char *name)
+{
+	Endpoint *endpoint = Registry_Find(registry, name);
+
+	if (endpoint != NULL && endpoint->registered)
+	{
+		LOG(LOG_INFO, "Constrained device %s deregistered", name);
+		endpoint->registered = false;
+		endpoint->observed = false;
+		registry->numRegistered--;
+	}
+	return endpoint;
+}
+
+/**
+ * @brief Take the next endpoint waiting to be synchronised.
+ * @param *registry registry.
+ * @return endpoint, or NULL if none is pending.
+ */
+Endpoint *Registry_PopPending(Registry *registry)
+{
+	Endpoint *endpoint;
+
+	if (registry->numPending == 0)
+	{
+		return NULL;
+	}
+
+	endpoint = registry->pendingList[--registry->numPending];
+	endpoint->pending = false;
+	return endpoint;
+}
+
+/**
+ * @brief Free all endpoints.
+ * @param *registry registry to free.
+ */
+void Registry_Free(Registry *registry)
+{
+	unsigned int i;
+
+	for (i = 0; i < registry->numEndpoints; i++)
+	{
+		Rtt_Destroy(&registry->endpoints[i].rtt);
+		Breaker_Destroy(&registry->endpoints[i].breaker);
+	}
+	HashTable_Destroy(&registry->index);
+	free(registry->endpoints);
+	free(registry->buttonPool);
+	free(registry->ledPool);
+	free(registry->pendingList);
+	memset(registry, 0, sizeof(*registry));
+}
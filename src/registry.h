@@ -0,0 +1,133 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file registry.h
+ * @brief Header file for the registration cache of constrained devices used by bindings. It is
+ *        kept current from the Awa server's client register, update and deregister events, so
+ *        registration checks are a hash lookup instead of a client list round trip.
+ */
+
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <stdbool.h>
+
+#include "bindings.h"
+#include "hash_table.h"
+#include "rtt.h"
+#include "breaker.h"
+
+/**
+ * A structure to contain registration state of one constrained device.
+ */
+typedef struct
+{
+	/*@{*/
+	const char *name; /**< endpoint name, owned by the binding table */
+	bool registered; /**< true while device is registered with the server daemon */
+	bool observed; /**< true once button observations of device are in place */
+	bool pending; /**< registration seen that has not been synchronised yet */
+	unsigned long registrations; /**< number of registrations seen */
+	Binding **buttons; /**< bindings whose button is on this device */
+	unsigned int numButtons; /**< number of buttons */
+	LedTarget **leds; /**< leds on this device */
+	unsigned int numLeds; /**< number of leds */
+	RttEstimator rtt; /**< round trip time of operations on the device, shared by workers */
+	Breaker breaker; /**< fails led writes fast while the device is unreachable */
+	/*@}*/
+}Endpoint;
+
+/**
+ * A structure to contain all tracked endpoints.
+ */
+typedef struct
+{
+	/*@{*/
+	Endpoint *endpoints; /**< endpoints used by bindings */
+	unsigned int numEndpoints; /**< number of endpoints */
+	unsigned int numRegistered; /**< number of endpoints currently registered */
+	Endpoint **pendingList; /**< endpoints waiting to be synchronised */
+	unsigned int numPending; /**< number of pending endpoints */
+	Binding **buttonPool; /**< storage for per endpoint button lists */
+	LedTarget **ledPool; /**< storage for per endpoint led lists */
+	HashTable index; /**< endpoint name to Endpoint */
+	/*@}*/
+}Registry;
+
+/**
+ * @brief Create an unregistered endpoint for every device used by bindings.
+ * @param *registry registry to initialize.
+ * @param *table bindings, must outlive the registry.
+ * @return true on success, else false.
+ */
+bool Registry_Init(Registry *registry, const BindingTable *table);
+
+/**
+ * @brief Find a tracked endpoint.
+ * @param *registry registry.
+ * @param *name endpoint name.
+ * @return endpoint, or NULL if no binding uses it.
+ */
+Endpoint *Registry_Find(const Registry *registry, const char *name);
+
+/**
+ * @brief Record a register or update. A registration, or an update from a device that was not
+ *        known to be registered, marks the endpoint pending, since its observations and led
+ *        state must be restored.
+ * @param *registry registry.
+ * @param *name endpoint name.
+ * @param isRegister true for a register event, false for an update or a listed client.
+ * @return endpoint if it became pending, else NULL.
+ */
+Endpoint *Registry_SetRegistered(Registry *registry, const char *name, bool isRegister);
+
+/**
+ * @brief Record a deregistration. Observations of the device are lost with it.
+ * @param *registry registry.
+ * @param *name endpoint name.
+ * @return endpoint, or NULL if not tracked.
+ */
+Endpoint *Registry_SetDeregistered(Registry *registry, const char *name);
+
+/**
+ * @brief Take the next endpoint waiting to be synchronised.
+ * @param *registry registry.
+ * @return endpoint, or NULL if none is pending.
+ */
+Endpoint *Registry_PopPending(Registry *registry);
+
+/**
+ * @brief Free all endpoints.
+ * @param *registry registry to free.
+ */
+void Registry_Free(Registry *registry);
+
+#endif	/* REGISTRY_H */
@@ -0,0 +1,265 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file rtt.c
+ * @brief Per device round trip time estimation and adaptive operation timeouts, following the
+ *        retransmission timer of RFC 6298: the smoothed round trip time and its variation are
+ *        updated with gains of 1/8 and 1/4, the timeout is the smoothed time plus four times the
+ *        variation, and every timeout doubles it until the device answers again.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <libconfig.h>
+
+#include "rtt.h"
+#include "log.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define US_PER_SECOND	(1000000)
+#define US_PER_MS		(1000)
+#define NS_PER_US		(1000)
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Fill configuration with defaults, then override them from the "timeouts" group of a
+ *        libconfig file if there is one.
+ * @param *config configuration to fill.
+ * @param *file configuration file, may not exist.
+ * @return true if configuration is usable, else false and config holds the defaults.
+ */
+bool Rtt_LoadConfig(RttConfig *config, const char *file)
+{
+	config_t cfg;
+	config_setting_t *group;
+	int value;
+	bool success = true;
+
+	config->floorMs = RTT_FLOOR;
+	config->ceilingMs = RTT_CEILING;
+
+	if (access(file, F_OK) != 0)
+	{
+		return true;
+	}
+
+	config_init(&cfg);
+	if (!config_read_file(&cfg, file))
+	{
+		LOG(LOG_ERR, "Failed to parse %s:%d: %s",
+				file, config_error_line(&cfg), config_error_text(&cfg));
+		success = false;
+	}
+	else if ((group = config_lookup(&cfg, "timeouts")) != NULL)
+	{
+		if (config_setting_lookup_int(group, "floor", &value))
+		{
+			if (value <= 0)
+			{
+				LOG(LOG_ERR, "Timeout floor must be positive");
+				success = false;
+			}
+			config->floorMs = value;
+		}
+
+		if (config_setting_lookup_int(group, "ceiling", &value))
+		{
+			if (value <= 0)
+			{
+				LOG(LOG_ERR, "Timeout ceiling must be positive");
+				success = false;
+			}
+			config->ceilingMs = value;
+		}
+
+		if (config->floorMs > config->ceilingMs)
+		{
+			LOG(LOG_ERR, "Timeout floor %u ms is above ceiling %u ms",
+					config->floorMs, config->ceilingMs);
+			success = false;
+		}
+	}
+	config_destroy(&cfg);
+
+	if (!success)
+	{
+		config->floorMs = RTT_FLOOR;
+		config->ceilingMs = RTT_CEILING;
+	}
+	return success;
+}
+
+/**
+ * @brief Start an estimate without any measurement.
+ * @param *estimator estimate to initialize.
+ */
+void Rtt_Init(RttEstimator *estimator)
+{
+	memset(estimator, 0, sizeof(*estimator));
+	pthread_mutex_init(&estimator->lock, NULL);
+}
+
+/**
+ * @brief Free an estimate.
+ * @param *estimator estimate to destroy.
+ */
+void Rtt_Destroy(RttEstimator *estimator)
+{
+	pthread_mutex_destroy(&estimator->lock);
+}
+
+/**
+ * @brief Add the round trip time of an operation the device answered. Safe to call from any
+ *        thread.
+ * @param *estimator estimate of the device.
+ * @param *start monotonic time the operation was started.
+ */
+void Rtt_Sample(RttEstimator *estimator, const struct timespec *start)
+{
+	struct timespec now;
+	uint64_t rttUs;
+	uint64_t errorUs;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	rttUs = (uint64_t)(now.tv_sec - start->tv_sec) * US_PER_SECOND +
+			(now.tv_nsec - start->tv_nsec) / NS_PER_US;
+
+	pthread_mutex_lock(&estimator->lock);
+	if (estimator->samples == 0)
+	{
+		estimator->srttUs = rttUs;
+		estimator->rttvarUs = rttUs / 2;
+	}
+	else
+	{
+		errorUs = rttUs > estimator->srttUs ? rttUs - estimator->srttUs :
+				estimator->srttUs - rttUs;
+		estimator->rttvarUs = estimator->rttvarUs - estimator->rttvarUs / 4 + errorUs / 4;
+		estimator->srttUs = estimator->srttUs - estimator->srttUs / 8 + rttUs / 8;
+	}
+	estimator->lastUs = rttUs;
+	estimator->backoff = 0;
+	estimator->samples++;
+	pthread_mutex_unlock(&estimator->lock);
+}
+
+/**
+ * @brief Record an operation that timed out, which doubles the timeout until the device answers
+ *        again. Safe to call from any thread.
+ * @param *estimator estimate of the device.
+ */
+void Rtt_Timeout(RttEstimator *estimator)
+{
+	pthread_mutex_lock(&estimator->lock);
+	if (estimator->backoff < RTT_MAX_BACKOFF)
+	{
+		estimator->backoff++;
+	}
+	estimator->timeouts++;
+	pthread_mutex_unlock(&estimator->lock);
+}
+
+/**
+ * @brief Compute the timeout of an estimate.
+ * @param *estimator estimate, locked.
+ * @param *config floor and ceiling of the timeout.
+ * @return timeout in milliseconds.
+ */
+static unsigned int ComputeTimeout(const RttEstimator *estimator, const RttConfig *config)
+{
+	uint64_t timeoutMs;
+
+	/* A device that never answered could be anywhere up to the ceiling */
+	if (estimator->samples == 0)
+	{
+		return config->ceilingMs;
+	}
+
+	timeoutMs = (estimator->srttUs + 4 * estimator->rttvarUs + US_PER_MS - 1) / US_PER_MS;
+	timeoutMs <<= estimator->backoff;
+	if (timeoutMs < config->floorMs)
+	{
+		return config->floorMs;
+	}
+	return timeoutMs > config->ceilingMs ? config->ceilingMs : (unsigned int)timeoutMs;
+}
+
+/**
+ * @brief Get the timeout for the next operation on a device. Safe to call from any thread.
+ * @param *estimator estimate of the device, NULL for a device that isn't tracked.
+ * @param *config floor and ceiling of the timeout.
+ * @return timeout in milliseconds.
+ */
+unsigned int Rtt_GetTimeout(RttEstimator *estimator, const RttConfig *config)
+{
+	unsigned int timeoutMs;
+
+	if (estimator == NULL)
+	{
+		return config->ceilingMs;
+	}
+
+	pthread_mutex_lock(&estimator->lock);
+	timeoutMs = ComputeTimeout(estimator, config);
+	pthread_mutex_unlock(&estimator->lock);
+	return timeoutMs;
+}
+
+/**
+ * @brief Get a consistent copy of an estimate.
+ * @param *estimator estimate of the device.
+ * @param *config floor and ceiling of the timeout.
+ * @param *stats filled with the estimate.
+ */
+void Rtt_GetStats(RttEstimator *estimator, const RttConfig *config, RttStats *stats)
+{
+	pthread_mutex_lock(&estimator->lock);
+	stats->srttUs = estimator->srttUs;
+	stats->rttvarUs = estimator->rttvarUs;
+	stats->lastUs = estimator->lastUs;
+	stats->samples = estimator->samples;
+	stats->timeouts = estimator->timeouts;
+	stats->timeoutMs = ComputeTimeout(estimator, config);
+	pthread_mutex_unlock(&estimator->lock);
+}
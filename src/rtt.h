@@ -0,0 +1,146 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file rtt.h
+ * @brief Header file for per device round trip time estimation. Operation timeouts are derived
+ *        from a smoothed round trip time and its variation, as TCP derives its retransmission
+ *        timeout, so a slow or unreachable device is given up on no later than it needs to be.
+ */
+
+#ifndef RTT_H
+#define RTT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+//! @cond Doxygen_Suppress
+#define RTT_FLOOR			(200)
+#define RTT_CEILING			(5000)
+#define RTT_MAX_BACKOFF		(8)
+//! @endcond
+
+/**
+ * A structure to contain timeout configuration.
+ */
+typedef struct
+{
+	/*@{*/
+	unsigned int floorMs; /**< shortest timeout given to an operation */
+	unsigned int ceilingMs; /**< longest timeout, also used until a device has answered */
+	/*@}*/
+}RttConfig;
+
+/**
+ * A structure to contain the round trip time estimate of one device.
+ */
+typedef struct
+{
+	/*@{*/
+	pthread_mutex_t lock; /**< protects everything below */
+	uint64_t srttUs; /**< smoothed round trip time */
+	uint64_t rttvarUs; /**< smoothed round trip time variation */
+	uint64_t lastUs; /**< last measured round trip time */
+	unsigned int backoff; /**< timeouts since the last answer, each doubles the timeout */
+	unsigned long samples; /**< answers measured */
+	unsigned long timeouts; /**< operations that timed out */
+	/*@}*/
+}RttEstimator;
+
+/**
+ * A structure to contain a snapshot of an estimate.
+ */
+typedef struct
+{
+	/*@{*/
+	uint64_t srttUs; /**< smoothed round trip time */
+	uint64_t rttvarUs; /**< smoothed round trip time variation */
+	uint64_t lastUs; /**< last measured round trip time */
+	unsigned long samples; /**< answers measured */
+	unsigned long timeouts; /**< operations that timed out */
+	unsigned int timeoutMs; /**< timeout the next operation gets */
+	/*@}*/
+}RttStats;
+
+/**
+ * @brief Fill configuration with defaults, then override them from the "timeouts" group of a
+ *        libconfig file if there is one.
+ * @param *config configuration to fill.
+ * @param *file configuration file, may not exist.
+ * @return true if configuration is usable, else false and config holds the defaults.
+ */
+bool Rtt_LoadConfig(RttConfig *config, const char *file);
+
+/**
+ * @brief Start an estimate without any measurement.
+ * @param *estimator estimate to initialize.
+ */
+void Rtt_Init(RttEstimator *estimator);
+
+/**
+ * @brief Free an estimate.
+ * @param *estimator estimate to destroy.
+ */
+void Rtt_Destroy(RttEstimator *estimator);
+
+/**
+ * @brief Add the round trip time of an operation the device answered. Safe to call from any
+ *        thread.
+ * @param *estimator estimate of the device.
+ * @param *start monotonic time the operation was started.
+ */
+void Rtt_Sample(RttEstimator *estimator, const struct timespec *start);
+
+/**
+ * @brief Record an operation that timed out, which doubles the timeout until the device answers
+ *        again. Safe to call from any thread.
+ * @param *estimator estimate of the device.
+ */
+void Rtt_Timeout(RttEstimator *estimator);
+
+/**
+ * @brief Get the timeout for the next operation on a device. Safe to call from any thread.
+ * @param *estimator estimate of the device, NULL for a device that isn't tracked.
+ * @param *config floor and ceiling of the timeout.
+ * @return timeout in milliseconds.
+ */
+unsigned int Rtt_GetTimeout(RttEstimator *estimator, const RttConfig *config);
+
+/**
+ * @brief Get a consistent copy of an estimate.
+ * @param *estimator estimate of the device.
+ * @param *config floor and ceiling of the timeout.
+ * @param *stats filled with the estimate.
+ */
+void Rtt_GetStats(RttEstimator *estimator, const RttConfig *config, RttStats *stats);
+
+#endif	/* RTT_H */
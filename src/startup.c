@@ -0,0 +1,216 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file startup.c
+ * @brief Startup timing report. Whenever a phase ends the report file is rewritten as a single
+ *        JSON object, one member per phase with begin and end in microseconds from process start
+ *        (null while not reached), so a benchmark can read it at any time:
+ *
+ *        {"server_session": {"begin_us": 120, "end_us": 5310}, ...}
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "startup.h"
+#include "log.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define US_PER_SECOND	(1000000)
+#define NS_PER_US		(1000)
+#define US_PER_MS		(1000)
+#define REPORT_PATH_SIZE	(256)
+//! @endcond
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+/** Phase names, in StartupPhase order. */
+static const char *phaseNames[StartupPhase_Max] =
+{
+	"server_session",
+	"server_define",
+	"provisioning",
+	"client_define",
+	"flow_connect",
+	"first_observation",
+	"all_observed",
+};
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Get microseconds elapsed since process start.
+ * @param *report startup report.
+ * @return elapsed microseconds.
+ */
+static uint64_t ElapsedUs(const StartupReport *report)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)(now.tv_sec - report->origin.tv_sec) * US_PER_SECOND +
+			(now.tv_nsec - report->origin.tv_nsec) / NS_PER_US;
+}
+
+/**
+ * @brief Write one timestamp member of the report, or null if not reached.
+ * @param *file report file.
+ * @param *name member name.
+ * @param reached whether the timestamp was recorded.
+ * @param us timestamp.
+ */
+static void WriteTimestamp(FILE *file, const char *name, bool reached, uint64_t us)
+{
+	if (reached)
+	{
+		fprintf(file, "\"%s\": %llu", name, (unsigned long long)us);
+	}
+	else
+	{
+		fprintf(file, "\"%s\": null", name);
+	}
+}
+
+/**
+ * @brief Rewrite the report file. It is written aside and renamed, so readers never see a
+ *        partial report. Caller holds the lock.
+ * @param *report startup report.
+ */
+static void WriteReport(const StartupReport *report)
+{
+	char path[REPORT_PATH_SIZE];
+	FILE *file;
+	int i;
+
+	snprintf(path, sizeof(path), "%s.tmp", report->file);
+	file = fopen(path, "w");
+	if (file == NULL)
+	{
+		LOG(LOG_WARN, "Failed to write startup report %s", path);
+		return;
+	}
+
+	fprintf(file, "{");
+	for (i = 0; i < StartupPhase_Max; i++)
+	{
+		fprintf(file, "%s\"%s\": {", i ? ", " : "", phaseNames[i]);
+		WriteTimestamp(file, "begin_us", report->phases[i].begun, report->phases[i].beginUs);
+		fprintf(file, ", ");
+		WriteTimestamp(file, "end_us", report->phases[i].ended, report->phases[i].endUs);
+		fprintf(file, "}");
+	}
+	fprintf(file, "}\n");
+
+	if (fclose(file) != 0 || rename(path, report->file) != 0)
+	{
+		LOG(LOG_WARN, "Failed to write startup report %s", report->file);
+	}
+}
+
+/**
+ * @brief Start the clock of a report.
+ * @param *report report to initialize.
+ * @param *file report file, NULL to only log phases.
+ */
+void Startup_Init(StartupReport *report, const char *file)
+{
+	memset(report, 0, sizeof(*report));
+	clock_gettime(CLOCK_MONOTONIC, &report->origin);
+	pthread_mutex_init(&report->lock, NULL);
+	report->file = file;
+}
+
+/**
+ * @brief Record begin of a phase. Later calls for the same phase are ignored.
+ * @param *report startup report.
+ * @param phase phase that began.
+ */
+void Startup_Begin(StartupReport *report, StartupPhase phase)
+{
+	pthread_mutex_lock(&report->lock);
+	if (!report->phases[phase].begun)
+	{
+		report->phases[phase].begun = true;
+		report->phases[phase].beginUs = ElapsedUs(report);
+	}
+	pthread_mutex_unlock(&report->lock);
+}
+
+/**
+ * @brief Record end of a phase, and rewrite the report file. A phase which never began is
+ *        taken to have begun at process start. Later calls for the same phase are ignored.
+ * @param *report startup report.
+ * @param phase phase that ended.
+ */
+void Startup_End(StartupReport *report, StartupPhase phase)
+{
+	StartupTiming *timing = &report->phases[phase];
+
+	pthread_mutex_lock(&report->lock);
+	if (!timing->ended)
+	{
+		timing->begun = true;
+		timing->ended = true;
+		timing->endUs = ElapsedUs(report);
+
+		LOG(LOG_INFO, "Startup phase %s done at %llu ms, took %llu ms", phaseNames[phase],
+				(unsigned long long)(timing->endUs / US_PER_MS),
+				(unsigned long long)((timing->endUs - timing->beginUs) / US_PER_MS));
+
+		if (report->file != NULL)
+		{
+			WriteReport(report);
+		}
+	}
+	pthread_mutex_unlock(&report->lock);
+}
+
+/**
+ * @brief Get name of a phase, as used in the report file.
+ * @param phase startup phase.
+ * @return phase name.
+ */
+const char *Startup_PhaseToString(StartupPhase phase)
+{
+	return phase < StartupPhase_Max ? phaseNames[phase] : "unknown";
+}
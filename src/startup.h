@@ -0,0 +1,115 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file startup.h
+ * @brief Header file for the startup timing report, which records when each startup phase began
+ *        and finished relative to process start.
+ */
+
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+/**
+ * Startup phases. Phases run concurrently, so they may overlap.
+ */
+typedef enum
+{
+	StartupPhase_ServerSession, /**< connect to server daemon */
+	StartupPhase_ServerDefine, /**< define objects on server daemon */
+	StartupPhase_Provisioning, /**< wait for the gateway to be provisioned */
+	StartupPhase_ClientDefine, /**< define objects on client daemon */
+	StartupPhase_FlowConnect, /**< register with Flow */
+	StartupPhase_FirstObservation, /**< observe buttons of the first registered device */
+	StartupPhase_AllObserved, /**< observe buttons of every bound device */
+	StartupPhase_Max /**< number of phases */
+}StartupPhase;
+
+/**
+ * A structure to contain timing of one phase.
+ */
+typedef struct
+{
+	/*@{*/
+	bool begun; /**< phase has begun */
+	bool ended; /**< phase has ended */
+	uint64_t beginUs; /**< microseconds from process start to begin */
+	uint64_t endUs; /**< microseconds from process start to end */
+	/*@}*/
+}StartupTiming;
+
+/**
+ * A structure to contain the startup timing report.
+ */
+typedef struct
+{
+	/*@{*/
+	struct timespec origin; /**< monotonic time of process start */
+	pthread_mutex_t lock; /**< protects phases, phases end on several threads */
+	StartupTiming phases[StartupPhase_Max]; /**< timing of each phase */
+	const char *file; /**< report file rewritten whenever a phase ends, NULL for none */
+	/*@}*/
+}StartupReport;
+
+/**
+ * @brief Start the clock of a report.
+ * @param *report report to initialize.
+ * @param *file report file, NULL to only log phases.
+ */
+void Startup_Init(StartupReport *report, const char *file);
+
+/**
+ * @brief Record begin of a phase. Later calls for the same phase are ignored.
+ * @param *report startup report.
+ * @param phase phase that began.
+ */
+void Startup_Begin(StartupReport *report, StartupPhase phase);
+
+/**
+ * @brief Record end of a phase, and rewrite the report file. A phase which never began is
+ *        taken to have begun at process start. Later calls for the same phase are ignored.
+ * @param *report startup report.
+ * @param phase phase that ended.
+ */
+void Startup_End(StartupReport *report, StartupPhase phase);
+
+/**
+ * @brief Get name of a phase, as used in the report file.
+ * @param phase startup phase.
+ * @return phase name.
+ */
+const char *Startup_PhaseToString(StartupPhase phase);
+
+#endif	/* STARTUP_H */
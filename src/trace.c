@@ -0,0 +1,278 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file trace.c
+ * @brief Span tracing. Spans are written to a ring shared by all threads: a writer claims a slot
+ *        with an atomic increment and marks it complete with its sequence number, so recording
+ *        takes no lock and no system call besides reading the vDSO clock. The dump runs on the
+ *        event loop and skips slots that are being rewritten while it reads them.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "trace.h"
+#include "log.h"
+
+#ifdef TRACE_ENABLED
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define NS_PER_SECOND	(1000000000ULL)
+#define NS_PER_US		(1000)
+//! @endcond
+
+/***************************************************************************************************
+ * Typedef
+ **************************************************************************************************/
+
+/**
+ * A structure to contain one recorded span.
+ */
+typedef struct
+{
+	/*@{*/
+	unsigned long sequence; /**< claim number plus one once complete, 0 while being written */
+	const char *name; /**< span name */
+	uint32_t event; /**< button event sequence number, or TRACE_NO_EVENT */
+	uint32_t thread; /**< kernel thread ID */
+	uint64_t startNs; /**< monotonic start time */
+	uint64_t durationNs; /**< span length */
+	/*@}*/
+}TraceSpan;
+
+/**
+ * A structure to contain a named thread.
+ */
+typedef struct
+{
+	/*@{*/
+	uint32_t thread; /**< kernel thread ID, 0 if unused */
+	const char *name; /**< thread name */
+	/*@}*/
+}TraceThread;
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+/** Ring of recorded spans. */
+static TraceSpan spans[TRACE_RING_SIZE];
+/** Number of spans ever claimed. */
+static unsigned long spanCount;
+/** Named threads. */
+static TraceThread threads[TRACE_MAX_THREADS];
+/** Number of named threads. */
+static unsigned int threadCount;
+/** Kernel thread ID of the calling thread, 0 until first needed. */
+static __thread uint32_t currentThread;
+/** Button event the calling thread is working on. */
+static __thread uint32_t currentEvent = TRACE_NO_EVENT;
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Get kernel thread ID of the calling thread.
+ * @return thread ID.
+ */
+static uint32_t GetThread(void)
+{
+	if (currentThread == 0)
+	{
+		currentThread = syscall(SYS_gettid);
+	}
+	return currentThread;
+}
+
+/**
+ * @brief Convert a monotonic time to nanoseconds.
+ * @param *time time to convert.
+ * @return nanoseconds.
+ */
+static uint64_t ToNs(const struct timespec *time)
+{
+	return (uint64_t)time->tv_sec * NS_PER_SECOND + time->tv_nsec;
+}
+
+/**
+ * @brief Name the calling thread in the trace.
+ * @param *name thread name, must stay valid.
+ */
+void Trace_NameThread(const char *name)
+{
+	unsigned int index = __atomic_fetch_add(&threadCount, 1, __ATOMIC_RELAXED);
+
+	if (index < TRACE_MAX_THREADS)
+	{
+		threads[index].name = name;
+		__atomic_store_n(&threads[index].thread, GetThread(), __ATOMIC_RELEASE);
+	}
+}
+
+/**
+ * @brief Attribute the calling thread's following spans to a button event.
+ * @param id button event sequence number, TRACE_NO_EVENT for spans of no particular event.
+ */
+void Trace_SetEvent(uint32_t id)
+{
+	currentEvent = id;
+}
+
+/**
+ * @brief Record a span of the calling thread from start until now. Lock free, the oldest span is
+ *        overwritten once the ring is full.
+ * @param *name span name, must stay valid.
+ * @param *start monotonic start time.
+ */
+void Trace_Record(const char *name, const struct timespec *start)
+{
+	struct timespec now;
+	unsigned long claim;
+	TraceSpan *span;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	claim = __atomic_fetch_add(&spanCount, 1, __ATOMIC_RELAXED);
+	span = &spans[claim % TRACE_RING_SIZE];
+
+	__atomic_store_n(&span->sequence, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	span->name = name;
+	span->event = currentEvent;
+	span->thread = GetThread();
+	span->startNs = ToNs(start);
+	span->durationNs = ToNs(&now) - span->startNs;
+	__atomic_store_n(&span->sequence, claim + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Take a consistent copy of a span.
+ * @param claim claim number the span was recorded with.
+ * @param *copy filled with the span.
+ * @return true if the slot still holds that span, else false.
+ */
+static bool CopySpan(unsigned long claim, TraceSpan *copy)
+{
+	TraceSpan *span = &spans[claim % TRACE_RING_SIZE];
+
+	if (__atomic_load_n(&span->sequence, __ATOMIC_ACQUIRE) != claim + 1)
+	{
+		return false;
+	}
+	copy->name = span->name;
+	copy->event = span->event;
+	copy->thread = span->thread;
+	copy->startNs = span->startNs;
+	copy->durationNs = span->durationNs;
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return (__atomic_load_n(&span->sequence, __ATOMIC_RELAXED) == claim + 1);
+}
+
+/**
+ * @brief Write the spans in the ring as Chrome trace-event JSON. Spans being recorded meanwhile
+ *        are skipped.
+ * @param *file file to write.
+ * @return true on success, else false.
+ */
+bool Trace_Dump(const char *file)
+{
+	FILE *stream;
+	TraceSpan span;
+	unsigned long end = __atomic_load_n(&spanCount, __ATOMIC_ACQUIRE);
+	unsigned long claim = end > TRACE_RING_SIZE ? end - TRACE_RING_SIZE : 0;
+	unsigned int named = __atomic_load_n(&threadCount, __ATOMIC_RELAXED);
+	unsigned int written = 0;
+	unsigned int i;
+	int pid = getpid();
+	bool success;
+
+	if ((stream = fopen(file, "w")) == NULL)
+	{
+		LOG(LOG_ERR, "Failed to open %s: %s", file, strerror(errno));
+		return false;
+	}
+
+	fprintf(stream, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	for (i = 0; i < named && i < TRACE_MAX_THREADS; i++)
+	{
+		uint32_t thread = __atomic_load_n(&threads[i].thread, __ATOMIC_ACQUIRE);
+
+		if (thread != 0)
+		{
+			fprintf(stream, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,"
+					"\"args\":{\"name\":\"%s\"}}", written++ ? "," : "", pid, thread,
+					threads[i].name);
+		}
+	}
+
+	for (; claim < end; claim++)
+	{
+		if (!CopySpan(claim, &span))
+		{
+			continue;
+		}
+
+		fprintf(stream, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,"
+				"\"ts\":%llu.%03u,\"dur\":%llu.%03u", written++ ? "," : "", span.name, pid,
+				span.thread, (unsigned long long)(span.startNs / NS_PER_US),
+				(unsigned int)(span.startNs % NS_PER_US),
+				(unsigned long long)(span.durationNs / NS_PER_US),
+				(unsigned int)(span.durationNs % NS_PER_US));
+		if (span.event != TRACE_NO_EVENT)
+		{
+			fprintf(stream, ",\"args\":{\"event\":%u}", span.event);
+		}
+		fprintf(stream, "}");
+	}
+	fprintf(stream, "\n]}\n");
+
+	success = (ferror(stream) == 0);
+	if (fclose(stream) != 0 || !success)
+	{
+		LOG(LOG_ERR, "Failed to write %s", file);
+		return false;
+	}
+	LOG(LOG_INFO, "Wrote %u trace events to %s", written, file);
+	return true;
+}
+
+#endif	/* TRACE_ENABLED */
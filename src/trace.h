@@ -0,0 +1,101 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file trace.h
+ * @brief Header file for span tracing. Each stage of a button event records its begin and end in
+ *        an in-memory ring, which is written out as Chrome trace-event JSON for chrome://tracing
+ *        or Perfetto. Tracing is only built in when TRACE_ENABLED is defined, otherwise the
+ *        macros below expand to nothing.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+//! @cond Doxygen_Suppress
+#define TRACE_FILE				"/tmp/button_gateway_trace.json"
+#define TRACE_RING_SIZE			(4096)
+#define TRACE_MAX_THREADS		(16)
+#define TRACE_NO_EVENT			(UINT32_MAX)
+//! @endcond
+
+#ifdef TRACE_ENABLED
+
+/** Name the calling thread in the trace. */
+#define TRACE_NAME_THREAD(name)		Trace_NameThread(name)
+/** Attribute the calling thread's following spans to a button event sequence number. */
+#define TRACE_SET_EVENT(id)			Trace_SetEvent(id)
+/** Start a span, declaring its start time. */
+#define TRACE_BEGIN(start)			struct timespec start; clock_gettime(CLOCK_MONOTONIC, &start)
+/** End a span started at a monotonic time. */
+#define TRACE_END(name, start)		Trace_Record(name, &(start))
+
+#else
+
+#define TRACE_NAME_THREAD(name)
+#define TRACE_SET_EVENT(id)
+#define TRACE_BEGIN(start)
+#define TRACE_END(name, start)
+
+#endif
+
+/**
+ * @brief Name the calling thread in the trace.
+ * @param *name thread name, must stay valid.
+ */
+void Trace_NameThread(const char *name);
+
+/**
+ * @brief Attribute the calling thread's following spans to a button event.
+ * @param id button event sequence number, TRACE_NO_EVENT for spans of no particular event.
+ */
+void Trace_SetEvent(uint32_t id);
+
+/**
+ * @brief Record a span of the calling thread from start until now. Lock free, the oldest span is
+ *        overwritten once the ring is full.
+ * @param *name span name, must stay valid.
+ * @param *start monotonic start time.
+ */
+void Trace_Record(const char *name, const struct timespec *start);
+
+/**
+ * @brief Write the spans in the ring as Chrome trace-event JSON. Spans being recorded meanwhile
+ *        are skipped.
+ * @param *file file to write.
+ * @return true on success, else false.
+ */
+bool Trace_Dump(const char *file);
+
+#endif	/* TRACE_H */
@@ -0,0 +1,403 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file worker.c
+ * @brief Actuation worker threads with bounded, optionally coalescing and batching queues and
+ *        latency statistics.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "worker.h"
+#include "log.h"
+#include "trace.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define US_PER_SECOND	(1000000)
+#define NS_PER_US		(1000)
+//! @endcond
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Get microseconds elapsed since a monotonic time.
+ * @param *since start time.
+ * @return elapsed microseconds.
+ */
+static uint64_t ElapsedUs(const struct timespec *since)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)(now.tv_sec - since->tv_sec) * US_PER_SECOND +
+			(now.tv_nsec - since->tv_nsec) / NS_PER_US;
+}
+
+/**
+ * @brief Forget the queued item of a slot, once it was taken off the queue.
+ * @param *worker worker, locked.
+ * @param index ring index of the item.
+ */
+static void ReleaseSlot(Worker *worker, unsigned int index)
+{
+	unsigned int slot = worker->items[index].slot;
+
+	if (worker->pending != NULL && slot < worker->numSlots && worker->pending[slot] == (int)index)
+	{
+		worker->pending[slot] = -1;
+	}
+}
+
+/**
+ * @brief Move a queued item to another ring index, keeping its slot pointing at it.
+ * @param *worker worker, locked.
+ * @param from ring index of the item.
+ * @param to free ring index.
+ */
+static void MoveItem(Worker *worker, unsigned int from, unsigned int to)
+{
+	unsigned int slot = worker->items[from].slot;
+
+	worker->items[to] = worker->items[from];
+	if (worker->pending != NULL && slot < worker->numSlots && worker->pending[slot] == (int)from)
+	{
+		worker->pending[slot] = to;
+	}
+}
+
+/**
+ * @brief Take the oldest item off the queue, along with the queued items of its group if the
+ *        worker batches. Items left behind close up in queue order.
+ * @param *worker worker, locked, with at least one item queued.
+ * @param *batch filled with taken items, WORKER_MAX_BATCH long.
+ * @return number of items taken.
+ */
+static unsigned int TakeItems(Worker *worker, WorkItem *batch)
+{
+	const void *group = worker->items[worker->head].group;
+	unsigned int count = 0, kept = 0, i;
+
+	batch[count++] = worker->items[worker->head];
+	ReleaseSlot(worker, worker->head);
+
+	if (worker->batchHandler != NULL && group != NULL)
+	{
+		for (i = 1; i < worker->stats.depth; i++)
+		{
+			unsigned int from = (worker->head + i) % worker->capacity;
+
+			if (count < WORKER_MAX_BATCH && worker->items[from].group == group)
+			{
+				batch[count++] = worker->items[from];
+				ReleaseSlot(worker, from);
+			}
+			else
+			{
+				unsigned int to = (worker->head + 1 + kept) % worker->capacity;
+
+				if (to != from)
+				{
+					MoveItem(worker, from, to);
+				}
+				kept++;
+			}
+		}
+	}
+	else
+	{
+		kept = worker->stats.depth - 1;
+	}
+
+	worker->head = (worker->head + 1) % worker->capacity;
+	worker->stats.depth = kept;
+	return count;
+}
+
+/**
+ * @brief Worker thread, runs the handler for queued items in order, a group at a time if the
+ *        worker batches.
+ * @param *arg worker.
+ * @return NULL.
+ */
+static void *WorkerThread(void *arg)
+{
+	Worker *worker = arg;
+	WorkItem batch[WORKER_MAX_BATCH];
+	bool results[WORKER_MAX_BATCH];
+	uint64_t latencies[WORKER_MAX_BATCH];
+	unsigned int count, i;
+
+	TRACE_NAME_THREAD(worker->name);
+	pthread_mutex_lock(&worker->lock);
+	while (worker->running)
+	{
+		if (worker->stats.depth == 0)
+		{
+			pthread_cond_wait(&worker->wakeup, &worker->lock);
+			continue;
+		}
+
+		count = TakeItems(worker, batch);
+		pthread_mutex_unlock(&worker->lock);
+
+		TRACE_SET_EVENT(batch[0].sequence);
+		TRACE_BEGIN(start);
+		if (worker->batchHandler != NULL)
+		{
+			worker->batchHandler(batch, count, results, worker->context);
+		}
+		else
+		{
+			results[0] = worker->handler(&batch[0], worker->context);
+		}
+		TRACE_END(worker->name, start);
+		for (i = 0; i < count; i++)
+		{
+			latencies[i] = ElapsedUs(&batch[i].queued);
+		}
+
+		pthread_mutex_lock(&worker->lock);
+		for (i = 0; i < count; i++)
+		{
+			if (results[i])
+			{
+				worker->stats.succeeded++;
+			}
+			else
+			{
+				worker->stats.failed++;
+			}
+			worker->stats.lastLatencyUs = latencies[i];
+			worker->stats.totalLatencyUs += latencies[i];
+			if (latencies[i] > worker->stats.maxLatencyUs)
+			{
+				worker->stats.maxLatencyUs = latencies[i];
+			}
+		}
+	}
+	pthread_mutex_unlock(&worker->lock);
+	return NULL;
+}
+
+/**
+ * @brief Allocate the queue and start the worker thread.
+ * @param *worker worker to start.
+ * @param *name worker name for logs.
+ * @param numSlots number of targets to coalesce items of, 0 doesn't coalesce.
+ * @param handler performs each item, if batchHandler is NULL.
+ * @param batchHandler performs each batch, or NULL.
+ * @param *context passed to handler.
+ * @return true if thread started, else false.
+ */
+static bool StartWorker(Worker *worker, const char *name, unsigned int numSlots,
+		WorkerHandler handler, WorkerBatchHandler batchHandler, void *context)
+{
+	unsigned int i;
+
+	memset(worker, 0, sizeof(*worker));
+	worker->name = name;
+	worker->handler = handler;
+	worker->batchHandler = batchHandler;
+	worker->context = context;
+	worker->capacity = numSlots ? numSlots : WORKER_QUEUE_SIZE;
+	worker->numSlots = numSlots;
+	worker->items = calloc(worker->capacity, sizeof(*worker->items));
+	if (numSlots != 0)
+	{
+		worker->pending = malloc(numSlots * sizeof(*worker->pending));
+	}
+
+	if (worker->items == NULL || (numSlots != 0 && worker->pending == NULL))
+	{
+		LOG(LOG_ERR, "Failed to allocate %s queue of %u items", name, worker->capacity);
+		free(worker->items);
+		free(worker->pending);
+		return false;
+	}
+
+	for (i = 0; i < numSlots; i++)
+	{
+		worker->pending[i] = -1;
+	}
+
+	worker->running = true;
+	pthread_mutex_init(&worker->lock, NULL);
+	pthread_cond_init(&worker->wakeup, NULL);
+
+	if (pthread_create(&worker->thread, NULL, WorkerThread, worker) != 0)
+	{
+		LOG(LOG_ERR, "Failed to start %s worker", name);
+		worker->running = false;
+		pthread_cond_destroy(&worker->wakeup);
+		pthread_mutex_destroy(&worker->lock);
+		free(worker->items);
+		free(worker->pending);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Start worker thread. A coalescing worker holds at most one queued item per target,
+ *        so its queue has one entry per slot.
+ * @param *worker worker to start.
+ * @param *name worker name for logs.
+ * @param numSlots number of targets to coalesce items of, 0 queues every item in a ring of
+ *        WORKER_QUEUE_SIZE.
+ * @param handler performs each queued item.
+ * @param *context passed to handler.
+ * @return true if thread started, else false.
+ */
+bool Worker_Start(Worker *worker, const char *name, unsigned int numSlots, WorkerHandler handler,
+		void *context)
+{
+	return StartWorker(worker, name, numSlots, handler, NULL, context);
+}
+
+/**
+ * @brief Start worker thread that hands every queued item of the group of the oldest item to
+ *        its handler at once, up to WORKER_MAX_BATCH. Items keep their order within a batch,
+ *        and the items left behind keep theirs. Otherwise as Worker_Start.
+ * @param *worker worker to start.
+ * @param *name worker name for logs.
+ * @param numSlots number of targets to coalesce items of, 0 doesn't coalesce.
+ * @param handler performs each batch.
+ * @param *context passed to handler.
+ * @return true if thread started, else false.
+ */
+bool Worker_StartBatched(Worker *worker, const char *name, unsigned int numSlots,
+		WorkerBatchHandler handler, void *context)
+{
+	return StartWorker(worker, name, numSlots, NULL, handler, context);
+}
+
+/**
+ * @brief Queue an item without blocking. On a coalescing worker, an item for a slot that
+ *        already has one queued replaces it in place, so only the latest led state is sent once
+ *        the item in flight completes. If the queue is full the oldest item is dropped, since
+ *        only the latest led state matters.
+ * @param *worker worker to queue to.
+ * @param *item item to copy into the queue.
+ * @return true if no item had to be dropped, else false.
+ */
+bool Worker_Enqueue(Worker *worker, const WorkItem *item)
+{
+	bool success = true;
+	unsigned int tail;
+
+	pthread_mutex_lock(&worker->lock);
+	if (worker->pending != NULL && item->slot < worker->numSlots &&
+		worker->pending[item->slot] >= 0)
+	{
+		/* The replaced item keeps its place and queue time, so queue latency stays bounded */
+		WorkItem *queued = &worker->items[worker->pending[item->slot]];
+		struct timespec since = queued->queued;
+
+		*queued = *item;
+		queued->queued = since;
+		worker->stats.coalesced++;
+		pthread_mutex_unlock(&worker->lock);
+		return true;
+	}
+
+	if (worker->stats.depth == worker->capacity)
+	{
+		ReleaseSlot(worker, worker->head);
+		worker->head = (worker->head + 1) % worker->capacity;
+		worker->stats.depth--;
+		worker->stats.dropped++;
+		success = false;
+	}
+
+	tail = (worker->head + worker->stats.depth) % worker->capacity;
+	worker->items[tail] = *item;
+	if (worker->pending != NULL && item->slot < worker->numSlots)
+	{
+		worker->pending[item->slot] = tail;
+	}
+	worker->stats.depth++;
+	if (worker->stats.depth > worker->stats.maxDepth)
+	{
+		worker->stats.maxDepth = worker->stats.depth;
+	}
+	pthread_cond_signal(&worker->wakeup);
+	pthread_mutex_unlock(&worker->lock);
+
+	return success;
+}
+
+/**
+ * @brief Stop worker thread once its current item is done, discarding queued items.
+ * @param *worker worker to stop.
+ */
+void Worker_Stop(Worker *worker)
+{
+	pthread_mutex_lock(&worker->lock);
+	if (!worker->running)
+	{
+		pthread_mutex_unlock(&worker->lock);
+		return;
+	}
+	worker->running = false;
+	pthread_cond_signal(&worker->wakeup);
+	pthread_mutex_unlock(&worker->lock);
+
+	pthread_join(worker->thread, NULL);
+	pthread_cond_destroy(&worker->wakeup);
+	pthread_mutex_destroy(&worker->lock);
+	free(worker->items);
+	free(worker->pending);
+	worker->items = NULL;
+	worker->pending = NULL;
+}
+
+/**
+ * @brief Get a consistent copy of worker statistics.
+ * @param *worker worker to inspect.
+ * @param *stats filled with statistics.
+ */
+void Worker_GetStats(Worker *worker, WorkerStats *stats)
+{
+	pthread_mutex_lock(&worker->lock);
+	*stats = worker->stats;
+	pthread_mutex_unlock(&worker->lock);
+}
@@ -0,0 +1,179 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file worker.h
+ * @brief Header file for actuation workers. Each worker owns a thread and a bounded queue, so a
+ *        slow sink only delays its own queue and never the button handling.
+ */
+
+#ifndef WORKER_H
+#define WORKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+//! @cond Doxygen_Suppress
+#define WORKER_QUEUE_SIZE	(32)
+#define WORKER_MAX_BATCH	(16)
+//! @endcond
+
+/**
+ * A structure to contain one unit of actuation work.
+ */
+typedef struct
+{
+	/*@{*/
+	bool value; /**< led state to actuate */
+	const void *target; /**< sink specific target, e.g. the led to write */
+	unsigned int slot; /**< index of the target, used by coalescing workers */
+	const void *group; /**< items of the same group, e.g. leds of one device, are handed to a
+			batch handler together, NULL is never batched */
+	uint32_t sequence; /**< button event sequence number */
+	struct timespec queued; /**< monotonic time the item was queued */
+	struct timespec received; /**< monotonic time the button notification was received, zero if
+			the item wasn't caused by a button */
+	/*@}*/
+}WorkItem;
+
+/**
+ * @brief Performs one unit of work on the worker thread.
+ * @param *item work to perform.
+ * @param *context pointer passed to Worker_Start.
+ * @return true if work succeeded, else false.
+ */
+typedef bool (*WorkerHandler)(const WorkItem *item, void *context);
+
+/**
+ * @brief Performs queued items of the same group at once on the worker thread.
+ * @param *items items to perform, in queue order.
+ * @param count number of items, at most WORKER_MAX_BATCH.
+ * @param *results set to whether each item succeeded.
+ * @param *context pointer passed to Worker_StartBatched.
+ */
+typedef void (*WorkerBatchHandler)(const WorkItem *items, unsigned int count, bool *results,
+		void *context);
+
+/**
+ * A structure to contain a snapshot of worker statistics.
+ */
+typedef struct
+{
+	/*@{*/
+	unsigned int depth; /**< items waiting */
+	unsigned int maxDepth; /**< high water mark of depth */
+	unsigned long succeeded; /**< items handled successfully */
+	unsigned long failed; /**< items whose handler failed */
+	unsigned long dropped; /**< items dropped because queue was full */
+	unsigned long coalesced; /**< items replaced by a newer item for the same target */
+	uint64_t lastLatencyUs; /**< queue to completion time of the last item */
+	uint64_t maxLatencyUs; /**< worst queue to completion time */
+	uint64_t totalLatencyUs; /**< sum of queue to completion times */
+	/*@}*/
+}WorkerStats;
+
+/**
+ * A structure to contain a worker thread and its queue.
+ */
+typedef struct
+{
+	/*@{*/
+	const char *name; /**< worker name for logs */
+	pthread_t thread; /**< worker thread */
+	pthread_mutex_t lock; /**< protects everything below */
+	pthread_cond_t wakeup; /**< signalled when items are queued or worker is stopped */
+	WorkItem *items; /**< ring storage */
+	unsigned int capacity; /**< size of the ring */
+	unsigned int head; /**< index of the oldest item */
+	int *pending; /**< ring index of the queued item of each slot, -1 if none, NULL if the
+			worker doesn't coalesce */
+	unsigned int numSlots; /**< number of slots */
+	bool running; /**< cleared by Worker_Stop */
+	WorkerHandler handler; /**< performs the work one item at a time */
+	WorkerBatchHandler batchHandler; /**< performs the work a group at a time, or NULL */
+	void *context; /**< passed to handler */
+	WorkerStats stats; /**< statistics */
+	/*@}*/
+}Worker;
+
+/**
+ * @brief Start worker thread. A coalescing worker holds at most one queued item per target,
+ *        so its queue has one entry per slot.
+ * @param *worker worker to start.
+ * @param *name worker name for logs.
+ * @param numSlots number of targets to coalesce items of, 0 queues every item in a ring of
+ *        WORKER_QUEUE_SIZE.
+ * @param handler performs each queued item.
+ * @param *context passed to handler.
+ * @return true if thread started, else false.
+ */
+bool Worker_Start(Worker *worker, const char *name, unsigned int numSlots, WorkerHandler handler,
+		void *context);
+
+/**
+ * @brief Start worker thread that hands every queued item of the group of the oldest item to
+ *        its handler at once, up to WORKER_MAX_BATCH. Otherwise as Worker_Start.
+ * @param *worker worker to start.
+ * @param *name worker name for logs.
+ * @param numSlots number of targets to coalesce items of, 0 doesn't coalesce.
+ * @param handler performs each batch.
+ * @param *context passed to handler.
+ * @return true if thread started, else false.
+ */
+bool Worker_StartBatched(Worker *worker, const char *name, unsigned int numSlots,
+		WorkerBatchHandler handler, void *context);
+
+/**
+ * @brief Queue an item without blocking. On a coalescing worker, an item for a slot that
+ *        already has one queued replaces it in place, so only the latest led state is sent once
+ *        the item in flight completes. If the queue is full the oldest item is dropped, since
+ *        only the latest led state matters.
+ * @param *worker worker to queue to.
+ * @param *item item to copy into the queue.
+ * @return true if no item had to be dropped, else false.
+ */
+bool Worker_Enqueue(Worker *worker, const WorkItem *item);
+
+/**
+ * @brief Stop worker thread once its current item is done, discarding queued items.
+ * @param *worker worker to stop.
+ */
+void Worker_Stop(Worker *worker);
+
+/**
+ * @brief Get a consistent copy of worker statistics.
+ * @param *worker worker to inspect.
+ * @param *stats filled with statistics.
+ */
+void Worker_GetStats(Worker *worker, WorkerStats *stats);
+
+#endif	/* WORKER_H */
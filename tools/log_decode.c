@@ -0,0 +1,378 @@
+/***************************************************************************************************
+ * Copyright (c) 2016, Imagination Technologies Limited and/or its affiliated group companies
+ * and/or licensors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+ *    and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to
+ *    endorse or promote products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file log_decode.c
+ * @brief Host tool that turns a binary button gateway log, written with button_gateway_appd -b,
+ *        back into the text the gateway writes by default.
+ */
+
+/***************************************************************************************************
+ * Includes
+ **************************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "log_format.h"
+
+/***************************************************************************************************
+ * Definitions
+ **************************************************************************************************/
+
+//! @cond Doxygen_Suppress
+#define MAX_PAYLOAD_SIZE	(64 * 1024)
+#define MESSAGE_SIZE		(1024)
+#define NS_PER_SECOND		(1000000000LL)
+//! @endcond
+
+/***************************************************************************************************
+ * Typedef
+ **************************************************************************************************/
+
+/**
+ * A structure to contain the call site a format ID was defined for.
+ */
+typedef struct
+{
+	/*@{*/
+	int line; /**< source line */
+	char *file; /**< source file */
+	char *format; /**< printf format */
+	/*@}*/
+}FormatDefinition;
+
+/**
+ * A structure to contain the decoder state.
+ */
+typedef struct
+{
+	/*@{*/
+	LogBinaryHeader header; /**< file header, in host byte order */
+	bool swap; /**< file was written with the other byte order */
+	bool decorate; /**< write time, file and line of each message */
+	FormatDefinition *formats; /**< definitions indexed by format ID */
+	unsigned int numFormats; /**< entries in formats */
+	/*@}*/
+}Decoder;
+
+/***************************************************************************************************
+ * Globals
+ **************************************************************************************************/
+
+/** Output stream to dump logs, unused by the decoder. */
+FILE *debugStream = NULL;
+/** Debug level for logs, unused by the decoder. */
+int debugLevel = LOG_INFO;
+
+/***************************************************************************************************
+ * Implementation
+ **************************************************************************************************/
+
+/**
+ * @brief Convert a 32 bit value from file byte order.
+ * @param *decoder decoder.
+ * @param value value as read.
+ * @return value in host byte order.
+ */
+static uint32_t Swap32(const Decoder *decoder, uint32_t value)
+{
+	return decoder->swap ? __builtin_bswap32(value) : value;
+}
+
+/**
+ * @brief Convert a 64 bit value from file byte order.
+ * @param *decoder decoder.
+ * @param value value as read.
+ * @return value in host byte order.
+ */
+static uint64_t Swap64(const Decoder *decoder, uint64_t value)
+{
+	return decoder->swap ? __builtin_bswap64(value) : value;
+}
+
+/**
+ * @brief Prints button_gateway_logdecode usage.
+ * @param *program holds application name.
+ */
+static void PrintUsage(const char *program)
+{
+	printf("Usage: %s [options] [binary log file]\n\n"
+			"Reads standard input if no file is given.\n"
+			" -t : Write time, file and line of each message, default is to do so only if\n"
+			"      the gateway logged at debug level.\n"
+			" -h : Print help and exit.\n\n",
+			program);
+}
+
+/**
+ * @brief Read and check the file header.
+ * @param *decoder decoder to fill.
+ * @param *input binary log.
+ * @return true if the file is a binary log this decoder understands, else false.
+ */
+static bool ReadHeader(Decoder *decoder, FILE *input)
+{
+	LogBinaryHeader *header = &decoder->header;
+
+	if (fread(header, sizeof(*header), 1, input) != 1)
+	{
+		fprintf(stderr, "File is too short for a binary log\n");
+		return false;
+	}
+
+	if (header->magic != LOG_BINARY_MAGIC)
+	{
+		if (__builtin_bswap32(header->magic) != LOG_BINARY_MAGIC)
+		{
+			fprintf(stderr, "Not a binary log\n");
+			return false;
+		}
+		decoder->swap = true;
+	}
+
+	header->version = Swap32(decoder, header->version);
+	header->wallNs = Swap64(decoder, header->wallNs);
+	header->monotonicNs = Swap64(decoder, header->monotonicNs);
+	header->debugLevel = Swap32(decoder, header->debugLevel);
+	if (header->version != LOG_BINARY_VERSION)
+	{
+		fprintf(stderr, "Unsupported binary log version %u\n", header->version);
+		return false;
+	}
+
+	decoder->decorate |= (header->debugLevel == LOG_DBG);
+	return true;
+}
+
+/**
+ * @brief Record the call site of a format ID.
+ * @param *decoder decoder.
+ * @param id format ID.
+ * @param *payload line, file and format.
+ * @param length payload length.
+ * @return true if definition was valid, else false.
+ */
+static bool DefineFormat(Decoder *decoder, unsigned int id, const char *payload, size_t length)
+{
+	FormatDefinition *definition;
+	const char *file = payload + sizeof(uint32_t);
+	const char *format;
+	uint32_t line;
+
+	if (length < sizeof(line) + 2 || payload[length - 1] != '\0' ||
+		(format = memchr(file, '\0', length - sizeof(line) - 1)) == NULL)
+	{
+		return false;
+	}
+	format++;
+
+	if (id >= decoder->numFormats)
+	{
+		FormatDefinition *formats = realloc(decoder->formats, (id + 1) * sizeof(*formats));
+
+		if (formats == NULL)
+		{
+			return false;
+		}
+		memset(formats + decoder->numFormats, 0,
+				(id + 1 - decoder->numFormats) * sizeof(*formats));
+		decoder->formats = formats;
+		decoder->numFormats = id + 1;
+	}
+
+	definition = &decoder->formats[id];
+	free(definition->file);
+	free(definition->format);
+	memcpy(&line, payload, sizeof(line));
+	definition->line = Swap32(decoder, line);
+	definition->file = strdup(file);
+	definition->format = strdup(format);
+	return (definition->file != NULL && definition->format != NULL);
+}
+
+/**
+ * @brief Write a message as text.
+ * @param *decoder decoder.
+ * @param *entry entry header.
+ * @param *payload monotonic time and packed arguments.
+ * @param length payload length.
+ * @return true if message was valid, else false.
+ */
+static bool WriteMessage(Decoder *decoder, const LogBinaryEntry *entry, const char *payload,
+		size_t length)
+{
+	const FormatDefinition *definition;
+	char message[MESSAGE_SIZE];
+	LogArguments arguments;
+	uint64_t monotonicNs;
+	int64_t wallNs;
+
+	if (entry->id >= decoder->numFormats || decoder->formats[entry->id].format == NULL ||
+		length < sizeof(monotonicNs) || length - sizeof(monotonicNs) > LOG_ARGS_SIZE)
+	{
+		return false;
+	}
+	definition = &decoder->formats[entry->id];
+
+	memcpy(&monotonicNs, payload, sizeof(monotonicNs));
+	monotonicNs = Swap64(decoder, monotonicNs);
+	wallNs = decoder->header.wallNs + (int64_t)(monotonicNs - decoder->header.monotonicNs);
+
+	arguments.length = length - sizeof(monotonicNs);
+	arguments.truncated = entry->truncated;
+	memcpy(arguments.data, payload + sizeof(monotonicNs), arguments.length);
+	if (decoder->swap)
+	{
+		LogFormat_Swap(definition->format, &arguments);
+	}
+
+	LogFormat_WriteMessage(stdout, decoder->decorate, wallNs / NS_PER_SECOND, definition->file,
+			definition->line, message,
+			LogFormat_Print(definition->format, &arguments, message, sizeof(message)));
+	return true;
+}
+
+/**
+ * @brief Decode every entry of a binary log.
+ * @param *decoder decoder.
+ * @param *input binary log, positioned after the header.
+ * @return true if the whole file was decoded, else false.
+ */
+static bool DecodeEntries(Decoder *decoder, FILE *input)
+{
+	char *payload = malloc(MAX_PAYLOAD_SIZE);
+	LogBinaryEntry entry;
+	bool success = true;
+	uint64_t count;
+
+	if (payload == NULL)
+	{
+		return false;
+	}
+
+	while (fread(&entry, sizeof(entry), 1, input) == 1)
+	{
+		entry.id = Swap32(decoder, entry.id);
+		entry.length = Swap32(decoder, entry.length);
+		if (entry.length > MAX_PAYLOAD_SIZE ||
+			fread(payload, 1, entry.length, input) != entry.length)
+		{
+			fprintf(stderr, "Binary log ends in the middle of an entry\n");
+			success = false;
+			break;
+		}
+
+		switch (entry.type)
+		{
+			case LogEntry_Format:
+				if (!DefineFormat(decoder, entry.id, payload, entry.length))
+				{
+					fprintf(stderr, "Invalid definition of format %u\n", entry.id);
+				}
+				break;
+			case LogEntry_Message:
+				if (!WriteMessage(decoder, &entry, payload, entry.length))
+				{
+					fprintf(stderr, "Invalid message with format %u\n", entry.id);
+				}
+				break;
+			case LogEntry_Drops:
+				if (entry.length == sizeof(count))
+				{
+					memcpy(&count, payload, sizeof(count));
+					printf("\n%llu log messages dropped, log rings full\n",
+							(unsigned long long)Swap64(decoder, count));
+				}
+				break;
+			default:
+				/* Skip entries of newer gateways */
+				break;
+		}
+	}
+
+	free(payload);
+	return success;
+}
+
+/**
+ * @brief Turns a binary log into text on standard output.
+ */
+int main(int argc, char *argv[])
+{
+	Decoder decoder;
+	FILE *input = stdin;
+	bool success;
+	unsigned int i;
+	int opt;
+
+	memset(&decoder, 0, sizeof(decoder));
+	while ((opt = getopt(argc, argv, "th")) != -1)
+	{
+		switch (opt)
+		{
+			case 't':
+				decoder.decorate = true;
+				break;
+			case 'h':
+				PrintUsage(argv[0]);
+				return 0;
+			default:
+				PrintUsage(argv[0]);
+				return -1;
+		}
+	}
+
+	if (optind < argc)
+	{
+		input = fopen(argv[optind], "rb");
+		if (input == NULL)
+		{
+			fprintf(stderr, "Failed to open %s\n", argv[optind]);
+			return -1;
+		}
+	}
+
+	success = ReadHeader(&decoder, input) && DecodeEntries(&decoder, input);
+
+	for (i = 0; i < decoder.numFormats; i++)
+	{
+		free(decoder.formats[i].file);
+		free(decoder.formats[i].format);
+	}
+	free(decoder.formats);
+	if (input != stdin)
+	{
+		fclose(input);
+	}
+	return success ? 0 : -1;
+}